@@ -0,0 +1,21 @@
+#ifndef OMNI_AOT_H
+#define OMNI_AOT_H
+
+#include "compiler.h"
+
+// --- Ahead-of-Time Compilation ---
+// Compiles a program, links its modules into one, optimizes it and
+// writes it out as a native object file whose entry point is `omni_main`.
+// Linking that object with the runtime library (lib/libomniruntime.a,
+// which provides the C `main`) gives a standalone executable, so running
+// a script skips lexing, parsing, IR generation and the JIT entirely.
+#define AOT_RUNTIME_LIB "libomniruntime.a"
+
+// Compiles a program to an object file at `path`. Returns 0 on success.
+int aot_compile_object(AST_Node* ast, const char* path, int opt_level, int time_passes);
+
+// Links an object file from aot_compile_object into an executable with the
+// system C compiler. Returns 0 on success.
+int aot_link_executable(const char* object_path, const char* runtime_lib, const char* path);
+
+#endif // OMNI_AOT_H
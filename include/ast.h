@@ -2,6 +2,7 @@
 #define OMNIKARAI_AST_H
 
 #include "lexer.h"
+#include "shape.h"
 
 // --- FORWARD DECLARATIONS ---
 struct AST_Statement;
@@ -11,6 +12,8 @@ typedef struct AST_Statement_Block AST_Statement_Block; // Forward declaration
 typedef enum {
     // Statements
     SET_STATEMENT,
+    ASSIGN_STATEMENT,     // For `name = value`: rebinds an existing variable, unlike `set`
+    MEMBER_SET_STATEMENT, // For `set obj.property = value`
     RETURN_STATEMENT,
     EXPRESSION_STATEMENT,
     BLOCK_STATEMENT,
@@ -21,10 +24,12 @@ typedef enum {
     FOR_STATEMENT,
     MATCH_STATEMENT,
     MATCH_CASE_STATEMENT,
+    TRY_STATEMENT,
     
     // Expressions
     IDENTIFIER,
     INTEGER_LITERAL,
+    FLOAT_LITERAL,
     STRING_LITERAL,
     BOOLEAN_LITERAL,
     NIL_LITERAL,
@@ -50,19 +55,83 @@ typedef struct AST_Statement {
     Token token; // The primary token of the statement (e.g., TOKEN_SET)
 } AST_Statement;
 
+// The type of an expression's value wherever it is evaluated, as proven by
+// type inference (type_infer.h). STATIC_DYNAMIC means nothing is known.
+typedef enum {
+    STATIC_DYNAMIC,
+    STATIC_INTEGER,
+    STATIC_FLOAT,
+    STATIC_BOOLEAN,
+    STATIC_NIL,
+    STATIC_STRING,
+    STATIC_TYPE_COUNT
+} AST_StaticType;
+
 typedef struct AST_Expression {
     AST_NodeType type;
     Token token; // The primary token of the expression
+    AST_StaticType static_type; // Filled in by infer_types
 } AST_Expression;
 
 
+// --- PROFILES ---
+// Counted by the interpreter as it runs. When a function or loop tiers up,
+// the compiler turns them into LLVM branch weights, which steer block
+// layout and, through block frequencies, the inliner (see tier.h). Compile
+// threads read them while the interpreter keeps counting; a stale count
+// only shifts a weight.
+
+// How often a branch's condition came out truthy and falsy.
+typedef struct {
+    unsigned long long taken;
+    unsigned long long not_taken;
+} BranchProfile;
+
+// How often a call site ran; call sites that never did are compiled cold.
+typedef struct {
+    unsigned long long count;
+} CallProfile;
+
 // --- EXPRESSIONS ---
 
+// Where an identifier lives, as decided by the resolver (resolver.h).
+typedef enum {
+    SCOPE_UNRESOLVED, // Not resolved; looked up dynamically through the environment chain
+    SCOPE_GLOBAL,     // Top-level variable
+    SCOPE_LOCAL,      // Parameter or variable of the enclosing function
+    SCOPE_UPVALUE     // Variable captured from an enclosing function, see AST_Capture
+} AST_Scope;
+
 typedef struct {
     AST_Expression base;
-    char* value;
+    const char* value; // Interned, see intern.h
+    AST_Scope scope;
+    int index;         // SCOPE_UPVALUE: index into the closure's captures
+    // SCOPE_LOCAL read that may come before the local is first assigned
+    // (`set total = total + i`): until then it reads this binding further
+    // out, the global or upvalue `outer_index`. SCOPE_UNRESOLVED otherwise.
+    AST_Scope outer;
+    int outer_index;
 } AST_Expression_Identifier;
 
+// A free variable a function captures from its enclosing function. It is
+// taken from the enclosing function's locals (`from_local`) or forwarded
+// from that function's own captures at `index`.
+typedef struct {
+    const char* name; // Interned
+    int from_local;
+    int index;
+} AST_Capture;
+
+// How a call of a function lays out its variables, decided by the resolver.
+// Unless a closure created during the call captures one of them, nothing
+// refers to the call's environment once it returns, so the interpreter
+// keeps the environment and its variables on the stack (see apply_function).
+typedef struct {
+    int local_count;   // Parameters and names the body declares
+    int locals_escape; // A nested function captures one of them
+} AST_Frame;
+
 typedef struct {
     AST_Expression base;
     long long value;
@@ -70,7 +139,12 @@ typedef struct {
 
 typedef struct {
     AST_Expression base;
-    char* value;
+    double value;
+} AST_Expression_FloatLiteral;
+
+typedef struct {
+    AST_Expression base;
+    const char* value; // Interned, see intern.h
 } AST_Expression_StringLiteral;
 
 typedef struct {
@@ -104,6 +178,7 @@ typedef struct {
     AST_Expression base;
     AST_Expression* left;
     char* operator;
+    int op; // The runtime kernel's OmniBinaryOp, or -1
     AST_Expression* right;
 } AST_Expression_Infix;
 
@@ -118,13 +193,26 @@ typedef struct {
     AST_Expression* function; // Identifier or other expression
     AST_Expression** arguments;
     int argument_count;
+    MethodCache method_cache; // Used when `function` is a member access
+    CallProfile profile;
 } AST_Expression_Call;
 
+// `<object>.<property>`
+typedef struct {
+    AST_Expression base;
+    AST_Expression* object;
+    const char* property; // Interned
+    InlineCache cache;    // Shape -> slot, filled in at runtime
+} AST_Expression_MemberAccess;
+
 typedef struct AST_Expression_FnLiteral {
     AST_Expression base;
     AST_Expression_Identifier** parameters;
     int parameter_count;
     AST_Statement_Block* body;
+    AST_Capture* captures; // Filled in by the resolver
+    int capture_count;
+    AST_Frame frame;       // Filled in by the resolver
 } AST_Expression_FnLiteral;
 
 typedef struct {
@@ -136,12 +224,20 @@ typedef struct {
 // --- STATEMENTS ---
 
 // `set <name> = <value>`
+// Also the node of ASSIGN_STATEMENT.
 typedef struct {
     AST_Statement base;
     AST_Expression_Identifier* name;
     AST_Expression* value;
 } AST_Statement_Set;
 
+// `set <object>.<property> = <value>`
+typedef struct {
+    AST_Statement base;
+    AST_Expression_MemberAccess* target;
+    AST_Expression* value;
+} AST_Statement_MemberSet;
+
 // A block of statements, e.g., an indented block
 typedef struct AST_Statement_Block {
     AST_Statement base;
@@ -156,12 +252,16 @@ typedef struct {
     AST_Expression_Identifier** parameters;
     int parameter_count;
     AST_Statement_Block* body;
+    AST_Capture* captures; // Filled in by the resolver
+    int capture_count;
+    AST_Frame frame;       // Filled in by the resolver
 } AST_Statement_FnDef;
 
-// `class <name>: <block>`
+// `class <name>(<superclass>): <block>`
 typedef struct {
     AST_Statement base;
     AST_Expression_Identifier* name;
+    AST_Expression_Identifier* superclass; // NULL if the class has no parent
     AST_Statement_Block* body;
 } AST_Statement_ClassDef;
 
@@ -171,6 +271,7 @@ typedef struct {
     AST_Expression* condition;
     AST_Statement_Block* consequence;
     AST_Statement* alternative; // Can be another IF_STATEMENT or a BLOCK_STATEMENT
+    BranchProfile profile;
 } AST_Statement_If;
 
 // `while <condition>: <body>`
@@ -178,6 +279,11 @@ typedef struct {
     AST_Statement base;
     AST_Expression* condition;
     AST_Statement_Block* body;
+    BranchProfile profile; // Taken: another iteration
+
+    // On-stack replacement of top-level loops (see tier.h)
+    int backedge_count;
+    struct OsrLoop* osr;
 } AST_Statement_While;
 
 // `for <iterator> in <iterable>: <body>`
@@ -203,6 +309,14 @@ typedef struct {
     int case_count;
 } AST_Statement_Match;
 
+// `try: <body> except Exception as <name>: <handler>`
+typedef struct {
+    AST_Statement base;
+    AST_Statement_Block* body;
+    AST_Expression_Identifier* name; // Bound to the error's message; NULL without `as`
+    AST_Statement_Block* handler;
+} AST_Statement_Try;
+
 // `return <value>`
 typedef struct {
     AST_Statement base;
@@ -221,6 +335,8 @@ typedef struct {
 typedef struct {
     AST_Statement** statements;
     int statement_count;
+    const char** assigned_globals; // Globals functions assign without `set`, filled in by the resolver
+    int assigned_global_count;
 } AST_Program;
 
 
@@ -0,0 +1,21 @@
+#ifndef OMNI_COMPILE_POOL_H
+#define OMNI_COMPILE_POOL_H
+
+// --- Compiler Thread Pool ---
+// Background threads that run compile jobs for the tiered JIT, so the
+// interpreter never waits on LLVM. Jobs run in submission order, as many
+// at a time as there are threads.
+typedef void (*CompileJob)(void* data, int cancelled);
+
+// Starts `thread_count` compiler threads, or when it is 0 one per core
+// (overridden by $OMNI_COMPILE_THREADS). Returns 0 on success.
+int compile_pool_start(int thread_count);
+
+// Queues `job`; it is called with `cancelled` set if the pool stops first.
+// Without running threads the job runs right away, on the caller's thread.
+void compile_pool_submit(CompileJob job, void* data);
+
+// Cancels the jobs that haven't started and waits for the running ones.
+void compile_pool_stop();
+
+#endif // OMNI_COMPILE_POOL_H
@@ -2,10 +2,43 @@
 #define OMNI_COMPILER_H
 
 #include "ast.h"
+#include "omni_runtime.h"
 
 // Forward declare LLVM types to avoid including llvm-c headers in our public header.
 typedef struct LLVMOpaqueModule* LLVMModuleRef;
+typedef struct LLVMOpaqueContext* LLVMContextRef;
 
-LLVMModuleRef compile_to_llvm_ir(AST_Node* ast);
+// The LLVM IR of a program. modules[0] defines `main` and the top-level
+// variables (`omni.global.<name>`); every other module defines exactly one
+// function (`omni.fn.<name>`) and declares whatever it references.
+typedef struct {
+    LLVMModuleRef* modules;
+    int module_count;
+} CompiledProgram;
+
+// Returns NULL if the program uses something the compiler can't lower yet.
+CompiledProgram* compile_to_llvm_ir(AST_Node* ast, LLVMContextRef context);
+// Compiles a single function for the tiered interpreter into one module
+// defining `<symbol>` and `i32 <symbol>.entry(OmniValue* args, OmniValue* result)`,
+// which returns a TierExit. The body is specialized for `guard_types` (one per
+// parameter, or NULL), which the entry guards.
+// Globals and calls are routed back through the interpreter (see tier.h).
+// Returns NULL, without reporting errors, if the function can't be compiled.
+CompiledProgram* compile_function_to_llvm_ir(const char* symbol, AST_Expression_Identifier** parameters,
+                                             int parameter_count, AST_Statement_Block* body,
+                                             const OmniType* guard_types, LLVMContextRef context);
+// Compiles a top-level loop for on-stack replacement into one module defining
+// `i32 <symbol>(OmniValue* values, OsrFrame* frame)`, which runs the loop on the
+// variables in `values` (in the order of `names`) and returns a TierExit.
+// The loop deoptimizes at its header when a variable's type is no longer
+// its entry in `guard_types`. Returns NULL, without reporting errors, if the
+// loop can't be compiled.
+CompiledProgram* compile_loop_to_llvm_ir(const char* symbol, AST_Statement_While* loop, const char** names,
+                                         const OmniType* guard_types, int count, LLVMContextRef context);
+// With a source path, everything compiled afterwards carries DWARF line
+// info pointing into that file (-g); NULL turns it off again.
+void compiler_set_debug_source(const char* source_path);
+// Disposes the modules that are still owned by the program (not set to NULL).
+void compiled_program_dispose(CompiledProgram* program);
 
 #endif // OMNI_COMPILER_H
\ No newline at end of file
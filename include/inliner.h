@@ -0,0 +1,30 @@
+#ifndef OMNIKARAI_INLINER_H
+#define OMNIKARAI_INLINER_H
+
+#include "ast.h"
+
+// --- Function Inlining ---
+// Replaces calls to small helper functions with their bodies before the
+// program runs, so the interpreter skips the environment, argument array
+// and return wrapper of the call, and type inference and the compilers see
+// straight through it.
+//
+// A function is inlined if it is defined once at the top level (`fn f(...)`
+// or `set f = fn(...)`), is never rebound, is only ever called directly by
+// name, and its body is a single `return <expression>` that doesn't call
+// the function itself. The expression may have up to INLINE_SIZE_LIMIT
+// nodes, or INLINE_HOT_SIZE_LIMIT at call sites inside loops.
+//
+// Parameters are replaced by the arguments. Calls are left alone wherever
+// that could change what the program does: where an argument with effects
+// would be dropped, duplicated or reordered, or where a name the body uses
+// would resolve to a variable of the calling function instead.
+#define INLINE_SIZE_LIMIT 8
+#define INLINE_HOT_SIZE_LIMIT 24
+#define INLINE_MAX_DEPTH 4 // Helpers exposed by inlining another one
+
+// Inlines in place (running resolve_program on it) and returns the number
+// of call sites that were replaced.
+int inline_program(AST_Program* program);
+
+#endif //OMNIKARAI_INLINER_H
@@ -0,0 +1,32 @@
+#ifndef OMNIKARAI_INTERN_H
+#define OMNIKARAI_INTERN_H
+
+#include <stddef.h>
+
+// --- String Interning ---
+// Every distinct string is stored exactly once. The returned pointer is the
+// handle: two interned strings are equal if and only if their pointers are
+// equal, so hot paths (environment lookup, symbol tables, string equality)
+// compare with `==` instead of `strcmp`. The handle is also a normal
+// NUL-terminated C string and must never be modified or freed.
+//
+// The interner is global and safe to use from multiple threads.
+
+// Returns the canonical copy of `str`. Strong entries live for the rest of
+// the process; use them for identifiers and literals owned by the AST.
+const char* intern(const char* str);
+const char* intern_n(const char* str, size_t length);
+
+// Like `intern`, but takes a reference on the entry instead of pinning it,
+// for strings built while a program runs (by `+`). A weak entry is
+// reclaimed once every reference has been dropped with `intern_release`.
+// Interning the same string strongly pins it for good.
+const char* intern_weak(const char* str);
+const char* intern_weak_n(const char* str, size_t length);
+void intern_release(const char* interned);
+
+// Precomputed metadata, available without touching the characters.
+unsigned int intern_hash(const char* interned);
+size_t intern_length(const char* interned);
+
+#endif //OMNIKARAI_INTERN_H
@@ -12,7 +12,8 @@ Object* interpret(AST_Program* program);
 void print_object(Object* obj);
 
 Environment* new_environment();
-Object* get_environment(Environment* env, char* name);
-void set_environment(Environment* env, char* name, Object* val);
+// `name` must be interned (see intern.h); lookups compare pointers.
+Object* get_environment(Environment* env, const char* name);
+void set_environment(Environment* env, const char* name, Object* val);
 
 #endif //OMNIKARAI_INTERPRETER_H
@@ -0,0 +1,173 @@
+#ifndef OMNIKARAI_IR_H
+#define OMNIKARAI_IR_H
+
+#include <stdio.h>
+#include "ast.h"
+#include "omni_runtime.h"
+#include "compiler.h"
+
+// --- Experimental SSA IR (-ir) ---
+// A typed, SSA-form IR with a pipeline of its own, used only when asked
+// for with -ir:
+//
+//     AST_Program --ir_lower_program--> IRProgram --ir_optimize--> IRProgram
+//         --> ir_compile_to_llvm (-ir -jit, ir_llvm.c)
+//         --> ir_compile_bytecode + ir_execute (-ir, register VM, ir_vm.c)
+//
+// It sits beside the engines, not between the AST and them: the
+// interpreter, the tiers, the default -jit path and ahead-of-time
+// compilation never see it, and take their optimizations from the AST
+// (partial_eval.h, inliner.h, type_infer.h) and LLVM (optimizer.h). A pass
+// written here only helps -ir runs. Programs using closures, classes, try
+// or other constructs the lowering doesn't know yet are refused and run
+// the usual way instead.
+//
+// Every instruction defines at most one value, named by its index in the
+// function's instruction table. Values are either boxed (`IR_VALUE`, an
+// OmniValue) or unboxed machine values; IR_BOX and IR_UNBOX convert
+// explicitly, so passes can see and remove the conversions. Unboxed
+// values only appear where type inference (type_infer.h) proved the type.
+//
+// Local variables of functions are renamed into SSA values on the fly
+// while lowering (Braun et al., "Simple and Efficient Construction of
+// Static Single Assignment Form"); top-level variables stay in memory
+// (IR_GLOBAL_GET/SET) since every function can see them.
+
+typedef enum {
+    IR_VALUE, // Boxed OmniValue
+    IR_INT,   // long long
+    IR_FLOAT, // double
+    IR_BOOL,  // 0 or 1
+} IRType;
+
+typedef enum {
+    IR_CONST,        // `constant`, in the representation of `type`
+    IR_PARAM,        // Parameter `index`
+    IR_PHI,          // One argument per predecessor of the block, in order
+    IR_BOX,          // Unboxed -> IR_VALUE
+    IR_UNBOX,        // IR_VALUE -> `type`; the value is known to have that type
+    IR_TRUTHY,       // IR_VALUE -> IR_BOOL
+    IR_INT_TO_FLOAT, // IR_INT -> IR_FLOAT
+    IR_BINARY,       // `binary` on two INT, FLOAT (results INT/FLOAT/BOOL) or VALUE operands
+    IR_NEG,
+    IR_NOT,          // IR_BOOL -> IR_BOOL
+    IR_GLOBAL_GET,   // Top-level variable `name`
+    IR_GLOBAL_SET,   // Top-level variable `name` = arg 0
+    IR_CALL,         // Top-level function `name` on boxed args
+    IR_PRINT,        // The `print` builtin; evaluates to nil
+    // Terminators, last in every block
+    IR_JUMP,         // To targets[0]
+    IR_BRANCH,       // On IR_BOOL arg 0, to targets[0] (true) or targets[1]
+    IR_RETURN,       // Arg 0
+} IROp;
+
+// The runtime's operators (see omni_runtime.h), so both share one kernel.
+typedef enum {
+    IR_ADD = OMNI_OP_ADD, IR_SUB = OMNI_OP_SUBTRACT, IR_MUL = OMNI_OP_MULTIPLY, IR_DIV = OMNI_OP_DIVIDE,
+    IR_EQ = OMNI_OP_EQUAL, IR_NE = OMNI_OP_NOT_EQUAL, IR_LT = OMNI_OP_LESS, IR_GT = OMNI_OP_GREATER,
+    IR_LE = OMNI_OP_LESS_EQUAL, IR_GE = OMNI_OP_GREATER_EQUAL,
+} IRBinaryOp;
+
+typedef struct {
+    IROp op;
+    IRType type;
+    int block;          // Owning block; -1 once removed
+    int* args;          // Value operands
+    int arg_count;
+    int targets[2];     // IR_JUMP, IR_BRANCH
+    IRBinaryOp binary;  // IR_BINARY
+    const char* name;   // IR_GLOBAL_GET/SET, IR_CALL (interned)
+    int index;          // IR_PARAM
+    OmniValue constant; // IR_CONST
+} IRInstr;
+
+typedef struct {
+    int* instrs;        // Phis first, terminator last
+    int instr_count;
+    int instr_capacity;
+    int* preds;
+    int pred_count;
+    int sealed;         // All predecessors are known (SSA construction)
+} IRBlock;
+
+typedef struct {
+    const char* name;   // Interned; NULL for the top-level code
+    int parameter_count;
+    IRInstr* instrs;    // Indexed by value
+    int instr_count;
+    int instr_capacity;
+    IRBlock* blocks;    // blocks[0] is the entry
+    int block_count;
+    int block_capacity;
+} IRFunction;
+
+// Interned names -> indices, open addressed like SymbolTable (see
+// symbol_table.h), so finding a global or function by name takes the same
+// time however many a program has.
+typedef struct {
+    const char** names; // NULL in empty slots
+    int* indices;
+    int capacity;       // A power of two, or 0 before the first name
+    int count;
+} IRNameIndex;
+
+// -1 if `name` isn't in the index.
+int ir_name_index_get(const IRNameIndex* index, const char* name);
+void ir_name_index_set(IRNameIndex* index, const char* name, int value);
+void ir_name_index_free(IRNameIndex* index);
+
+typedef struct {
+    IRFunction* main;        // Top-level code; returns the last expression's value
+    IRFunction** functions;  // Top-level functions
+    int function_count;
+    const char** globals;    // Top-level variables (interned)
+    int global_count;
+    IRNameIndex function_indices; // Name -> index into `functions`
+    IRNameIndex global_indices;   // Name -> index into `globals`
+} IRProgram;
+
+// Lowers a parsed program (resolve_program and infer_types are run on it).
+// Returns NULL, after printing why, if the program uses something the IR
+// can't express yet: classes, closures, collections, `for` and `match`.
+IRProgram* ir_lower_program(AST_Program* program);
+void ir_program_free(IRProgram* program);
+
+// Runs the optimization pipeline (ir_opt.c) on every function.
+void ir_optimize(IRProgram* program);
+
+void ir_print_program(IRProgram* program, FILE* out);
+
+// Emits LLVM IR laid out like compile_to_llvm_ir's (see compiler.h), so it
+// goes through jit_add_program the same way. Returns NULL on failure.
+CompiledProgram* ir_compile_to_llvm(IRProgram* program, LLVMContextRef context);
+
+// --- Register VM (ir_vm.c) ---
+// The IR flattened into bytecode for a register machine: every IR value
+// gets a register, phis become moves on the incoming edges, and boxed
+// operations call the same runtime functions compiled code does.
+typedef struct IRBytecode IRBytecode;
+
+IRBytecode* ir_compile_bytecode(IRProgram* program);
+// Runs the top-level code and returns its value.
+OmniValue ir_execute(IRBytecode* code);
+void ir_bytecode_free(IRBytecode* code);
+
+// --- Construction and Editing (used by the lowering and the passes) ---
+
+int ir_add_block(IRFunction* fn);
+// Appends an instruction to `block` and returns its value.
+int ir_append(IRFunction* fn, int block, IROp op, IRType type, const int* args, int arg_count);
+// Inserts an instruction at `position` within `block` and returns its value.
+int ir_insert(IRFunction* fn, int block, int position, IROp op, IRType type, const int* args, int arg_count);
+void ir_add_pred(IRFunction* fn, int block, int pred);
+void ir_remove_instr(IRFunction* fn, int value);
+// Makes every instruction that used `value` use `replacement` instead.
+void ir_replace_uses(IRFunction* fn, int value, int replacement);
+int ir_terminator(IRFunction* fn, int block);
+int ir_is_terminator(IROp op);
+// Fills `order` with the reachable blocks, each after all of its dominators,
+// and returns how many there are.
+int ir_reverse_postorder(IRFunction* fn, int* order);
+const char* ir_binary_name(IRBinaryOp op);
+
+#endif //OMNIKARAI_IR_H
@@ -0,0 +1,47 @@
+#ifndef OMNI_JIT_CACHE_H
+#define OMNI_JIT_CACHE_H
+
+#include <stddef.h>
+
+// Forward declare LLVM types to avoid including llvm-c headers in our public header.
+typedef struct LLVMOpaqueModule* LLVMModuleRef;
+typedef struct LLVMOpaqueMemoryBuffer* LLVMMemoryBufferRef;
+
+// --- Persistent JIT Object Cache ---
+// The JIT stores the object code it generates for every module in a cache
+// directory, one `<key>.o` file per module. The key hashes the module's IR
+// together with everything else that shapes its machine code: the
+// optimization level, the host CPU and its features, the compiler and
+// LLVM versions, and the runtime bitcode inlined into every module. A
+// later run that produces the same IR loads the object directly and skips
+// optimization and code generation.
+//
+// The directory is bounded in size: hits refresh a file's modification
+// time and, after every store, the least recently used files are evicted
+// until the total fits again.
+#define OMNI_VERSION "0.1.0"
+#define JIT_CACHE_KEY_SIZE 33 // 128-bit hash in hex, NUL-terminated
+#define JIT_CACHE_DEFAULT_LIMIT (64LL * 1024 * 1024)
+
+typedef struct JitCache JitCache;
+
+// Opens (creating it if needed) the cache in `directory`, or when NULL in
+// $OMNI_JIT_CACHE_DIR, else $XDG_CACHE_HOME/omnikarai, else
+// ~/.cache/omnikarai. $OMNI_JIT_CACHE_MB overrides the size limit.
+// Returns NULL if no usable directory could be found.
+JitCache* jit_cache_open(const char* directory, int opt_level);
+void jit_cache_close(JitCache* cache);
+
+// Computes the key of `module` as it is before optimization.
+void jit_cache_key(JitCache* cache, LLVMModuleRef module, char key[JIT_CACHE_KEY_SIZE]);
+
+// The cached object for `key`, or NULL on a miss. The caller owns the buffer.
+LLVMMemoryBufferRef jit_cache_load(JitCache* cache, const char* key);
+
+// Stores an object under `key` and evicts old entries beyond the size limit.
+void jit_cache_store(JitCache* cache, const char* key, const char* data, size_t size);
+
+// Prints the hit/miss counts (with --time-passes).
+void jit_cache_print_stats(JitCache* cache);
+
+#endif // OMNI_JIT_CACHE_H
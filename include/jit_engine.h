@@ -1,11 +1,53 @@
 #ifndef OMNI_JIT_ENGINE_H
 #define OMNI_JIT_ENGINE_H
 
-#include <llvm-c/ExecutionEngine.h>
+#include "compiler.h"
+
+// Forward declare LLVM types to avoid including llvm-c headers in our public header.
+typedef struct LLVMOrcOpaqueThreadSafeContext* LLVMOrcThreadSafeContextRef;
+
+// --- ORC JIT ---
+// Programs run on an ORC LLJIT instance. Every Omnikarai function is added
+// behind a lazy reexport: calls go through a stub that compiles (and
+// optimizes) the function the first time it is called, so only code that
+// actually runs is ever compiled.
+typedef struct OmniJIT OmniJIT;
 
 void jit_init();
 void jit_shutdown();
-LLVMExecutionEngineRef jit_create_engine(LLVMModuleRef module);
-int jit_run_main(LLVMExecutionEngineRef engine);
+
+// Makes JIT code visible to `perf`, for JITs created afterwards: `perf_map`
+// writes /tmp/perf-<pid>.map, `jitdump` a jit-<pid>.dump (with the line
+// info of programs compiled with -g) for `perf record -k 1` and
+// `perf inject --jit`.
+void jit_set_profiling(int perf_map, int jitdump);
+
+OmniJIT* jit_create(int opt_level, int time_passes);
+void jit_dispose(OmniJIT* jit);
+
+// Caches generated object code on disk (see jit_cache.h) in `directory`,
+// or the default cache directory when NULL. Modules added afterwards whose
+// IR was compiled before are loaded from the cache instead.
+void jit_use_cache(OmniJIT* jit, const char* directory);
+
+// The context programs added to this JIT must be compiled in.
+LLVMContextRef jit_get_context(OmniJIT* jit);
+
+// Transfers ownership of the program's modules to the JIT. Returns 0 on success.
+int jit_add_program(OmniJIT* jit, CompiledProgram* program);
+
+// Adds one module, compiled (eagerly) on the first lookup of any of its symbols.
+int jit_add_module(OmniJIT* jit, LLVMModuleRef module);
+
+// Same, for a module compiled in its own context rather than jit_get_context's,
+// so it can be generated and compiled on another thread. Every thread may
+// add and look up symbols concurrently.
+int jit_add_module_in_context(OmniJIT* jit, LLVMModuleRef module, LLVMOrcThreadSafeContextRef context);
+
+// Returns the address of `symbol`, compiling it if needed; NULL if it can't be found.
+void* jit_lookup(OmniJIT* jit, const char* symbol);
+
+// Calls the program's `main` through a native function pointer.
+long long jit_run_main(OmniJIT* jit);
 
 #endif // OMNI_JIT_ENGINE_H
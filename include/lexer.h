@@ -15,6 +15,7 @@ typedef enum {
     // IDENTIFIERS + LITERALS
     TOKEN_IDENT,   // my_variable, myFunction
     TOKEN_INT,     // 12345
+    TOKEN_FLOAT,   // 3.14
     TOKEN_STRING,  // "hello world"
 
     // OPERATORS
@@ -41,6 +42,7 @@ typedef enum {
     TOKEN_LBRACE,    // {
     TOKEN_RBRACE,    // }
     TOKEN_SEMICOLON, // ;
+    TOKEN_DOT,       // .
 
     // KEYWORDS
     TOKEN_SET,       // set
@@ -57,6 +59,8 @@ typedef enum {
     TOKEN_AS,        // as
     TOKEN_MATCH,     // match
     TOKEN_CASE,      // case
+    TOKEN_TRY,       // try
+    TOKEN_EXCEPT,    // except
     TOKEN_TRUE,      // true
     TOKEN_FALSE,     // false
     TOKEN_NIL,       // nil (like None)
@@ -66,6 +70,7 @@ typedef enum {
 typedef struct {
     TokenType type;
     char *literal; // The actual characters of the token (e.g., "let", "my_variable", "5")
+    int line;      // Source line, for debug info
 } Token;
 
 // Lexer state
@@ -1,37 +1,115 @@
 #ifndef OMNIKARAI_OBJECT_H
 #define OMNIKARAI_OBJECT_H
 
+#include <stddef.h>
+
 #include "ast.h" // Include ast.h for AST_Expression_Identifier and AST_Statement_Block definitions
+#include "shape.h"
+#include "tier.h"
+#include "omni_runtime.h"
 
 // Forward declarations for types defined in other headers to break circular dependencies
 typedef struct Environment Environment;
+typedef struct EnvEntry EnvEntry;
 
 // --- Object System ---
+// Scalars share their tags and layout with OmniValue, so the start of a
+// scalar Object is an OmniValue (see object_value): the interpreter passes
+// it to the runtime's kernels and to compiled code without converting it.
 typedef enum {
-    OBJ_INTEGER,
-    OBJ_BOOLEAN,
-    OBJ_NIL,
-    OBJ_RETURN_VALUE,
-    OBJ_STRING,
+    OBJ_INTEGER = OMNI_INTEGER,
+    OBJ_FLOAT = OMNI_FLOAT,
+    OBJ_BOOLEAN = OMNI_BOOLEAN,
+    OBJ_NIL = OMNI_NIL,
+    OBJ_STRING = OMNI_STRING,
+    OBJ_RETURN_VALUE = OMNI_TYPE_COUNT, // Everything from here on is a heap object (OMNI_OBJECT to compiled code)
     OBJ_FUNCTION,
+    OBJ_CLASS,
+    OBJ_INSTANCE,
+    OBJ_BOUND_METHOD,
+    OBJ_BUILTIN,
 } ObjectType;
 
+struct Object;
+
+// A function implemented in C, such as `print`.
+typedef struct Object* (*BuiltinFunction)(struct Object** args, int arg_count);
+
 typedef struct ObjectFunction {
+    const char* name; // Interned; NULL for an anonymous function
     AST_Expression_Identifier** parameters;
     int parameter_count;
     AST_Statement_Block* body;
-    Environment* env;
+    Environment* globals; // Top-level environment the function was defined in
+    EnvEntry** upvalues;  // Shared boxes of the captured variables, in AST_Capture order
+    int upvalue_count;
+    AST_Frame frame;
+
+    // Tiered execution (see tier.h)
+    int call_count;
+    int backedge_count;
+    int deopt_count;
+    TierState tier;
+    TierEntry native; // Set once compiled
+    TierTicket* ticket; // The background compile while TIER_COMPILING
 } ObjectFunction;
 
+// A method or class-level attribute declared in a class body.
+typedef struct ClassMember {
+    const char* name; // Interned
+    struct Object* value;
+} ClassMember;
+
+typedef struct ObjectClass {
+    const char* name; // Interned
+    struct ObjectClass* superclass;
+    Shape* root_shape; // Every instance of this class starts here
+    ClassMember* members;
+    int member_count;
+} ObjectClass;
+
+// Fields live inline in `slots`, at the offsets given by `shape`.
+typedef struct ObjectInstance {
+    ObjectClass* klass;
+    Shape* shape;
+    int slot_capacity;
+    struct Object* slots[];
+} ObjectInstance;
+
+// `obj.method` read as a value: the receiver is passed as `self` on call.
+typedef struct ObjectBoundMethod {
+    struct Object* receiver;
+    struct Object* method;
+} ObjectBoundMethod;
+
 typedef struct Object {
     ObjectType type;
     union {
         long long integer;
+        double floating; // Stored inline, never boxed separately
         int boolean;
-        char* string;
+        const char* string; // Interned; weakly for strings built by `+`
         ObjectFunction* function;
+        ObjectClass* klass;
+        ObjectInstance* instance;
+        ObjectBoundMethod* bound_method;
+        BuiltinFunction builtin;
         struct Object* return_value; // For OBJ_RETURN_VALUE
     } value;
 } Object;
 
+// Fails to compile if the layouts drift apart.
+typedef char object_value_layout_check[(sizeof(ObjectType) == sizeof(OmniType) &&
+                                        offsetof(Object, value) == offsetof(OmniValue, value) &&
+                                        sizeof(((Object*)0)->value) == sizeof(((OmniValue*)0)->value)) ? 1 : -1];
+
+static inline int object_is_scalar(const Object* obj) {
+    return obj->type <= OBJ_STRING;
+}
+
+// A scalar Object read as the value it holds. Valid only if object_is_scalar().
+static inline const OmniValue* object_value(const Object* obj) {
+    return (const OmniValue*)obj;
+}
+
 #endif //OMNIKARAI_OBJECT_H
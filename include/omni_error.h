@@ -0,0 +1,46 @@
+#ifndef OMNIKARAI_OMNI_ERROR_H
+#define OMNIKARAI_OMNI_ERROR_H
+
+#include <setjmp.h>
+
+#include "omni_runtime.h"
+
+// --- Runtime Errors ---
+// Errors are raised with omni_raise and caught by `try`. Nothing is checked
+// or registered while code runs normally: raising walks the stack with the
+// system unwinder, which finds frames through the unwind tables the C
+// compiler and LLVM emit, runs the landing pads of compiled `try` blocks on
+// the way, and stops at the innermost interpreter handler. An error nobody
+// catches prints "Runtime Error: <message>" and exits with status 1.
+//
+// An interpreter handler lives in the frame of the `try` that pushed it, so
+// the unwinder knows it has got there once it reaches that frame:
+//
+//     OmniHandler handler;
+//     if (OMNI_TRY(&handler)) {
+//         ... // May raise
+//         omni_try_end(&handler);
+//     } else {
+//         ... // omni_error_message() says what went wrong
+//     }
+//
+// This lives apart from omni_runtime.c, whose bitcode the JIT links into
+// its modules, so there's only ever one handler stack.
+
+typedef struct OmniHandler {
+    jmp_buf target;
+    struct OmniHandler* previous;
+} OmniHandler;
+
+#define OMNI_TRY(handler) (omni_try_begin(handler), setjmp((handler)->target) == 0)
+void omni_try_begin(OmniHandler* handler);
+void omni_try_end(OmniHandler* handler);
+
+void omni_raise(const char* format, ...) __attribute__((noreturn, format(printf, 1, 2)));
+
+// The message of the error being handled; interned.
+const char* omni_error_message(void);
+// The same message as a string value, for the landing pads of compiled code.
+OmniValue omni_caught(void);
+
+#endif //OMNIKARAI_OMNI_ERROR_H
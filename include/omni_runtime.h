@@ -6,19 +6,28 @@
 
 typedef enum {
     OMNI_INTEGER,
+    OMNI_FLOAT,
     OMNI_BOOLEAN,
     OMNI_NIL,
     OMNI_STRING,
+    OMNI_OBJECT, // Opaque interpreter Object passed through tiered code (see tier.h)
     // OMNI_FUNCTION, // Functions will likely be compiled to C functions directly
     // OMNI_RETURN_VALUE, // Handled by C return mechanism
 } OmniType;
 
+#define OMNI_TYPE_COUNT (OMNI_OBJECT + 1)
+
+// The one value representation: compiled code passes it by value as
+// { i32, i64 }, and the interpreter's scalar Objects start with the same
+// tag and payload (see object.h), so both read each other's values in place.
 typedef struct OmniValue {
     OmniType type;
     union {
         long long integer;
+        double floating;
         int boolean;
-        char* string;
+        const char* string; // Interned; weakly for strings built by `+`
+        void* object;       // OMNI_OBJECT
         // More types as needed
     } value;
 } OmniValue;
@@ -26,18 +35,52 @@ typedef struct OmniValue {
 // --- Runtime Functions ---
 // For example, a print function that can handle different OmniValue types
 void omni_print(OmniValue val);
+void omni_print_values(const OmniValue* values, int count);
 
 // Functions to create OmniValue objects
 OmniValue omni_new_integer(long long val);
+OmniValue omni_new_float(double val);
 OmniValue omni_new_boolean(int val);
 OmniValue omni_new_nil();
 OmniValue omni_new_string(const char* val);
 
-// Basic binary operations (example for integers)
+// --- Operation Kernels ---
+// The single implementation of the language's operators, called by the
+// interpreter, the IR VM and optimizer, compile-time evaluation and, through
+// the wrappers below, compiled code. Each pair of operand types is looked up
+// in one table that decides how the operator treats it.
+typedef enum {
+    OMNI_OP_ADD, OMNI_OP_SUBTRACT, OMNI_OP_MULTIPLY, OMNI_OP_DIVIDE,
+    OMNI_OP_EQUAL, OMNI_OP_NOT_EQUAL, OMNI_OP_LESS, OMNI_OP_GREATER, OMNI_OP_LESS_EQUAL, OMNI_OP_GREATER_EQUAL,
+    OMNI_OP_COUNT
+} OmniBinaryOp;
+
+typedef enum {
+    OMNI_OK,
+    OMNI_UNSUPPORTED_TYPES,
+    OMNI_DIVISION_BY_ZERO
+} OmniStatus;
+
+// Stores the result of `left <op> right` in `result` unless it fails.
+// Integer arithmetic wraps.
+OmniStatus omni_binary(OmniBinaryOp op, OmniValue left, OmniValue right, OmniValue* result);
+OmniStatus omni_unary_minus(OmniValue value, OmniValue* result);
+
+// The operator spelled `symbol` in source code, or -1.
+int omni_binary_op_named(const char* symbol);
+// What each operator is called in error messages, e.g. "addition".
+extern const char* const omni_binary_op_names[OMNI_OP_COUNT];
+// Raises a failed `operation` as a runtime error (see omni_error.h).
+void omni_fail(OmniStatus status, const char* operation) __attribute__((noreturn));
+// Raises the error for reading `name`, which nothing defines.
+void omni_undefined(const char* name) __attribute__((noreturn));
+
+// Kernels for compiled code, which report failures themselves.
 OmniValue omni_add(OmniValue left, OmniValue right);
 OmniValue omni_subtract(OmniValue left, OmniValue right);
 OmniValue omni_multiply(OmniValue left, OmniValue right);
 OmniValue omni_divide(OmniValue left, OmniValue right);
+OmniValue omni_negate(OmniValue val);
 
 // Comparison operations
 OmniValue omni_equal(OmniValue left, OmniValue right);
@@ -49,5 +92,6 @@ OmniValue omni_greater_than_equal(OmniValue left, OmniValue right);
 
 // Helper for truthiness
 int omni_is_truthy(OmniValue val);
+long long omni_as_integer(OmniValue val);
 
 #endif //OMNIKARAI_OMNI_RUNTIME_H
@@ -0,0 +1,23 @@
+#ifndef OMNI_OPTIMIZER_H
+#define OMNI_OPTIMIZER_H
+
+// Forward declare LLVM types to avoid including llvm-c headers in our public header.
+typedef struct LLVMOpaqueModule* LLVMModuleRef;
+typedef struct LLVMOpaqueTargetMachine* LLVMTargetMachineRef;
+
+#define OPT_LEVEL_DEFAULT 2
+
+// Runs LLVM's standard `default<O0>`..`default<O3>` pipeline over the module,
+// tuned for the host CPU: mem2reg/SROA, instcombine, inlining, GVN, LICM,
+// loop unrolling and vectorization at -O2 and above. With `time_passes` set,
+// LLVM prints a per-pass timing report and we print the total wall time.
+// Returns 0 on success.
+int optimize_module(LLVMModuleRef module, int opt_level, int time_passes);
+
+// A TargetMachine for the host CPU generating code at `opt_level`, or NULL
+// if the host isn't supported. Shared by the pass pipeline and the JIT.
+LLVMTargetMachineRef create_host_target_machine(int opt_level);
+// Same, but generating position-independent code for object files (see aot.h).
+LLVMTargetMachineRef create_object_target_machine(int opt_level);
+
+#endif // OMNI_OPTIMIZER_H
@@ -0,0 +1,32 @@
+#ifndef OMNIKARAI_PARTIAL_EVAL_H
+#define OMNIKARAI_PARTIAL_EVAL_H
+
+#include "ast.h"
+
+// --- Compile-Time Evaluation ---
+// Runs calls to pure functions on constant arguments before the program
+// starts and replaces each with the literal it returns, so tables and
+// configuration constants computed at the top level cost nothing at run
+// time, and type inference and the compilers see constants.
+//
+// A function is pure if it is defined once at the top level, and its body
+// only does arithmetic, comparisons, `set`, `if`, `while` and `return` on
+// its own parameters and locals, and calls pure functions. A local read
+// before it is assigned reads a global (see resolver.h), which must be set
+// once to a literal or not at all. It can't reach `print`, other globals,
+// objects or closures, so running it has no effect other than its result.
+//
+// Calls run in a sandbox that follows the interpreter's rules exactly.
+// Anything that would fail at run time (an error, a result that isn't an
+// integer, float, boolean, nil or string, running out of the step budget
+// or the recursion limit) leaves the call in place, to fail or loop as
+// it would have.
+#define PARTIAL_EVAL_STEP_BUDGET 1000000 // Per call site
+#define PARTIAL_EVAL_TOTAL_BUDGET 20000000 // Per program, bounding compile time
+#define PARTIAL_EVAL_MAX_DEPTH 256
+
+// Evaluates in place (running resolve_program on it) and returns the
+// number of calls that were replaced.
+int partial_evaluate(AST_Program* program);
+
+#endif //OMNIKARAI_PARTIAL_EVAL_H
@@ -0,0 +1,31 @@
+#ifndef OMNIKARAI_RESOLVER_H
+#define OMNIKARAI_RESOLVER_H
+
+#include "ast.h"
+
+// --- Capture Analysis ---
+// Walks the program once and decides, for every identifier, whether it is
+// a global, a local of the enclosing function or a captured variable, and
+// records on each function exactly which free variables it captures.
+//
+// A name is local to a function if the function declares it anywhere in
+// its body (parameter, `set`, `fn`, `class`, `for` target or `except` name), even before
+// the declaration, which matches how `set` always writes the current scope.
+// Assignment without `set` (`x = x + 1`) declares nothing: it rebinds the
+// local, captured variable or global the name already refers to. Until
+// the function first assigns a local, reading it reads the binding further
+// out, so `set total = total + i` starts from an enclosing `total`, and
+// with nothing further out it is an "Identifier not found" error. Reads the
+// walk can't prove come after an assignment on every path are marked so
+// each mode checks at run time.
+void resolve_program(AST_Program* program);
+
+// Whether `stmt` declares `name` in the scope it runs in, by the rules
+// above, or assigns it without `set`. Nested functions are not entered.
+int statement_binds(AST_Statement* stmt, const char* name);
+
+// Whether a function assigns the global `name` without `set`, so any call
+// may change it. Known once the program is resolved.
+int function_assigns_global(AST_Program* program, const char* name);
+
+#endif //OMNIKARAI_RESOLVER_H
@@ -0,0 +1,29 @@
+#ifndef OMNI_RUNTIME_INLINE_H
+#define OMNI_RUNTIME_INLINE_H
+
+#include <stddef.h>
+
+// Forward declare LLVM types to avoid including llvm-c headers in our public header.
+typedef struct LLVMOpaqueModule* LLVMModuleRef;
+
+// --- Runtime Bitcode ---
+// The build compiles src/omni_runtime.c to LLVM bitcode with clang and
+// embeds it in omnicc (src/runtime_bitcode.S). Linking it into a module
+// before optimization turns calls to `omni_add`, `omni_equal`, ... from
+// opaque external calls into code LLVM can inline, so the type dispatch
+// inside the helpers folds away wherever the operand types are known.
+//
+// The runtime is linked in with internal linkage, the compiler's
+// declarations become small adapters from its `%OmniValue` signatures to
+// the C ABI ones clang emits, and whatever isn't inlined still resolves
+// to the process's own copy. Without clang at build time the embedded
+// bitcode is empty and modules are left untouched.
+
+// The embedded bitcode; empty when the build had no clang.
+const char* runtime_bitcode(size_t* size);
+
+// Links the runtime into `module`. Returns 0 on success, including when
+// there's nothing to link.
+int link_runtime_bitcode(LLVMModuleRef module);
+
+#endif // OMNI_RUNTIME_INLINE_H
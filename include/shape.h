@@ -0,0 +1,79 @@
+#ifndef OMNIKARAI_SHAPE_H
+#define OMNIKARAI_SHAPE_H
+
+// --- Shapes (Hidden Classes) ---
+// A shape describes the layout of an instance: which properties it has and
+// the slot each one lives in. Instances that receive the same properties in
+// the same order share a shape, so a property's slot can be cached per
+// shape instead of being looked up by name on every access.
+//
+// Shapes form a transition tree: adding property `p` to an instance of shape
+// S moves it to the child of S labelled `p`, creating that child only the
+// first time the transition is taken.
+typedef struct Shape {
+    struct Shape* parent;
+    const char* property; // Interned name added by the transition from parent; NULL for a root
+    int slot_count;       // Number of slots an instance of this shape uses
+
+    struct Shape** transitions;
+    int transition_count;
+    int transition_capacity;
+} Shape;
+
+Shape* shape_new_root();
+
+// Follows (or creates) the transition that adds `property` to `shape`.
+Shape* shape_add_property(Shape* shape, const char* property);
+
+// Returns the slot holding `property`, or -1 if the shape doesn't have it.
+int shape_lookup(const Shape* shape, const char* property);
+
+
+// --- Inline Caches ---
+// Each member access site remembers the shapes it has seen together with
+// the slot they resolved to, so a hit costs a shape compare and a load.
+#define INLINE_CACHE_ENTRIES 4
+
+typedef struct {
+    Shape* shape;      // Receiver shape this entry applies to
+    Shape* transition; // Stores only: shape after adding the property, NULL if it already existed
+    int slot;
+} InlineCacheEntry;
+
+typedef struct {
+    InlineCacheEntry entries[INLINE_CACHE_ENTRIES];
+    int count;       // 0: uninitialized, 1: monomorphic, >1: polymorphic
+    int megamorphic; // Too many shapes seen at this site; caching is disabled
+} InlineCache;
+
+void inline_cache_init(InlineCache* cache);
+void inline_cache_record(InlineCache* cache, Shape* shape, Shape* transition, int slot);
+
+static inline const InlineCacheEntry* inline_cache_find(const InlineCache* cache, const Shape* shape) {
+    for (int i = 0; i < cache->count; i++) {
+        if (cache->entries[i].shape == shape) {
+            return &cache->entries[i];
+        }
+    }
+    return NULL;
+}
+
+
+// --- Method Caches ---
+// Call sites of the form `obj.method(args)` remember which method each
+// receiver shape resolved to. Keying on the shape rather than the class
+// also proves the instance has no field shadowing the method. Entries are
+// only valid for the class epoch they were recorded in; any mutation of a
+// class bumps the epoch and empties every method cache lazily.
+typedef struct {
+    Shape* shape;
+    struct Object* method;
+} MethodCacheEntry;
+
+typedef struct {
+    MethodCacheEntry entries[INLINE_CACHE_ENTRIES];
+    int count;
+    unsigned int epoch;
+} MethodCache;
+
+#endif //OMNIKARAI_SHAPE_H
@@ -3,22 +3,49 @@
 
 #include <llvm-c/Core.h>
 
-// A simple key-value pair for our symbol table
-typedef struct Symbol {
-    char* name;
+// --- Symbol Table ---
+// Maps interned names to LLVM values with open addressing: one flat array
+// probed linearly from the name's precomputed hash, grown by doubling so it
+// never fills up.
+//
+// Scopes nest. A binding made inside a scope shadows the one outside until
+// the scope is popped. Instead of copying the table, each binding made in a
+// scope records what it replaced in an undo log; pushing a scope marks the
+// log, and popping it replays the log back to the mark.
+
+typedef struct {
+    const char* name; // Interned; NULL if the slot is empty
     LLVMValueRef value; // This will be a pointer to the memory location (alloca)
-    struct Symbol* next; // For handling hash collisions
 } Symbol;
 
-// A basic hash map implementation for the symbol table
 typedef struct {
-    Symbol** buckets;
-    unsigned int capacity;
+    const char* name;
+    LLVMValueRef previous; // NULL if the name was unbound
+} SymbolUndo;
+
+typedef struct {
+    Symbol* slots;
+    unsigned int capacity; // A power of two
+    unsigned int count;
+
+    SymbolUndo* undo;
+    unsigned int undo_count;
+    unsigned int undo_capacity;
+
+    unsigned int* scopes; // Undo log length when each open scope was pushed
+    unsigned int scope_count;
+    unsigned int scope_capacity;
 } SymbolTable;
 
+// `capacity` is the number of symbols expected; the table grows past it.
 SymbolTable* symbol_table_create(unsigned int capacity);
 void symbol_table_destroy(SymbolTable* table);
+// `name` must be interned (see intern.h) and `value` must not be NULL.
 void symbol_table_set(SymbolTable* table, const char* name, LLVMValueRef value);
 LLVMValueRef symbol_table_get(SymbolTable* table, const char* name);
 
+// Bindings set after a push are undone by the matching pop.
+void symbol_table_push_scope(SymbolTable* table);
+void symbol_table_pop_scope(SymbolTable* table);
+
 #endif // OMNI_SYMBOL_TABLE_H
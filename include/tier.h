@@ -0,0 +1,114 @@
+#ifndef OMNI_TIER_H
+#define OMNI_TIER_H
+
+#include "ast.h"
+#include "omni_runtime.h"
+
+// --- Tiered Execution ---
+// In tiered mode every function starts out interpreted. The interpreter
+// counts calls and loop back-edges per function object; once either crosses
+// its threshold the function is compiled through the JIT and its object is
+// patched to call the native code from then on. Functions the compiler
+// can't handle (closures, classes, ...) stay interpreted.
+//
+// Compilation happens in the background, on a pool of compiler threads
+// (see compile_pool.h), each compile in its own LLVM context. The
+// interpreter keeps running the function (or loop) interpreted meanwhile
+// and polls its TierTicket; the native code is swapped in on the first
+// call (or iteration) after it is ready.
+//
+// Compiled code keeps living inside the interpreter: it reads globals and
+// calls other functions through the bridges below, and values it can't
+// represent natively travel through it as opaque OMNI_OBJECT handles.
+//
+// Compiled code is speculative: it is specialized for the integer, float
+// and boolean types the interpreter observed (arguments at tier-up, loop
+// variables at OSR entry), behind type guards. When a guard fails, the
+// code deoptimizes: it returns TIER_EXIT_DEOPT before doing any work and
+// the interpreter carries on. After TIER_MAX_DEOPTS failures a function is
+// recompiled without speculation; a loop stays interpreted.
+#define TIER_CALL_THRESHOLD 100
+#define TIER_BACKEDGE_THRESHOLD 10000
+#define TIER_OSR_THRESHOLD 1000
+#define TIER_MAX_DEOPTS 4
+
+typedef enum {
+    TIER_INTERPRETED,
+    TIER_COMPILING, // Queued or being compiled; still interpreted
+    TIER_COMPILED,
+    TIER_FAILED, // Not compilable; never retried
+} TierState;
+
+typedef enum {
+    TIER_EXIT_DONE,  // Ran to completion
+    TIER_EXIT_DEOPT, // A guard failed; resume interpreting
+} TierExit;
+
+// Native entry point of a compiled function: arguments come in as an array,
+// the return value is stored in `result` and the TierExit is returned.
+typedef int (*TierEntry)(const OmniValue* args, OmniValue* result);
+
+void tier_init(int opt_level, int time_passes);
+void tier_shutdown();
+int tier_enabled();
+
+// A background compile, owned by the interpreter until tier_ticket_poll
+// reports it done.
+typedef struct TierTicket TierTicket;
+
+// Starts compiling a function body, speculating on the types of `args` (the
+// arguments of the call that made it hot; NULL for generic code). The entry
+// point is a TierEntry. Returns NULL if tiering is disabled.
+TierTicket* tier_compile(const char* name, AST_Expression_Identifier** parameters, int parameter_count,
+                         AST_Statement_Block* body, const OmniValue* args);
+
+// Returns 0 while the compile is still running. Once it is done, stores the
+// entry point (NULL if the code couldn't be compiled) in `entry`, frees the
+// ticket and returns 1.
+int tier_ticket_poll(TierTicket* ticket, void** entry);
+
+// --- On-Stack Replacement ---
+// A top-level `while` loop whose back-edge counter trips is compiled on its
+// own and entered mid-execution, at an iteration boundary. Its variables
+// (the globals it reads or writes) are copied into a frame the native code
+// works on directly; the frame is flushed back to the environment around
+// calls into the interpreter and when the loop exits.
+//
+// The native loop guards, at its header, that every variable still has the
+// type it had when the loop was compiled. A failed guard deoptimizes: the
+// loop returns TIER_EXIT_DEOPT at the iteration boundary and the interpreter
+// resumes it from the condition. The loop may be recompiled for the new
+// types later, up to TIER_MAX_DEOPTS times.
+
+typedef struct OsrFrame {
+    const char** names; // Interned
+    OmniValue* values;
+    int count;
+} OsrFrame;
+
+typedef int (*OsrEntry)(OmniValue* values, OsrFrame* frame);
+
+typedef struct OsrLoop {
+    const char** names; // Variables of the loop, in frame order
+    int count;
+    OsrEntry entry;     // NULL until compiled, and again after a deopt
+    TierTicket* ticket; // Compile in progress, if any
+    int deopt_count;
+    int failed;         // Not compilable; never retried
+} OsrLoop;
+
+// Collects the variables of a top-level loop.
+OsrLoop* tier_osr_prepare(AST_Statement_While* loop);
+
+// Starts compiling `loop` with guards on the types currently in `values`.
+// The entry point is an OsrEntry. Returns NULL if tiering is disabled.
+TierTicket* tier_osr_compile(OsrLoop* osr, AST_Statement_While* loop, const OmniValue* values);
+
+// --- Bridges (implemented by the interpreter) ---
+// `name` is interned.
+OmniValue omni_tier_get_global(const char* name);
+OmniValue omni_tier_call(const char* name, const OmniValue* args, int arg_count);
+void omni_osr_flush(OsrFrame* frame);  // Frame -> environment
+void omni_osr_reload(OsrFrame* frame); // Environment -> frame
+
+#endif // OMNI_TIER_H
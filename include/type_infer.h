@@ -0,0 +1,27 @@
+#ifndef OMNIKARAI_TYPE_INFER_H
+#define OMNIKARAI_TYPE_INFER_H
+
+#include "ast.h"
+
+// --- Static Type Inference ---
+// A flow-sensitive pass over the resolved AST (run resolve_program first)
+// that sets `static_type` on every expression whose type is the same on
+// every execution: literals, and variables and operators built from them.
+// Branches join (differing types become STATIC_DYNAMIC) and loops are
+// iterated to a fixpoint.
+//
+// Top-level variables are tracked through top-level code: `set` in a
+// function always declares a local, so nothing else can assign them.
+// Inside functions only locals are tracked; parameters, globals and
+// captured variables are dynamic, as are the results of calls.
+typedef struct {
+    int expression_count;
+    int typed_count; // Expressions with a static type
+    int type_counts[STATIC_TYPE_COUNT];
+} TypeReport;
+
+// Annotates the program; fills in `report` unless it is NULL.
+void infer_types(AST_Program* program, TypeReport* report);
+void print_type_report(const TypeReport* report);
+
+#endif //OMNIKARAI_TYPE_INFER_H
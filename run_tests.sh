@@ -0,0 +1,71 @@
+#!/bin/sh
+# Runs the test_*.ok programs that say what they should do, under every
+# execution mode: the interpreter, the tiers, the JIT (cold, then again
+# from its cache) and the SSA IR. A test ends with either
+#
+#     # Expected output:
+#     # <first line printed>
+#     # ...
+#
+# or `# Expected result: <value>` for the value of its last statement. A
+# `# Skip: <mode> ...` line names modes that can't run the program yet, and
+# `# Folded calls: <n>` how many calls partial evaluation must replace.
+#
+# Usage: ./run_tests.sh [test.ok ...]    (OMNICC picks the binary)
+
+OMNICC=${OMNICC:-bin/omnicc}
+CACHE=$(mktemp -d)
+OUT=$(mktemp)
+trap 'rm -rf "$CACHE" "$OUT" "$OUT.expected" "$OUT.actual"' EXIT
+
+if [ $# -eq 0 ]; then
+    set -- $(grep -l '^# Expected' test_*.ok)
+fi
+
+failures=0
+for test in "$@"; do
+    grep -q '^# Expected output:' "$test" && kind=output || kind=result
+    sed -n '/^# Expected output:/,$p' "$test" | sed '1d; s/^# \{0,1\}//' > "$OUT.expected"
+    result=$(sed -n 's/^# Expected result: //p' "$test")
+    skip=$(sed -n 's/^# Skip: //p' "$test")
+
+    # -jit runs twice: the second one loads every function from the cache
+    for mode in interpreter -tier -jit -jit -ir; do
+        case " $skip " in *" $mode "*) continue ;; esac
+        flag=$mode
+        [ $mode = interpreter ] && flag=
+        OMNI_JIT_CACHE_DIR=$CACHE timeout 60 "$OMNICC" $flag "$test" > "$OUT" 2> /dev/null
+        status=$?
+        if [ $kind = output ]; then
+            grep -v -E '^(Processing: |Parsing complete\.|Compiler: |JIT compilation complete|Falling back to |(JIT |IR )?Result: )' \
+                "$OUT" > "$OUT.actual"
+            cmp -s "$OUT.expected" "$OUT.actual"
+        else
+            [ "$(sed -n 's/^\(JIT \|IR \)\{0,1\}Result: //p' "$OUT")" = "$result" ]
+        fi
+        if [ $? -ne 0 ] || [ $status -ne 0 ]; then
+            echo "FAIL: $test $mode"
+            if [ $kind = output ]; then
+                diff "$OUT.expected" "$OUT.actual" | sed 's/^/    /'
+            else
+                sed 's/^/    /' "$OUT"
+            fi
+            failures=$((failures + 1))
+        fi
+    done
+
+    folded=$(sed -n 's/^# Folded calls: //p' "$test")
+    if [ -n "$folded" ]; then
+        actual=$("$OMNICC" --time-passes "$test" 2>&1 > /dev/null | sed -n 's/^Partial evaluation: \([0-9]*\) calls folded$/\1/p')
+        if [ "$actual" != "$folded" ]; then
+            echo "FAIL: $test folded ${actual:-no} calls, not $folded"
+            failures=$((failures + 1))
+        fi
+    fi
+done
+
+if [ $failures -ne 0 ]; then
+    echo "$failures failed"
+    exit 1
+fi
+echo "All $# tests passed"
@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "aot.h"
+#include "optimizer.h"
+#include "runtime_inline.h"
+
+#include <llvm-c/Core.h>
+#include <llvm-c/Linker.h>
+#include <llvm-c/Target.h>
+#include <llvm-c/TargetMachine.h>
+
+// Merges every module of the program into the main one.
+static LLVMModuleRef link_program(CompiledProgram* program) {
+    LLVMModuleRef module = program->modules[0];
+    program->modules[0] = NULL;
+    for (int i = 1; i < program->module_count; i++) {
+        int failed = LLVMLinkModules2(module, program->modules[i]); // Consumes the source module
+        program->modules[i] = NULL;
+        if (failed) {
+            fprintf(stderr, "AOT: Failed to link the program's modules.\n");
+            LLVMDisposeModule(module);
+            return NULL;
+        }
+    }
+    return module;
+}
+
+static int emit_object(CompiledProgram* program, const char* path, int opt_level, int time_passes) {
+    LLVMModuleRef module = link_program(program);
+    if (module == NULL) return 1;
+
+    // The C `main` lives in the runtime library and calls the program
+    LLVMSetValueName2(LLVMGetNamedFunction(module, "main"), "omni_main", 9);
+
+    LLVMTargetMachineRef machine = create_object_target_machine(opt_level);
+    if (machine == NULL) {
+        LLVMDisposeModule(module);
+        return 1;
+    }
+    char* triple = LLVMGetTargetMachineTriple(machine);
+    LLVMSetTarget(module, triple);
+    LLVMDisposeMessage(triple);
+    LLVMTargetDataRef data_layout = LLVMCreateTargetDataLayout(machine);
+    LLVMSetModuleDataLayout(module, data_layout);
+    LLVMDisposeTargetData(data_layout);
+
+    int failed = opt_level > 0 && link_runtime_bitcode(module) != 0;
+    failed = failed || optimize_module(module, opt_level, time_passes);
+    char* error = NULL;
+    if (!failed && LLVMTargetMachineEmitToFile(machine, module, (char*)path, LLVMObjectFile, &error)) {
+        fprintf(stderr, "AOT: Could not write '%s': %s\n", path, error);
+        LLVMDisposeMessage(error);
+        failed = 1;
+    }
+
+    LLVMDisposeTargetMachine(machine);
+    LLVMDisposeModule(module);
+    return failed;
+}
+
+int aot_compile_object(AST_Node* ast, const char* path, int opt_level, int time_passes) {
+    LLVMInitializeNativeTarget();
+    LLVMInitializeNativeAsmPrinter();
+
+    LLVMContextRef context = LLVMContextCreate();
+    CompiledProgram* program = compile_to_llvm_ir(ast, context);
+    int failed = program == NULL || emit_object(program, path, opt_level, time_passes);
+    compiled_program_dispose(program);
+    LLVMContextDispose(context);
+    return failed;
+}
+
+int aot_link_executable(const char* object_path, const char* runtime_lib, const char* path) {
+    FILE* lib = fopen(runtime_lib, "rb");
+    if (lib == NULL) {
+        fprintf(stderr, "AOT: Runtime library '%s' not found (set OMNI_RUNTIME_LIB).\n", runtime_lib);
+        return 1;
+    }
+    fclose(lib);
+
+    const char* cc = getenv("CC") ? getenv("CC") : "cc";
+    char command[4096];
+    snprintf(command, sizeof(command), "%s -o '%s' '%s' '%s' -pthread -lm", cc, path, object_path, runtime_lib);
+    if (system(command) != 0) {
+        fprintf(stderr, "AOT: Linking failed: %s\n", command);
+        return 1;
+    }
+    return 0;
+}
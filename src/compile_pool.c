@@ -0,0 +1,99 @@
+#define _POSIX_C_SOURCE 200809L // sysconf
+#include "compile_pool.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define MAX_COMPILE_THREADS 64
+
+typedef struct QueuedJob {
+    CompileJob job;
+    void* data;
+    struct QueuedJob* next;
+} QueuedJob;
+
+static pthread_t threads[MAX_COMPILE_THREADS];
+static int thread_count = 0;
+static QueuedJob* queue_head = NULL;
+static QueuedJob* queue_tail = NULL;
+static int stopping = 0;
+static pthread_mutex_t queue_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_ready = PTHREAD_COND_INITIALIZER;
+
+static void* compile_thread(void* arg) {
+    (void)arg;
+    for (;;) {
+        pthread_mutex_lock(&queue_lock);
+        while (queue_head == NULL && !stopping) {
+            pthread_cond_wait(&queue_ready, &queue_lock);
+        }
+        if (queue_head == NULL) { // Stopping and drained
+            pthread_mutex_unlock(&queue_lock);
+            return NULL;
+        }
+        QueuedJob* queued = queue_head;
+        queue_head = queued->next;
+        if (queue_head == NULL) queue_tail = NULL;
+        int cancelled = stopping;
+        pthread_mutex_unlock(&queue_lock);
+
+        queued->job(queued->data, cancelled);
+        free(queued);
+    }
+}
+
+static int default_thread_count() {
+    const char* configured = getenv("OMNI_COMPILE_THREADS");
+    if (configured != NULL && atoi(configured) > 0) return atoi(configured);
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? (int)cores : 1;
+}
+
+int compile_pool_start(int count) {
+    if (count <= 0) count = default_thread_count();
+    if (count > MAX_COMPILE_THREADS) count = MAX_COMPILE_THREADS;
+
+    stopping = 0;
+    for (thread_count = 0; thread_count < count; thread_count++) {
+        if (pthread_create(&threads[thread_count], NULL, compile_thread, NULL) != 0) break;
+    }
+    if (thread_count == 0) {
+        fprintf(stderr, "Compile Pool: Could not start any compiler threads.\n");
+        return 1;
+    }
+    return 0;
+}
+
+void compile_pool_submit(CompileJob job, void* data) {
+    if (thread_count == 0) {
+        job(data, 0); // No threads: compile in the foreground
+        return;
+    }
+    QueuedJob* queued = malloc(sizeof(QueuedJob));
+    queued->job = job;
+    queued->data = data;
+    queued->next = NULL;
+
+    pthread_mutex_lock(&queue_lock);
+    if (queue_tail != NULL) {
+        queue_tail->next = queued;
+    } else {
+        queue_head = queued;
+    }
+    queue_tail = queued;
+    pthread_cond_signal(&queue_ready);
+    pthread_mutex_unlock(&queue_lock);
+}
+
+void compile_pool_stop() {
+    pthread_mutex_lock(&queue_lock);
+    stopping = 1;
+    pthread_cond_broadcast(&queue_ready);
+    pthread_mutex_unlock(&queue_lock);
+
+    for (int i = 0; i < thread_count; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    thread_count = 0;
+}
@@ -1,7 +1,14 @@
 #include "compiler.h"
+#include "omni_runtime.h"
+#include "symbol_table.h"
+#include "resolver.h"
+#include "type_infer.h"
+#include "intern.h"
+#include "tier.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdarg.h>
 
 // LLVM includes
 #include <llvm-c/Core.h>
@@ -9,37 +16,1129 @@
 #include <llvm-c/Target.h>
 #include <llvm-c/Transforms/Scalar.h>
 #include <llvm-c/Analysis.h>
+#include <llvm-c/DebugInfo.h>
+
+#define SYMBOL_TABLE_CAPACITY 64
+
+// Line info for the module being emitted into; `builder` is NULL without -g.
+typedef struct {
+    LLVMDIBuilderRef builder;
+    LLVMMetadataRef file;
+    LLVMMetadataRef scope; // Subprogram of the function being compiled
+} DebugInfo;
 
 // Represents the state of our compiler
+//
+// Every Omnikarai value is an `OmniValue` (see omni_runtime.h), lowered to
+// the LLVM struct `{ i32 type, i64 payload }`, which has the same layout and
+// calling convention as the C struct, so runtime helpers are called directly.
+//
+// Each Omnikarai function gets a module of its own so the JIT can compile it
+// on first call; the main module holds `main` and the top-level variables.
+// Other modules refer to those by symbol name through declarations.
 typedef struct {
-    LLVMModuleRef module;
+    LLVMContextRef context;
+    LLVMModuleRef module;      // Module being emitted into
+    LLVMModuleRef main_module;
     LLVMBuilderRef builder;
-    // We will add a symbol table here later
+    LLVMTypeRef value_type; // %OmniValue
+
+    CompiledProgram* program;
+    SymbolTable* globals;   // Top-level variables -> LLVM globals in the main module
+    SymbolTable* functions; // Top-level functions -> LLVM function declarations in the main module
+    SymbolTable* locals;    // Variables of the function being compiled -> allocas; NULL at top level
+    SymbolTable* local_scopes; // Backs `locals`: each function is compiled in a scope of its own
+    LLVMValueRef function;  // Function being compiled
+    LLVMBasicBlockRef landing_pad; // Where errors raised by calls go: the innermost `try`; NULL if they propagate
+
+    const char* print_name; // Interned "print", the only builtin
+    int tiered;             // Compiling one function for the tiered interpreter (see tier.h)
+    const OmniType* guard_types; // Speculated types of the parameters or frame variables; NULL if none
+
+    // On-stack replacement of a loop (see tier.h); NULL otherwise
+    AST_Statement_While* osr_loop;
+    SymbolTable* frame;          // Loop variables -> allocas, synced with the frame's values
+    const char** frame_names;    // Frame order
+    int frame_count;
+    LLVMValueRef frame_values;   // The OmniValue* of the frame
+    LLVMValueRef frame_handle;   // The OsrFrame*, passed back to the bridges
+
+    DebugInfo debug;
+    int error_count;
 } Compiler;
 
+static const char* debug_source = NULL; // Path of the source file with -g
+
 // Forward declare our recursive compile function
 LLVMValueRef compile_node(Compiler* compiler, AST_Node* node);
+static LLVMValueRef compile_block(Compiler* compiler, AST_Statement_Block* block);
+
+static void compiler_error(Compiler* compiler, const char* format, ...) {
+    compiler->error_count++;
+    if (compiler->tiered) return; // Not an error: the function just stays interpreted
+
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "Compiler Error: ");
+    vfprintf(stderr, format, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+}
+
+// --- Types and Values ---
+
+static LLVMTypeRef i32_type(Compiler* compiler) { return LLVMInt32TypeInContext(compiler->context); }
+static LLVMTypeRef i64_type(Compiler* compiler) { return LLVMInt64TypeInContext(compiler->context); }
+
+static LLVMValueRef const_value(Compiler* compiler, OmniType type, unsigned long long payload) {
+    LLVMValueRef fields[] = {
+        LLVMConstInt(i32_type(compiler), type, 0),
+        LLVMConstInt(i64_type(compiler), payload, 0),
+    };
+    return LLVMConstNamedStruct(compiler->value_type, fields, 2);
+}
+
+static LLVMValueRef nil_value(Compiler* compiler) {
+    return const_value(compiler, OMNI_NIL, 0);
+}
+
+static LLVMValueRef make_value(Compiler* compiler, OmniType type, LLVMValueRef payload) {
+    LLVMValueRef value = LLVMGetUndef(compiler->value_type);
+    value = LLVMBuildInsertValue(compiler->builder, value, LLVMConstInt(i32_type(compiler), type, 0), 0, "");
+    return LLVMBuildInsertValue(compiler->builder, value, payload, 1, "");
+}
+
+static int block_is_terminated(Compiler* compiler) {
+    return LLVMGetBasicBlockTerminator(LLVMGetInsertBlock(compiler->builder)) != NULL;
+}
+
+// Allocas go in the entry block so loops don't grow the stack.
+static LLVMBuilderRef entry_builder(Compiler* compiler) {
+    LLVMBuilderRef builder = LLVMCreateBuilderInContext(compiler->context);
+    LLVMBasicBlockRef entry = LLVMGetEntryBasicBlock(compiler->function);
+    LLVMValueRef first = LLVMGetFirstInstruction(entry);
+    if (first != NULL) {
+        LLVMPositionBuilderBefore(builder, first);
+    } else {
+        LLVMPositionBuilderAtEnd(builder, entry);
+    }
+    return builder;
+}
+
+static LLVMValueRef build_entry_alloca(Compiler* compiler, LLVMTypeRef type, const char* name) {
+    LLVMBuilderRef builder = entry_builder(compiler);
+    LLVMValueRef slot = LLVMBuildAlloca(builder, type, name);
+    LLVMDisposeBuilder(builder);
+    return slot;
+}
+
+// --- Debug Info ---
+// With -g every function gets a DISubprogram and every statement the line
+// it starts on, so debuggers and profilers map machine code back to the
+// .ok source. Each module carries a compile unit of its own.
+
+void compiler_set_debug_source(const char* source_path) {
+    debug_source = source_path;
+}
+
+static void debug_begin_module(Compiler* compiler, LLVMModuleRef module) {
+    compiler->debug.builder = NULL;
+    compiler->debug.scope = NULL;
+    if (debug_source == NULL) return;
+
+    const char* slash = strrchr(debug_source, '/');
+    const char* name = slash ? slash + 1 : debug_source;
+    const char* directory = slash ? debug_source : ".";
+    size_t directory_length = slash ? (size_t)(slash - debug_source) : 1;
+
+    LLVMDIBuilderRef builder = LLVMCreateDIBuilder(module);
+    compiler->debug.builder = builder;
+    compiler->debug.file = LLVMDIBuilderCreateFile(builder, name, strlen(name), directory, directory_length);
+    LLVMDIBuilderCreateCompileUnit(builder, LLVMDWARFSourceLanguageC, compiler->debug.file, "omnicc", 6, 0,
+                                   "", 0, 0, "", 0, LLVMDWARFEmissionFull, 0, 0, 0, "", 0, "", 0);
+
+    LLVMValueRef version = LLVMConstInt(i32_type(compiler), LLVMDebugMetadataVersion(), 0);
+    LLVMAddModuleFlag(module, LLVMModuleFlagBehaviorWarning, "Debug Info Version", 18,
+                      LLVMValueAsMetadata(version));
+    LLVMAddModuleFlag(module, LLVMModuleFlagBehaviorWarning, "Dwarf Version", 13,
+                      LLVMValueAsMetadata(LLVMConstInt(i32_type(compiler), 4, 0)));
+}
+
+static void debug_finish_module(Compiler* compiler) {
+    if (compiler->debug.builder == NULL) return;
+    LLVMDIBuilderFinalize(compiler->debug.builder);
+    LLVMDisposeDIBuilder(compiler->debug.builder);
+    compiler->debug.builder = NULL;
+}
+
+static void debug_set_line(Compiler* compiler, int line) {
+    if (compiler->debug.builder == NULL || compiler->debug.scope == NULL) return;
+    LLVMMetadataRef location = LLVMDIBuilderCreateDebugLocation(compiler->context, line, 0,
+                                                                compiler->debug.scope, NULL);
+    LLVMSetCurrentDebugLocation2(compiler->builder, location);
+}
+
+// Attaches a subprogram to `function`, defined at `line`, and makes it the
+// scope of the instructions built from here on.
+static void debug_begin_function(Compiler* compiler, LLVMValueRef function, int line) {
+    if (compiler->debug.builder == NULL) return;
+    size_t length;
+    const char* name = LLVMGetValueName2(function, &length);
+    LLVMMetadataRef type = LLVMDIBuilderCreateSubroutineType(compiler->debug.builder, compiler->debug.file,
+                                                             NULL, 0, LLVMDIFlagZero);
+    compiler->debug.scope = LLVMDIBuilderCreateFunction(compiler->debug.builder, compiler->debug.file,
+                                                        name, length, name, length, compiler->debug.file,
+                                                        line, type, 0, 1, line, LLVMDIFlagZero, 0);
+    LLVMSetSubprogram(function, compiler->debug.scope);
+    debug_set_line(compiler, line);
+}
+
+// --- Runtime Calls ---
+
+static LLVMValueRef runtime_function(Compiler* compiler, const char* name, LLVMTypeRef return_type,
+                                     LLVMTypeRef* params, unsigned param_count) {
+    LLVMValueRef function = LLVMGetNamedFunction(compiler->module, name);
+    if (function == NULL) {
+        LLVMTypeRef type = LLVMFunctionType(return_type, params, param_count, 0);
+        function = LLVMAddFunction(compiler->module, name, type);
+    }
+    return function;
+}
+
+// Calls that may raise an error (see omni_error.h). Inside a `try` they
+// become invokes unwinding to its landing pad, which costs nothing until an
+// error is actually raised.
+static LLVMValueRef build_call(Compiler* compiler, LLVMTypeRef type, LLVMValueRef function, LLVMValueRef* args,
+                               unsigned arg_count, const char* name) {
+    if (compiler->landing_pad == NULL) {
+        return LLVMBuildCall2(compiler->builder, type, function, args, arg_count, name);
+    }
+    LLVMBasicBlockRef next = LLVMAppendBasicBlockInContext(compiler->context, compiler->function, "invoke.cont");
+    LLVMValueRef result = LLVMBuildInvoke2(compiler->builder, type, function, args, arg_count, next,
+                                           compiler->landing_pad, name);
+    LLVMPositionBuilderAtEnd(compiler->builder, next);
+    return result;
+}
+
+static LLVMValueRef call_runtime(Compiler* compiler, const char* name, LLVMTypeRef return_type,
+                                 LLVMValueRef* args, unsigned arg_count) {
+    LLVMTypeRef params[4];
+    for (unsigned i = 0; i < arg_count; i++) {
+        params[i] = LLVMTypeOf(args[i]);
+    }
+    LLVMValueRef function = runtime_function(compiler, name, return_type, params, arg_count);
+    return build_call(compiler, LLVMGlobalGetValueType(function), function, args, arg_count, "");
+}
+
+// Starts a landing pad in `block`, which the unwinder enters for any error
+// (a cleanup clause is enough: raising is a forced unwind, see omni_error.c).
+static LLVMValueRef build_landing_pad(Compiler* compiler, LLVMBasicBlockRef block) {
+    LLVMValueRef personality = LLVMGetNamedFunction(compiler->module, "__gcc_personality_v0");
+    if (personality == NULL) {
+        LLVMTypeRef type = LLVMFunctionType(i32_type(compiler), NULL, 0, 1);
+        personality = LLVMAddFunction(compiler->module, "__gcc_personality_v0", type);
+    }
+    LLVMTypeRef fields[] = { LLVMPointerType(LLVMInt8TypeInContext(compiler->context), 0), i32_type(compiler) };
+    LLVMTypeRef pad_type = LLVMStructTypeInContext(compiler->context, fields, 2, 0);
+
+    LLVMPositionBuilderAtEnd(compiler->builder, block);
+    LLVMValueRef pad = LLVMBuildLandingPad(compiler->builder, pad_type, personality, 0, "");
+    LLVMSetCleanup(pad, 1);
+    return pad;
+}
+
+static LLVMValueRef call_binary(Compiler* compiler, const char* name, LLVMValueRef left, LLVMValueRef right) {
+    LLVMValueRef args[] = { left, right };
+    return call_runtime(compiler, name, compiler->value_type, args, 2);
+}
+
+static LLVMValueRef build_type_is(Compiler* compiler, LLVMValueRef value, OmniType type) {
+    LLVMValueRef tag = LLVMBuildExtractValue(compiler->builder, value, 0, "type");
+    return LLVMBuildICmp(compiler->builder, LLVMIntEQ, tag, LLVMConstInt(i32_type(compiler), type, 0), "");
+}
+
+// omni_is_truthy, inline so conditions on known types fold away.
+static LLVMValueRef build_truthy(Compiler* compiler, LLVMValueRef value) {
+    LLVMValueRef payload = LLVMBuildExtractValue(compiler->builder, value, 1, "");
+    LLVMValueRef boolean = LLVMBuildICmp(compiler->builder, LLVMIntNE, payload, LLVMConstInt(i64_type(compiler), 0, 0), "");
+    LLVMValueRef not_nil = LLVMBuildNot(compiler->builder, build_type_is(compiler, value, OMNI_NIL), "");
+    return LLVMBuildSelect(compiler->builder, build_type_is(compiler, value, OMNI_BOOLEAN), boolean, not_nil, "truthy");
+}
+
+// --- Profile Feedback ---
+// Functions and loops compiled by the tiered interpreter have run
+// interpreted first; the counts it kept (see ast.h) become branch weights,
+// and call sites that never ran are marked cold. Block placement lays the
+// hot paths out straight, and the inliner spends its budget on helpers
+// called from frequent blocks. Without counts, LLVM's static heuristics apply.
+
+static void set_branch_weights(Compiler* compiler, LLVMValueRef branch, const BranchProfile* profile) {
+    unsigned long long taken = profile->taken, not_taken = profile->not_taken;
+    if (taken + not_taken == 0) return;
+
+    // Never seen is unlikely, not impossible; weights are 32-bit
+    unsigned long long largest = taken > not_taken ? taken : not_taken;
+    unsigned long long scale = (largest >> 31) + 1;
+    unsigned weights[] = { (unsigned)(taken / scale) + 1, (unsigned)(not_taken / scale) + 1 };
+
+    LLVMMetadataRef operands[] = {
+        LLVMMDStringInContext2(compiler->context, "branch_weights", 14),
+        LLVMValueAsMetadata(LLVMConstInt(i32_type(compiler), weights[0], 0)),
+        LLVMValueAsMetadata(LLVMConstInt(i32_type(compiler), weights[1], 0)),
+    };
+    LLVMMetadataRef node = LLVMMDNodeInContext2(compiler->context, operands, 3);
+    LLVMSetMetadata(branch, LLVMGetMDKindIDInContext(compiler->context, "prof", 4),
+                    LLVMMetadataAsValue(compiler->context, node));
+}
+
+static void set_call_hotness(Compiler* compiler, LLVMValueRef call, const CallProfile* profile) {
+    if (!compiler->tiered || profile->count > 0) return;
+    unsigned cold = LLVMGetEnumAttributeKindForName("cold", 4);
+    LLVMAddCallSiteAttribute(call, LLVMAttributeFunctionIndex, LLVMCreateEnumAttribute(compiler->context, cold, 0));
+}
+
+// --- Speculation ---
+// Values of a speculated type get their type tag replaced by a constant once
+// a guard has checked it, so LLVM can fold the fast paths of the operations
+// on them (see compile_infix) and keep the payloads in registers.
+
+static int is_speculated(OmniType type) {
+    return type == OMNI_INTEGER || type == OMNI_FLOAT || type == OMNI_BOOLEAN;
+}
+
+static LLVMValueRef specialize_value(Compiler* compiler, LLVMValueRef value, OmniType type) {
+    return make_value(compiler, type, LLVMBuildExtractValue(compiler->builder, value, 1, ""));
+}
+
+// --- Static Types ---
+// Expressions type inference proved (type_infer.h) need no guards at all.
+
+static OmniType omni_type_of(AST_StaticType type) {
+    switch (type) {
+        case STATIC_INTEGER: return OMNI_INTEGER;
+        case STATIC_FLOAT: return OMNI_FLOAT;
+        case STATIC_BOOLEAN: return OMNI_BOOLEAN;
+        case STATIC_NIL: return OMNI_NIL;
+        default: return OMNI_STRING;
+    }
+}
+
+// Re-tags a loaded value with its static type, so the tag is a constant to LLVM.
+static LLVMValueRef static_value(Compiler* compiler, AST_Expression* expr, LLVMValueRef value) {
+    if (value == NULL || expr->static_type == STATIC_DYNAMIC) return value;
+    OmniType type = omni_type_of(expr->static_type);
+    return is_speculated(type) ? specialize_value(compiler, value, type) : value;
+}
+
+// Widens a statically typed number to a double, like the runtime does for mixed operands.
+static LLVMValueRef static_double(Compiler* compiler, AST_Expression* expr, LLVMValueRef value) {
+    LLVMValueRef payload = LLVMBuildExtractValue(compiler->builder, value, 1, "");
+    if (expr->static_type == STATIC_FLOAT) return payload;
+    LLVMValueRef widened = LLVMBuildSIToFP(compiler->builder, payload, LLVMDoubleTypeInContext(compiler->context), "");
+    return LLVMBuildBitCast(compiler->builder, widened, i64_type(compiler), "");
+}
+
+// --- Cross-Module References ---
+
+// Returns the declaration of a main-module function or global in the
+// module being emitted into, adding it the first time it is referenced.
+static LLVMValueRef import_symbol(Compiler* compiler, LLVMValueRef value) {
+    if (compiler->module == compiler->main_module) return value;
+
+    size_t length;
+    const char* symbol = LLVMGetValueName2(value, &length);
+    if (LLVMIsAFunction(value)) {
+        LLVMValueRef function = LLVMGetNamedFunction(compiler->module, symbol);
+        return function ? function : LLVMAddFunction(compiler->module, symbol, LLVMGlobalGetValueType(value));
+    }
+    LLVMValueRef global = LLVMGetNamedGlobal(compiler->module, symbol);
+    return global ? global : LLVMAddGlobal(compiler->module, compiler->value_type, symbol);
+}
+
+// --- Variables ---
+
+static LLVMValueRef get_global(Compiler* compiler, const char* name, int create) {
+    LLVMValueRef global = symbol_table_get(compiler->globals, name);
+    if (global == NULL && create) {
+        char symbol[256];
+        snprintf(symbol, sizeof(symbol), "omni.global.%s", name);
+        global = LLVMAddGlobal(compiler->main_module, compiler->value_type, symbol);
+        LLVMSetInitializer(global, const_value(compiler, OMNI_TYPE_COUNT, 0)); // Not assigned yet, see load_global
+        symbol_table_set(compiler->globals, name, global);
+    }
+    return global ? import_symbol(compiler, global) : NULL;
+}
+
+static LLVMValueRef get_local(Compiler* compiler, const char* name, int create) {
+    LLVMValueRef slot = symbol_table_get(compiler->locals, name);
+    if (slot == NULL && create) {
+        // Initialized in the entry block; load_local_or_outer relies on the
+        // store following the alloca for reads that may come before the first assignment
+        LLVMBuilderRef builder = entry_builder(compiler);
+        slot = LLVMBuildAlloca(builder, compiler->value_type, name);
+        LLVMBuildStore(builder, nil_value(compiler), slot);
+        LLVMDisposeBuilder(builder);
+        symbol_table_set(compiler->locals, name, slot);
+    }
+    return slot;
+}
+
+// Returns the storage of a variable: a frame slot, a local alloca or a global.
+static LLVMValueRef lookup_variable(Compiler* compiler, AST_Expression_Identifier* ident, int for_store) {
+    if (compiler->frame != NULL) {
+        LLVMValueRef slot = symbol_table_get(compiler->frame, ident->value);
+        if (slot != NULL) return slot;
+    }
+    if (ident->scope == SCOPE_UPVALUE) {
+        compiler_error(compiler, "Closures are not supported by the compiler yet ('%s').", ident->value);
+        return NULL;
+    }
+    if (compiler->locals != NULL && ident->scope != SCOPE_GLOBAL) {
+        // A resolved local may be read before the assignment that declares it is compiled
+        LLVMValueRef slot = get_local(compiler, ident->value, for_store || ident->scope == SCOPE_LOCAL);
+        if (slot != NULL) return slot;
+    }
+    LLVMValueRef global = get_global(compiler, ident->value, for_store && compiler->locals == NULL);
+    if (global == NULL) {
+        compiler_error(compiler, "Identifier '%s' not found.", ident->value);
+    }
+    return global;
+}
+
+// A global nothing defines (functions, which can't be read as values yet,
+// are compile errors instead). Reading it raises at run time, as in the
+// interpreter, so a `try` around it can catch the error.
+static int is_undefined(Compiler* compiler, AST_Expression_Identifier* ident) {
+    if (ident->scope != SCOPE_GLOBAL) return 0;
+    if (compiler->frame != NULL && symbol_table_get(compiler->frame, ident->value) != NULL) return 0;
+    if (symbol_table_get(compiler->functions, ident->value) != NULL) return 0;
+    return get_global(compiler, ident->value, 0) == NULL;
+}
+
+static LLVMValueRef build_undefined(Compiler* compiler, AST_Expression_Identifier* ident) {
+    LLVMValueRef name = LLVMBuildGlobalStringPtr(compiler->builder, ident->value, "name");
+    call_runtime(compiler, "omni_undefined", LLVMVoidTypeInContext(compiler->context), &name, 1);
+    return nil_value(compiler); // Never reached
+}
+
+// Globals start out as a value of no OmniType, so reading one before the
+// program first assigns it raises, as in the interpreter.
+static LLVMValueRef load_global(Compiler* compiler, LLVMValueRef global, AST_Expression_Identifier* ident) {
+    LLVMValueRef value = LLVMBuildLoad2(compiler->builder, compiler->value_type, global, ident->value);
+    LLVMValueRef tag = LLVMBuildExtractValue(compiler->builder, value, 0, "");
+    LLVMValueRef unassigned = LLVMBuildICmp(compiler->builder, LLVMIntEQ, tag,
+                                            LLVMConstInt(i32_type(compiler), OMNI_TYPE_COUNT, 0), "");
+    LLVMBasicBlockRef undefined_block = LLVMAppendBasicBlockInContext(compiler->context, compiler->function, "undefined");
+    LLVMBasicBlockRef assigned_block = LLVMAppendBasicBlockInContext(compiler->context, compiler->function, "assigned");
+    LLVMBuildCondBr(compiler->builder, unassigned, undefined_block, assigned_block);
+
+    LLVMPositionBuilderAtEnd(compiler->builder, undefined_block);
+    build_undefined(compiler, ident);
+    LLVMBuildUnreachable(compiler->builder);
+
+    LLVMPositionBuilderAtEnd(compiler->builder, assigned_block);
+    return value;
+}
+
+static LLVMValueRef name_constant(Compiler* compiler, const char* name);
+
+// Reads a local that may not be assigned yet, which sees the global until
+// the function first assigns the local and raises if there is none (see
+// resolver.h). The local then starts out as a value of no OmniType rather than nil.
+static LLVMValueRef load_local_or_outer(Compiler* compiler, AST_Expression_Identifier* ident) {
+    if (ident->outer == SCOPE_UPVALUE) {
+        compiler_error(compiler, "Closures are not supported by the compiler yet ('%s').", ident->value);
+        return NULL;
+    }
+    LLVMValueRef slot = lookup_variable(compiler, ident, 0);
+    if (slot == NULL) return NULL;
+    LLVMValueRef value = LLVMBuildLoad2(compiler->builder, compiler->value_type, slot, ident->value);
+    LLVMValueRef initializer = LLVMGetNextInstruction(slot);
+    if (initializer == NULL || !LLVMIsAStoreInst(initializer) || LLVMGetOperand(initializer, 1) != slot) {
+        return value; // A frame variable, which is always assigned
+    }
+    LLVMSetOperand(initializer, 0, const_value(compiler, OMNI_TYPE_COUNT, 0));
+
+    LLVMValueRef tag = LLVMBuildExtractValue(compiler->builder, value, 0, "");
+    LLVMValueRef unassigned = LLVMBuildICmp(compiler->builder, LLVMIntEQ, tag,
+                                            LLVMConstInt(i32_type(compiler), OMNI_TYPE_COUNT, 0), "");
+    LLVMBasicBlockRef assigned_block = LLVMGetInsertBlock(compiler->builder);
+    LLVMBasicBlockRef outer_block = LLVMAppendBasicBlockInContext(compiler->context, compiler->function, "outer");
+    LLVMBasicBlockRef merge_block = LLVMAppendBasicBlockInContext(compiler->context, compiler->function, "outer.cont");
+    LLVMBuildCondBr(compiler->builder, unassigned, outer_block, merge_block);
+
+    LLVMPositionBuilderAtEnd(compiler->builder, outer_block);
+    LLVMValueRef outer;
+    LLVMValueRef global = compiler->tiered ? NULL : get_global(compiler, ident->value, 0);
+    if (compiler->tiered) {
+        LLVMValueRef name = name_constant(compiler, ident->value);
+        outer = call_runtime(compiler, "omni_tier_get_global", compiler->value_type, &name, 1);
+    } else if (global != NULL) {
+        outer = load_global(compiler, global, ident);
+    } else {
+        outer = build_undefined(compiler, ident);
+    }
+    outer_block = LLVMGetInsertBlock(compiler->builder); // The call may have ended the block
+    LLVMBuildBr(compiler->builder, merge_block);
+
+    LLVMPositionBuilderAtEnd(compiler->builder, merge_block);
+    LLVMValueRef phi = LLVMBuildPhi(compiler->builder, compiler->value_type, ident->value);
+    LLVMValueRef incoming[] = { value, outer };
+    LLVMBasicBlockRef blocks[] = { assigned_block, outer_block };
+    LLVMAddIncoming(phi, incoming, blocks, 2);
+    return phi;
+}
+
+// --- Functions ---
+
+static LLVMTypeRef function_type(Compiler* compiler, int parameter_count) {
+    LLVMTypeRef* params = malloc((parameter_count + 1) * sizeof(LLVMTypeRef));
+    for (int i = 0; i < parameter_count; i++) {
+        params[i] = compiler->value_type;
+    }
+    LLVMTypeRef type = LLVMFunctionType(compiler->value_type, params, parameter_count, 0);
+    free(params);
+    return type;
+}
+
+static void declare_function(Compiler* compiler, const char* name, int parameter_count) {
+    char symbol[256];
+    snprintf(symbol, sizeof(symbol), "omni.fn.%s", name);
+    LLVMValueRef function = LLVMAddFunction(compiler->main_module, symbol, function_type(compiler, parameter_count));
+    symbol_table_set(compiler->functions, name, function);
+}
+
+static void add_module(CompiledProgram* program, LLVMModuleRef module) {
+    program->modules = realloc(program->modules, (program->module_count + 1) * sizeof(LLVMModuleRef));
+    program->modules[program->module_count++] = module;
+}
+
+// Emits the body of the declared function `name`, into a module of its own
+// if `own_module` is set or else into the module being emitted into.
+static void compile_function_body(Compiler* compiler, const char* name, AST_Expression_Identifier** parameters,
+                                  int parameter_count, AST_Statement_Block* body, int own_module) {
+    LLVMBasicBlockRef saved_block = LLVMGetInsertBlock(compiler->builder);
+    LLVMValueRef saved_function = compiler->function;
+    LLVMBasicBlockRef saved_landing_pad = compiler->landing_pad;
+    SymbolTable* saved_locals = compiler->locals;
+    LLVMModuleRef saved_module = compiler->module;
+    LLVMMetadataRef saved_location = LLVMGetCurrentDebugLocation2(compiler->builder);
+    DebugInfo saved_debug = compiler->debug;
+
+    if (own_module) {
+        char module_name[256];
+        snprintf(module_name, sizeof(module_name), "omni.fn.%s", name);
+        compiler->module = LLVMModuleCreateWithNameInContext(module_name, compiler->context);
+        add_module(compiler->program, compiler->module);
+        debug_begin_module(compiler, compiler->module);
+    }
+
+    LLVMValueRef function = import_symbol(compiler, symbol_table_get(compiler->functions, name));
+    compiler->function = function;
+    compiler->landing_pad = NULL;
+    compiler->locals = compiler->local_scopes;
+    symbol_table_push_scope(compiler->locals);
+    LLVMBasicBlockRef entry = LLVMAppendBasicBlockInContext(compiler->context, function, "entry");
+    LLVMPositionBuilderAtEnd(compiler->builder, entry);
+    debug_begin_function(compiler, function, body ? body->base.token.line : 0);
+
+    for (int i = 0; i < parameter_count; i++) {
+        LLVMValueRef slot = LLVMBuildAlloca(compiler->builder, compiler->value_type, parameters[i]->value);
+        LLVMValueRef value = LLVMGetParam(function, i);
+        if (compiler->guard_types != NULL && is_speculated(compiler->guard_types[i])) {
+            value = specialize_value(compiler, value, compiler->guard_types[i]); // Guarded by the entry
+        }
+        LLVMBuildStore(compiler->builder, value, slot);
+        symbol_table_set(compiler->locals, parameters[i]->value, slot);
+    }
+
+    compile_block(compiler, body);
+    if (!block_is_terminated(compiler)) {
+        LLVMBuildRet(compiler->builder, nil_value(compiler)); // Falling off the end returns nil
+    }
+
+    symbol_table_pop_scope(compiler->locals);
+    if (own_module) debug_finish_module(compiler);
+    compiler->debug = saved_debug;
+    compiler->locals = saved_locals;
+    compiler->function = saved_function;
+    compiler->landing_pad = saved_landing_pad;
+    compiler->module = saved_module;
+    if (saved_block != NULL) {
+        LLVMPositionBuilderAtEnd(compiler->builder, saved_block);
+    }
+    LLVMSetCurrentDebugLocation2(compiler->builder, saved_location);
+}
+
+// Evaluates `count` expressions into a stack array and returns a pointer to its first element.
+static LLVMValueRef compile_value_array(Compiler* compiler, AST_Expression** exprs, int count) {
+    LLVMTypeRef array_type = LLVMArrayType(compiler->value_type, count ? count : 1);
+    LLVMValueRef array = build_entry_alloca(compiler, array_type, "values");
+
+    for (int i = 0; i < count; i++) {
+        LLVMValueRef value = compile_node(compiler, (AST_Node*)exprs[i]);
+        if (value == NULL) return NULL;
+        LLVMValueRef indices[] = { LLVMConstInt(i32_type(compiler), 0, 0), LLVMConstInt(i32_type(compiler), i, 0) };
+        LLVMValueRef element = LLVMBuildGEP2(compiler->builder, array_type, array, indices, 2, "");
+        LLVMBuildStore(compiler->builder, value, element);
+    }
+
+    LLVMValueRef indices[] = { LLVMConstInt(i32_type(compiler), 0, 0), LLVMConstInt(i32_type(compiler), 0, 0) };
+    return LLVMBuildGEP2(compiler->builder, array_type, array, indices, 2, "");
+}
+
+static LLVMValueRef compile_print(Compiler* compiler, AST_Expression_Call* call) {
+    LLVMValueRef values = compile_value_array(compiler, call->arguments, call->argument_count);
+    if (values == NULL) return NULL;
+    LLVMValueRef args[] = { values, LLVMConstInt(i32_type(compiler), call->argument_count, 0) };
+    call_runtime(compiler, "omni_print_values", LLVMVoidTypeInContext(compiler->context), args, 2);
+    return nil_value(compiler);
+}
+
+// --- Tier Bridges ---
+// Tiered code runs inside the interpreter: globals and calls go back to
+// the interpreter's environment by (interned) name, so compiled and
+// interpreted functions can call each other freely.
+
+static LLVMValueRef name_constant(Compiler* compiler, const char* name) {
+    LLVMTypeRef pointer_type = LLVMPointerType(LLVMInt8TypeInContext(compiler->context), 0);
+    return LLVMConstIntToPtr(LLVMConstInt(i64_type(compiler), (unsigned long long)(uintptr_t)name, 0), pointer_type);
+}
+
+// A loop entered through OSR keeps its variables in allocas, so the frame
+// and the interpreter's view of them are synced on exit and around every
+// call back into the interpreter.
+static LLVMValueRef frame_element(Compiler* compiler, int index) {
+    LLVMValueRef offset = LLVMConstInt(i32_type(compiler), index, 0);
+    return LLVMBuildGEP2(compiler->builder, compiler->value_type, compiler->frame_values, &offset, 1, "");
+}
+
+static void store_frame(Compiler* compiler) {
+    for (int i = 0; i < compiler->frame_count; i++) {
+        LLVMValueRef slot = symbol_table_get(compiler->frame, compiler->frame_names[i]);
+        LLVMValueRef value = LLVMBuildLoad2(compiler->builder, compiler->value_type, slot, "");
+        LLVMBuildStore(compiler->builder, value, frame_element(compiler, i));
+    }
+}
+
+static void load_frame(Compiler* compiler) {
+    for (int i = 0; i < compiler->frame_count; i++) {
+        LLVMValueRef slot = symbol_table_get(compiler->frame, compiler->frame_names[i]);
+        LLVMValueRef value = LLVMBuildLoad2(compiler->builder, compiler->value_type, frame_element(compiler, i), "");
+        LLVMBuildStore(compiler->builder, value, slot);
+    }
+}
+
+static void flush_frame(Compiler* compiler) {
+    if (compiler->frame == NULL) return;
+    store_frame(compiler);
+    call_runtime(compiler, "omni_osr_flush", LLVMVoidTypeInContext(compiler->context), &compiler->frame_handle, 1);
+}
+
+static void reload_frame(Compiler* compiler) {
+    if (compiler->frame == NULL) return;
+    call_runtime(compiler, "omni_osr_reload", LLVMVoidTypeInContext(compiler->context), &compiler->frame_handle, 1);
+    load_frame(compiler);
+}
+
+static void build_frame_exit(Compiler* compiler, TierExit exit) {
+    store_frame(compiler);
+    LLVMBuildRet(compiler->builder, LLVMConstInt(i32_type(compiler), exit, 0));
+}
+
+static LLVMValueRef compile_bridged_call(Compiler* compiler, const char* name, AST_Expression_Call* call) {
+    LLVMValueRef values = compile_value_array(compiler, call->arguments, call->argument_count);
+    if (values == NULL) return NULL;
+    LLVMValueRef args[] = {
+        name_constant(compiler, name), values, LLVMConstInt(i32_type(compiler), call->argument_count, 0),
+    };
+    flush_frame(compiler);
+    LLVMValueRef result = call_runtime(compiler, "omni_tier_call", compiler->value_type, args, 3);
+    set_call_hotness(compiler, result, &call->profile);
+    reload_frame(compiler);
+    return result;
+}
+
+static LLVMValueRef compile_call(Compiler* compiler, AST_Expression_Call* call) {
+    if (call->function->type != IDENTIFIER) {
+        compiler_error(compiler, "Only calls to named functions are supported by the compiler yet.");
+        return NULL;
+    }
+    const char* name = ((AST_Expression_Identifier*)call->function)->value;
+    if (compiler->tiered) {
+        if (((AST_Expression_Identifier*)call->function)->scope != SCOPE_GLOBAL) {
+            compiler_error(compiler, "Calls through local variables are not supported by the compiler yet.");
+            return NULL;
+        }
+        return compile_bridged_call(compiler, name, call);
+    }
+    if (name == compiler->print_name) {
+        return compile_print(compiler, call);
+    }
+
+    LLVMValueRef function = symbol_table_get(compiler->functions, name);
+    if (function == NULL) {
+        compiler_error(compiler, "Unknown function '%s'.", name);
+        return NULL;
+    }
+    function = import_symbol(compiler, function);
+    if ((int)LLVMCountParams(function) != call->argument_count) {
+        compiler_error(compiler, "Wrong number of arguments to '%s'. Expected %u, got %d.",
+                       name, LLVMCountParams(function), call->argument_count);
+        return NULL;
+    }
+
+    LLVMValueRef* args = malloc((call->argument_count + 1) * sizeof(LLVMValueRef));
+    for (int i = 0; i < call->argument_count; i++) {
+        args[i] = compile_node(compiler, (AST_Node*)call->arguments[i]);
+        if (args[i] == NULL) {
+            free(args);
+            return NULL;
+        }
+    }
+    LLVMValueRef result = build_call(compiler, function_type(compiler, call->argument_count), function, args,
+                                     call->argument_count, "calltmp");
+    free(args);
+    return result;
+}
+
+// --- Statements ---
+
+// Returns the value of the last statement, like the interpreter; NULL if it has none.
+static LLVMValueRef compile_block(Compiler* compiler, AST_Statement_Block* block) {
+    LLVMValueRef value = NULL;
+    if (block == NULL) return value;
+    for (int i = 0; i < block->statement_count; i++) {
+        if (block_is_terminated(compiler)) break; // Code after `return` is unreachable
+        value = compile_node(compiler, (AST_Node*)block->statements[i]);
+    }
+    return value;
+}
+
+// Adds the value a branch of an `if` ends with to the `if`'s result, unless the branch returned.
+static void add_branch_value(Compiler* compiler, LLVMValueRef* values, LLVMBasicBlockRef* blocks, int* count,
+                             LLVMValueRef value) {
+    if (block_is_terminated(compiler)) return;
+    values[*count] = value != NULL ? value : nil_value(compiler);
+    blocks[(*count)++] = LLVMGetInsertBlock(compiler->builder);
+}
+
+// At the top level an `if` evaluates to the branch it took, as it does in
+// the interpreter, so a program ending in one returns that branch's value.
+static LLVMValueRef compile_if(Compiler* compiler, AST_Statement_If* stmt) {
+    LLVMValueRef condition = compile_node(compiler, (AST_Node*)stmt->condition);
+    if (condition == NULL) return NULL;
+    LLVMValueRef values[2];
+    LLVMBasicBlockRef value_blocks[2];
+    int value_count = 0;
+
+    LLVMBasicBlockRef then_block = LLVMAppendBasicBlockInContext(compiler->context, compiler->function, "then");
+    LLVMBasicBlockRef else_block = LLVMAppendBasicBlockInContext(compiler->context, compiler->function, "else");
+    LLVMBasicBlockRef merge_block = LLVMAppendBasicBlockInContext(compiler->context, compiler->function, "ifcont");
+    LLVMValueRef branch = LLVMBuildCondBr(compiler->builder, build_truthy(compiler, condition), then_block, else_block);
+    set_branch_weights(compiler, branch, &stmt->profile);
+
+    LLVMPositionBuilderAtEnd(compiler->builder, then_block);
+    LLVMValueRef then_value = compile_block(compiler, stmt->consequence);
+    add_branch_value(compiler, values, value_blocks, &value_count, then_value);
+    if (!block_is_terminated(compiler)) LLVMBuildBr(compiler->builder, merge_block);
+
+    LLVMPositionBuilderAtEnd(compiler->builder, else_block);
+    LLVMValueRef else_value = NULL;
+    if (stmt->alternative != NULL) {
+        else_value = compile_node(compiler, (AST_Node*)stmt->alternative);
+    }
+    add_branch_value(compiler, values, value_blocks, &value_count, else_value);
+    if (!block_is_terminated(compiler)) LLVMBuildBr(compiler->builder, merge_block);
+
+    LLVMPositionBuilderAtEnd(compiler->builder, merge_block);
+    if (compiler->locals != NULL || value_count == 0) return NULL; // Nothing uses the value in functions
+    LLVMValueRef phi = LLVMBuildPhi(compiler->builder, compiler->value_type, "if.value");
+    LLVMAddIncoming(phi, values, value_blocks, value_count);
+    return phi;
+}
+
+// Emits the header of a loop entered through OSR: checks that every
+// speculated frame variable still has the type the loop was compiled for,
+// and leaves with TIER_EXIT_DEOPT otherwise so the interpreter can take over.
+static LLVMBasicBlockRef build_osr_guard(Compiler* compiler, LLVMBasicBlockRef cond_block) {
+    LLVMBasicBlockRef guard_block = LLVMAppendBasicBlockInContext(compiler->context, compiler->function, "osr.guard");
+    LLVMBasicBlockRef enter_block = LLVMAppendBasicBlockInContext(compiler->context, compiler->function, "osr.enter");
+    LLVMBasicBlockRef deopt_block = LLVMAppendBasicBlockInContext(compiler->context, compiler->function, "osr.deopt");
+    LLVMBasicBlockRef saved_block = LLVMGetInsertBlock(compiler->builder);
+
+    LLVMPositionBuilderAtEnd(compiler->builder, guard_block);
+    LLVMValueRef ok = LLVMConstInt(LLVMInt1TypeInContext(compiler->context), 1, 0);
+    for (int i = 0; i < compiler->frame_count; i++) {
+        if (!is_speculated(compiler->guard_types[i])) continue;
+        LLVMValueRef slot = symbol_table_get(compiler->frame, compiler->frame_names[i]);
+        LLVMValueRef value = LLVMBuildLoad2(compiler->builder, compiler->value_type, slot, compiler->frame_names[i]);
+        ok = LLVMBuildAnd(compiler->builder, ok, build_type_is(compiler, value, compiler->guard_types[i]), "");
+    }
+    LLVMBuildCondBr(compiler->builder, ok, enter_block, deopt_block);
+
+    LLVMPositionBuilderAtEnd(compiler->builder, enter_block);
+    for (int i = 0; i < compiler->frame_count; i++) {
+        if (!is_speculated(compiler->guard_types[i])) continue;
+        LLVMValueRef slot = symbol_table_get(compiler->frame, compiler->frame_names[i]);
+        LLVMValueRef value = LLVMBuildLoad2(compiler->builder, compiler->value_type, slot, compiler->frame_names[i]);
+        LLVMBuildStore(compiler->builder, specialize_value(compiler, value, compiler->guard_types[i]), slot);
+    }
+    LLVMBuildBr(compiler->builder, cond_block);
+
+    LLVMPositionBuilderAtEnd(compiler->builder, deopt_block);
+    build_frame_exit(compiler, TIER_EXIT_DEOPT);
+
+    LLVMPositionBuilderAtEnd(compiler->builder, saved_block);
+    return guard_block;
+}
+
+static void compile_while(Compiler* compiler, AST_Statement_While* stmt) {
+    LLVMBasicBlockRef cond_block = LLVMAppendBasicBlockInContext(compiler->context, compiler->function, "while.cond");
+    LLVMBasicBlockRef body_block = LLVMAppendBasicBlockInContext(compiler->context, compiler->function, "while.body");
+    LLVMBasicBlockRef end_block = LLVMAppendBasicBlockInContext(compiler->context, compiler->function, "while.end");
+    // Back-edges go through the guards, so a deopt always lands on an iteration boundary
+    LLVMBasicBlockRef header = stmt == compiler->osr_loop ? build_osr_guard(compiler, cond_block) : cond_block;
+    LLVMBuildBr(compiler->builder, header);
+
+    LLVMPositionBuilderAtEnd(compiler->builder, cond_block);
+    LLVMValueRef condition = compile_node(compiler, (AST_Node*)stmt->condition);
+    if (condition == NULL) return;
+    LLVMValueRef branch = LLVMBuildCondBr(compiler->builder, build_truthy(compiler, condition), body_block, end_block);
+    set_branch_weights(compiler, branch, &stmt->profile);
+
+    LLVMPositionBuilderAtEnd(compiler->builder, body_block);
+    compile_block(compiler, stmt->body);
+    if (!block_is_terminated(compiler)) LLVMBuildBr(compiler->builder, header);
+
+    LLVMPositionBuilderAtEnd(compiler->builder, end_block);
+}
+
+// The body's calls unwind to a landing pad that binds the error's message
+// and runs the handler; nothing is registered on the way in.
+static void compile_try(Compiler* compiler, AST_Statement_Try* stmt) {
+    LLVMBasicBlockRef pad_block = LLVMAppendBasicBlockInContext(compiler->context, compiler->function, "try.pad");
+    LLVMBasicBlockRef merge_block = LLVMAppendBasicBlockInContext(compiler->context, compiler->function, "try.cont");
+    LLVMBasicBlockRef outer = compiler->landing_pad;
+
+    compiler->landing_pad = pad_block;
+    compile_block(compiler, stmt->body);
+    compiler->landing_pad = outer;
+    if (!block_is_terminated(compiler)) LLVMBuildBr(compiler->builder, merge_block);
+
+    build_landing_pad(compiler, pad_block);
+    LLVMValueRef message = call_runtime(compiler, "omni_caught", compiler->value_type, NULL, 0);
+    if (stmt->name != NULL) {
+        LLVMValueRef slot = lookup_variable(compiler, stmt->name, 1);
+        if (slot == NULL) return;
+        LLVMBuildStore(compiler->builder, message, slot);
+    }
+    compile_block(compiler, stmt->handler);
+    if (!block_is_terminated(compiler)) LLVMBuildBr(compiler->builder, merge_block);
+
+    LLVMPositionBuilderAtEnd(compiler->builder, merge_block);
+}
+
+// --- Expressions ---
+
+// An operator: its runtime function, and how to compute it inline when both
+// operands are integers or both are floats (an opcode, or a comparison).
+typedef struct {
+    const char* operator;
+    const char* runtime;
+    LLVMOpcode integer_op, float_op; // 0 for comparisons
+    LLVMIntPredicate integer_predicate;
+    LLVMRealPredicate float_predicate;
+} InfixOperator;
+
+static const InfixOperator infix_operators[] = {
+    { "+", "omni_add", LLVMAdd, LLVMFAdd, 0, 0 },
+    { "-", "omni_subtract", LLVMSub, LLVMFSub, 0, 0 },
+    { "*", "omni_multiply", LLVMMul, LLVMFMul, 0, 0 },
+    { "/", "omni_divide", LLVMSDiv, LLVMFDiv, 0, 0 },
+    { "==", "omni_equal", 0, 0, LLVMIntEQ, LLVMRealOEQ },
+    { "!=", "omni_not_equal", 0, 0, LLVMIntNE, LLVMRealUNE },
+    { "<", "omni_less_than", 0, 0, LLVMIntSLT, LLVMRealOLT },
+    { ">", "omni_greater_than", 0, 0, LLVMIntSGT, LLVMRealOGT },
+    { "<=", "omni_less_than_equal", 0, 0, LLVMIntSLE, LLVMRealOLE },
+    { ">=", "omni_greater_than_equal", 0, 0, LLVMIntSGE, LLVMRealOGE },
+};
+
+// Computes `op` inline on two integer (is_float = 0) or float payloads.
+static LLVMValueRef build_fast_infix(Compiler* compiler, const InfixOperator* op, LLVMValueRef left,
+                                     LLVMValueRef right, int is_float) {
+    LLVMTypeRef double_type = LLVMDoubleTypeInContext(compiler->context);
+    if (is_float) {
+        left = LLVMBuildBitCast(compiler->builder, left, double_type, "");
+        right = LLVMBuildBitCast(compiler->builder, right, double_type, "");
+    }
+    if (op->integer_op == 0) {
+        LLVMValueRef result = is_float ? LLVMBuildFCmp(compiler->builder, op->float_predicate, left, right, "")
+                                       : LLVMBuildICmp(compiler->builder, op->integer_predicate, left, right, "");
+        return make_value(compiler, OMNI_BOOLEAN, LLVMBuildZExt(compiler->builder, result, i64_type(compiler), ""));
+    }
+    if (!is_float) {
+        return make_value(compiler, OMNI_INTEGER, LLVMBuildBinOp(compiler->builder, op->integer_op, left, right, ""));
+    }
+    LLVMValueRef result = LLVMBuildBinOp(compiler->builder, op->float_op, left, right, "");
+    return make_value(compiler, OMNI_FLOAT, LLVMBuildBitCast(compiler->builder, result, i64_type(compiler), ""));
+}
+
+// Emits `op` with guarded inline paths for integer and float operands and a
+// call to the runtime for everything else (mixed operands, strings, division
+// by zero, ...). On operands of known type all but one path fold away.
+// Integer arithmetic wraps like the runtime's, so it needs no overflow check.
+static LLVMValueRef build_infix(Compiler* compiler, const InfixOperator* op, LLVMValueRef left, LLVMValueRef right) {
+    LLVMBasicBlockRef integer_block = LLVMAppendBasicBlockInContext(compiler->context, compiler->function, "infix.int");
+    LLVMBasicBlockRef check_float_block = LLVMAppendBasicBlockInContext(compiler->context, compiler->function, "infix.check_float");
+    LLVMBasicBlockRef float_block = LLVMAppendBasicBlockInContext(compiler->context, compiler->function, "infix.float");
+    LLVMBasicBlockRef generic_block = LLVMAppendBasicBlockInContext(compiler->context, compiler->function, "infix.generic");
+    LLVMBasicBlockRef merge_block = LLVMAppendBasicBlockInContext(compiler->context, compiler->function, "infix.cont");
+
+    LLVMValueRef left_payload = LLVMBuildExtractValue(compiler->builder, left, 1, "");
+    LLVMValueRef right_payload = LLVMBuildExtractValue(compiler->builder, right, 1, "");
+    // Division by zero is left to the runtime, which reports it, and so is
+    // division by -1, which wraps there (LLONG_MIN / -1 traps in sdiv)
+    LLVMValueRef divisible = LLVMConstInt(LLVMInt1TypeInContext(compiler->context), 1, 0);
+    LLVMValueRef float_divisible = divisible;
+    if (op->integer_op == LLVMSDiv) {
+        LLVMValueRef zero = LLVMConstInt(i64_type(compiler), 0, 0);
+        LLVMValueRef minus_one = LLVMConstInt(i64_type(compiler), (unsigned long long)-1LL, 1);
+        divisible = LLVMBuildAnd(compiler->builder,
+                                 LLVMBuildICmp(compiler->builder, LLVMIntNE, right_payload, zero, ""),
+                                 LLVMBuildICmp(compiler->builder, LLVMIntNE, right_payload, minus_one, ""), "");
+        // Neither 0.0 nor -0.0: some bit other than the sign is set
+        LLVMValueRef magnitude = LLVMBuildShl(compiler->builder, right_payload, LLVMConstInt(i64_type(compiler), 1, 0), "");
+        float_divisible = LLVMBuildICmp(compiler->builder, LLVMIntNE, magnitude, zero, "");
+    }
+
+    LLVMValueRef both_integers = LLVMBuildAnd(compiler->builder, build_type_is(compiler, left, OMNI_INTEGER),
+                                              build_type_is(compiler, right, OMNI_INTEGER), "");
+    LLVMBuildCondBr(compiler->builder, LLVMBuildAnd(compiler->builder, both_integers, divisible, ""),
+                    integer_block, check_float_block);
+
+    LLVMPositionBuilderAtEnd(compiler->builder, check_float_block);
+    LLVMValueRef both_floats = LLVMBuildAnd(compiler->builder, build_type_is(compiler, left, OMNI_FLOAT),
+                                            build_type_is(compiler, right, OMNI_FLOAT), "");
+    LLVMBuildCondBr(compiler->builder, LLVMBuildAnd(compiler->builder, both_floats, float_divisible, ""),
+                    float_block, generic_block);
+
+    LLVMPositionBuilderAtEnd(compiler->builder, integer_block);
+    LLVMValueRef integer_result = build_fast_infix(compiler, op, left_payload, right_payload, 0);
+    LLVMBuildBr(compiler->builder, merge_block);
+
+    LLVMPositionBuilderAtEnd(compiler->builder, float_block);
+    LLVMValueRef float_result = build_fast_infix(compiler, op, left_payload, right_payload, 1);
+    LLVMBuildBr(compiler->builder, merge_block);
+
+    LLVMPositionBuilderAtEnd(compiler->builder, generic_block);
+    LLVMValueRef generic_result = call_binary(compiler, op->runtime, left, right);
+    generic_block = LLVMGetInsertBlock(compiler->builder); // Past the invoke inside a `try`
+    LLVMBuildBr(compiler->builder, merge_block);
+
+    LLVMPositionBuilderAtEnd(compiler->builder, merge_block);
+    LLVMValueRef result = LLVMBuildPhi(compiler->builder, compiler->value_type, "infix");
+    LLVMValueRef values[] = { integer_result, float_result, generic_result };
+    LLVMBasicBlockRef blocks[] = { integer_block, float_block, generic_block };
+    LLVMAddIncoming(result, values, blocks, 3);
+    return result;
+}
+
+static LLVMValueRef compile_infix(Compiler* compiler, AST_Expression_Infix* expr) {
+    LLVMValueRef left = compile_node(compiler, (AST_Node*)expr->left);
+    LLVMValueRef right = compile_node(compiler, (AST_Node*)expr->right);
+    if (left == NULL || right == NULL) return NULL;
+
+    for (size_t i = 0; i < sizeof(infix_operators) / sizeof(infix_operators[0]); i++) {
+        const InfixOperator* op = &infix_operators[i];
+        if (strcmp(expr->operator, op->operator) != 0) continue;
+
+        // Statically numeric operands go straight to the inline path; division
+        // keeps its guarded form for the zero check.
+        AST_StaticType left_type = expr->left->static_type, right_type = expr->right->static_type;
+        int numeric = (left_type == STATIC_INTEGER || left_type == STATIC_FLOAT) &&
+                      (right_type == STATIC_INTEGER || right_type == STATIC_FLOAT);
+        if (numeric && op->integer_op != LLVMSDiv) {
+            if (left_type == STATIC_INTEGER && right_type == STATIC_INTEGER) {
+                return build_fast_infix(compiler, op, LLVMBuildExtractValue(compiler->builder, left, 1, ""),
+                                        LLVMBuildExtractValue(compiler->builder, right, 1, ""), 0);
+            }
+            return build_fast_infix(compiler, op, static_double(compiler, expr->left, left),
+                                    static_double(compiler, expr->right, right), 1);
+        }
+        return build_infix(compiler, op, left, right);
+    }
+    compiler_error(compiler, "Unknown infix operator: %s", expr->operator);
+    return NULL;
+}
+
+static LLVMValueRef compile_prefix(Compiler* compiler, AST_Expression_Prefix* expr) {
+    LLVMValueRef right = compile_node(compiler, (AST_Node*)expr->right);
+    if (right == NULL) return NULL;
+
+    if (strcmp(expr->operator, "-") == 0) {
+        LLVMValueRef payload = LLVMBuildExtractValue(compiler->builder, right, 1, "");
+        if (expr->right->static_type == STATIC_INTEGER) {
+            return make_value(compiler, OMNI_INTEGER, LLVMBuildNeg(compiler->builder, payload, ""));
+        } else if (expr->right->static_type == STATIC_FLOAT) {
+            LLVMTypeRef double_type = LLVMDoubleTypeInContext(compiler->context);
+            LLVMValueRef negated = LLVMBuildFNeg(compiler->builder, LLVMBuildBitCast(compiler->builder, payload, double_type, ""), "");
+            return make_value(compiler, OMNI_FLOAT, LLVMBuildBitCast(compiler->builder, negated, i64_type(compiler), ""));
+        }
+        return call_runtime(compiler, "omni_negate", compiler->value_type, &right, 1);
+    } else if (strcmp(expr->operator, "!") == 0) {
+        LLVMValueRef falsy = LLVMBuildNot(compiler->builder, build_truthy(compiler, right), "not");
+        return make_value(compiler, OMNI_BOOLEAN, LLVMBuildZExt(compiler->builder, falsy, i64_type(compiler), ""));
+    }
+    compiler_error(compiler, "Unknown prefix operator: %s", expr->operator);
+    return NULL;
+}
+
+void compiled_program_dispose(CompiledProgram* program) {
+    if (program == NULL) return;
+    for (int i = 0; i < program->module_count; i++) {
+        if (program->modules[i] != NULL) LLVMDisposeModule(program->modules[i]);
+    }
+    free(program->modules);
+    free(program);
+}
+
+static void compiler_init(Compiler* compiler, LLVMContextRef context, const char* module_name) {
+    compiler->context = context;
+    compiler->main_module = LLVMModuleCreateWithNameInContext(module_name, compiler->context);
+    compiler->module = compiler->main_module;
+    compiler->builder = LLVMCreateBuilderInContext(compiler->context);
+    compiler->value_type = LLVMGetTypeByName2(compiler->context, "OmniValue");
+    if (compiler->value_type == NULL) {
+        compiler->value_type = LLVMStructCreateNamed(compiler->context, "OmniValue");
+        LLVMTypeRef fields[] = { i32_type(compiler), i64_type(compiler) };
+        LLVMStructSetBody(compiler->value_type, fields, 2, 0);
+    }
+    compiler->program = calloc(1, sizeof(CompiledProgram));
+    add_module(compiler->program, compiler->main_module);
+    compiler->globals = symbol_table_create(SYMBOL_TABLE_CAPACITY);
+    compiler->functions = symbol_table_create(SYMBOL_TABLE_CAPACITY);
+    compiler->locals = NULL;
+    compiler->local_scopes = symbol_table_create(SYMBOL_TABLE_CAPACITY);
+    compiler->function = NULL;
+    compiler->landing_pad = NULL;
+    compiler->print_name = intern("print");
+    compiler->tiered = 0;
+    compiler->guard_types = NULL;
+    compiler->osr_loop = NULL;
+    compiler->frame = NULL;
+    compiler->frame_names = NULL;
+    compiler->frame_count = 0;
+    compiler->frame_values = NULL;
+    compiler->frame_handle = NULL;
+    compiler->error_count = 0;
+    debug_begin_module(compiler, compiler->main_module);
+}
+
+// Releases the compiler state; returns 1 if every module was emitted and verifies.
+static int compiler_finish(Compiler* compiler) {
+    // Clean up the builder
+    debug_finish_module(compiler);
+    LLVMDisposeBuilder(compiler->builder);
+    symbol_table_destroy(compiler->globals);
+    symbol_table_destroy(compiler->functions);
+    symbol_table_destroy(compiler->local_scopes);
+
+    if (compiler->error_count > 0) {
+        compiled_program_dispose(compiler->program);
+        return 0;
+    }
+
+    // Verify the generated code, checking for consistency
+    LLVMVerifierFailureAction action = compiler->tiered ? LLVMReturnStatusAction : LLVMPrintMessageAction;
+    for (int i = 0; i < compiler->program->module_count; i++) {
+        char *error = NULL;
+        if (LLVMVerifyModule(compiler->program->modules[i], action, &error)) {
+            LLVMDisposeMessage(error);
+            compiled_program_dispose(compiler->program);
+            return 0;
+        }
+        LLVMDisposeMessage(error);
+    }
+    return 1;
+}
 
-LLVMModuleRef compile_to_llvm_ir(AST_Node* ast) {
+// Declares the globals a top-level statement assigns, inside its blocks
+// too, so reads compiled before the assignment find them.
+static void declare_globals(Compiler* compiler, AST_Statement* stmt) {
+    if (stmt == NULL) return;
+    switch (stmt->type) {
+        case SET_STATEMENT:
+        case ASSIGN_STATEMENT: {
+            AST_Statement_Set* set = (AST_Statement_Set*)stmt;
+            if (set->value == NULL || set->value->type != FN_LITERAL) get_global(compiler, set->name->value, 1);
+            break;
+        }
+        case BLOCK_STATEMENT: {
+            AST_Statement_Block* block = (AST_Statement_Block*)stmt;
+            for (int i = 0; i < block->statement_count; i++) declare_globals(compiler, block->statements[i]);
+            break;
+        }
+        case IF_STATEMENT:
+            declare_globals(compiler, (AST_Statement*)((AST_Statement_If*)stmt)->consequence);
+            declare_globals(compiler, ((AST_Statement_If*)stmt)->alternative);
+            break;
+        case WHILE_STATEMENT:
+            declare_globals(compiler, (AST_Statement*)((AST_Statement_While*)stmt)->body);
+            break;
+        case TRY_STATEMENT: {
+            AST_Statement_Try* try_stmt = (AST_Statement_Try*)stmt;
+            declare_globals(compiler, (AST_Statement*)try_stmt->body);
+            if (try_stmt->name != NULL) get_global(compiler, try_stmt->name->value, 1);
+            declare_globals(compiler, (AST_Statement*)try_stmt->handler);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+CompiledProgram* compile_to_llvm_ir(AST_Node* ast, LLVMContextRef context) {
     if (ast == NULL) {
         fprintf(stderr, "Cannot compile a NULL AST.\n");
         return NULL;
     }
+    AST_Program* program = (AST_Program*)ast;
+    resolve_program(program);
+    infer_types(program, NULL);
 
     Compiler compiler;
-    compiler.module = LLVMModuleCreateWithName("omni_module");
-    compiler.builder = LLVMCreateBuilder();
+    compiler_init(&compiler, context, "omni_module");
+
+    // Declare every top-level function and variable first, so bodies can
+    // refer to functions and globals defined further down the file.
+    for (int i = 0; i < program->statement_count; i++) {
+        AST_Statement* stmt = program->statements[i];
+        if (stmt == NULL) continue;
+        if (stmt->type == FN_DEFINITION) {
+            AST_Statement_FnDef* fn = (AST_Statement_FnDef*)stmt;
+            declare_function(&compiler, fn->name->value, fn->parameter_count);
+        } else if ((stmt->type == SET_STATEMENT || stmt->type == ASSIGN_STATEMENT) &&
+                   ((AST_Statement_Set*)stmt)->value != NULL && ((AST_Statement_Set*)stmt)->value->type == FN_LITERAL) {
+            AST_Statement_Set* set = (AST_Statement_Set*)stmt;
+            AST_Expression_FnLiteral* fn = (AST_Expression_FnLiteral*)set->value;
+            declare_function(&compiler, set->name->value, fn->parameter_count);
+        } else {
+            declare_globals(&compiler, stmt);
+        }
+    }
 
     // Create a main function
-    LLVMTypeRef main_func_type = LLVMFunctionType(LLVMInt32Type(), NULL, 0, 0);
-    LLVMValueRef main_func = LLVMAddFunction(compiler.module, "main", main_func_type);
-    
+    LLVMTypeRef main_func_type = LLVMFunctionType(i64_type(&compiler), NULL, 0, 0);
+    LLVMValueRef main_func = LLVMAddFunction(compiler.main_module, "main", main_func_type);
+    compiler.function = main_func;
+
     // Create a basic block to start inserting code into
-    LLVMBasicBlockRef entry = LLVMAppendBasicBlock(main_func, "entry");
+    LLVMBasicBlockRef entry = LLVMAppendBasicBlockInContext(compiler.context, main_func, "entry");
     LLVMPositionBuilderAtEnd(compiler.builder, entry);
+    debug_begin_function(&compiler, main_func, 1);
 
     // --- Start compiling the AST ---
-    AST_Program* program = (AST_Program*)ast;
     LLVMValueRef last_value = NULL;
     for (int i = 0; i < program->statement_count; i++) {
         // Cast the specific statement pointer to the generic AST_Node pointer
@@ -47,30 +1146,136 @@ LLVMModuleRef compile_to_llvm_ir(AST_Node* ast) {
     }
 
     // Use the last evaluated expression as the return value
-    if (last_value) {
-        LLVMBuildRet(compiler.builder, last_value);
-    } else {
-        // If there was no expression, return 0
-        LLVMBuildRet(compiler.builder, LLVMConstInt(LLVMInt32Type(), 0, 0));
+    if (!block_is_terminated(&compiler)) {
+        if (last_value) {
+            LLVMBuildRet(compiler.builder, call_runtime(&compiler, "omni_as_integer", i64_type(&compiler), &last_value, 1));
+        } else {
+            // If there was no expression, return 0
+            LLVMBuildRet(compiler.builder, LLVMConstInt(i64_type(&compiler), 0, 0));
+        }
     }
     // --- End compiling ---
-    
-    // Verify the generated code, checking for consistency
-    char *error = NULL;
-    LLVMVerifyModule(compiler.module, LLVMAbortProcessAction, &error);
-    LLVMDisposeMessage(error);
 
-    // Clean up the builder
-    LLVMDisposeBuilder(compiler.builder);
+    if (!compiler_finish(&compiler)) {
+        return NULL;
+    }
 
     printf("Compiler: Successfully generated LLVM IR.\n");
-    LLVMDumpModule(compiler.module); // Print the IR to console for debugging
+    for (int i = 0; i < compiler.program->module_count; i++) {
+        LLVMDumpModule(compiler.program->modules[i]); // Print the IR to console for debugging
+    }
+
+    return compiler.program;
+}
+
+CompiledProgram* compile_function_to_llvm_ir(const char* symbol, AST_Expression_Identifier** parameters,
+                                             int parameter_count, AST_Statement_Block* body,
+                                             const OmniType* guard_types, LLVMContextRef context) {
+    Compiler compiler;
+    compiler_init(&compiler, context, symbol);
+    compiler.tiered = 1;
+    compiler.guard_types = guard_types;
+
+    // The function itself, taking and returning OmniValues...
+    LLVMValueRef function = LLVMAddFunction(compiler.main_module, symbol, function_type(&compiler, parameter_count));
+    symbol_table_set(compiler.functions, intern(symbol), function);
+    compile_function_body(&compiler, intern(symbol), parameters, parameter_count, body, 0);
+
+    // ...and its entry point, which reads the arguments from an array so the
+    // interpreter can call functions of any arity through one signature, and
+    // guards the speculated argument types.
+    char entry_symbol[256];
+    snprintf(entry_symbol, sizeof(entry_symbol), "%s.entry", symbol);
+    LLVMTypeRef entry_params[] = { LLVMPointerType(compiler.value_type, 0), LLVMPointerType(compiler.value_type, 0) };
+    LLVMValueRef entry = LLVMAddFunction(compiler.main_module, entry_symbol,
+                                         LLVMFunctionType(i32_type(&compiler), entry_params, 2, 0));
+    LLVMPositionBuilderAtEnd(compiler.builder, LLVMAppendBasicBlockInContext(compiler.context, entry, "entry"));
+    debug_begin_function(&compiler, entry, body ? body->base.token.line : 0);
+    LLVMBasicBlockRef call_block = LLVMAppendBasicBlockInContext(compiler.context, entry, "call");
+    LLVMBasicBlockRef deopt_block = LLVMAppendBasicBlockInContext(compiler.context, entry, "deopt");
+
+    LLVMValueRef* args = malloc((parameter_count + 1) * sizeof(LLVMValueRef));
+    LLVMValueRef ok = LLVMConstInt(LLVMInt1TypeInContext(compiler.context), 1, 0);
+    for (int i = 0; i < parameter_count; i++) {
+        LLVMValueRef index = LLVMConstInt(i32_type(&compiler), i, 0);
+        LLVMValueRef element = LLVMBuildGEP2(compiler.builder, compiler.value_type, LLVMGetParam(entry, 0), &index, 1, "");
+        args[i] = LLVMBuildLoad2(compiler.builder, compiler.value_type, element, "");
+        if (guard_types != NULL && is_speculated(guard_types[i])) {
+            ok = LLVMBuildAnd(compiler.builder, ok, build_type_is(&compiler, args[i], guard_types[i]), "");
+        }
+    }
+    LLVMBuildCondBr(compiler.builder, ok, call_block, deopt_block);
+
+    LLVMPositionBuilderAtEnd(compiler.builder, call_block);
+    LLVMValueRef result = LLVMBuildCall2(compiler.builder, function_type(&compiler, parameter_count),
+                                         function, args, parameter_count, "");
+    LLVMBuildStore(compiler.builder, result, LLVMGetParam(entry, 1));
+    LLVMBuildRet(compiler.builder, LLVMConstInt(i32_type(&compiler), TIER_EXIT_DONE, 0));
+    free(args);
+
+    LLVMPositionBuilderAtEnd(compiler.builder, deopt_block);
+    LLVMBuildRet(compiler.builder, LLVMConstInt(i32_type(&compiler), TIER_EXIT_DEOPT, 0));
+
+    if (!compiler_finish(&compiler)) {
+        return NULL;
+    }
+    return compiler.program;
+}
+
+CompiledProgram* compile_loop_to_llvm_ir(const char* symbol, AST_Statement_While* loop, const char** names,
+                                         const OmniType* guard_types, int count, LLVMContextRef context) {
+    Compiler compiler;
+    compiler_init(&compiler, context, symbol);
+    compiler.tiered = 1;
+    compiler.osr_loop = loop;
+    compiler.frame_names = names;
+    compiler.guard_types = guard_types;
+    compiler.frame_count = count;
+
+    LLVMTypeRef params[] = {
+        LLVMPointerType(compiler.value_type, 0), LLVMPointerType(LLVMInt8TypeInContext(compiler.context), 0),
+    };
+    LLVMValueRef function = LLVMAddFunction(compiler.main_module, symbol, LLVMFunctionType(i32_type(&compiler), params, 2, 0));
+    compiler.function = function;
+    compiler.frame_handle = LLVMGetParam(function, 1);
+    LLVMPositionBuilderAtEnd(compiler.builder, LLVMAppendBasicBlockInContext(compiler.context, function, "entry"));
+    debug_begin_function(&compiler, function, loop->base.token.line);
+
+    compiler.frame_values = LLVMGetParam(function, 0);
+    compiler.frame = symbol_table_create(SYMBOL_TABLE_CAPACITY);
+    for (int i = 0; i < count; i++) {
+        symbol_table_set(compiler.frame, names[i], LLVMBuildAlloca(compiler.builder, compiler.value_type, names[i]));
+    }
+    load_frame(&compiler);
+
+    // An error leaving the loop hands its variables back before unwinding on
+    LLVMBasicBlockRef unwind_block = LLVMAppendBasicBlockInContext(compiler.context, function, "osr.unwind");
+    compiler.landing_pad = unwind_block;
+    compile_while(&compiler, loop);
+    if (!block_is_terminated(&compiler)) {
+        build_frame_exit(&compiler, TIER_EXIT_DONE);
+    }
+    compiler.landing_pad = NULL;
+    if (LLVMGetFirstUse(LLVMBasicBlockAsValue(unwind_block)) == NULL) {
+        LLVMDeleteBasicBlock(unwind_block);
+    } else {
+        LLVMValueRef pad = build_landing_pad(&compiler, unwind_block);
+        flush_frame(&compiler);
+        LLVMBuildResume(compiler.builder, pad);
+    }
+    symbol_table_destroy(compiler.frame);
 
-    return compiler.module;
+    if (!compiler_finish(&compiler)) {
+        return NULL;
+    }
+    return compiler.program;
 }
 
 LLVMValueRef compile_node(Compiler* compiler, AST_Node* node) {
     if (node == NULL) return NULL;
+    if (node->type < IDENTIFIER) { // A statement
+        debug_set_line(compiler, ((AST_Statement*)node)->token.line);
+    }
 
     switch (node->type) {
         case EXPRESSION_STATEMENT: {
@@ -78,32 +1283,122 @@ LLVMValueRef compile_node(Compiler* compiler, AST_Node* node) {
             return compile_node(compiler, (AST_Node*)stmt->expression);
         }
 
-        case INTEGER_LITERAL: {
-            AST_Expression_IntegerLiteral* literal = (AST_Expression_IntegerLiteral*)node;
-            return LLVMConstInt(LLVMInt32Type(), literal->value, 0);
-        }
-
-        case INFIX_EXPRESSION: {
-            AST_Expression_Infix* expr = (AST_Expression_Infix*)node;
-            LLVMValueRef left = compile_node(compiler, (AST_Node*)expr->left);
-            LLVMValueRef right = compile_node(compiler, (AST_Node*)expr->right);
-
-            if (strcmp(expr->operator, "+") == 0) {
-                return LLVMBuildAdd(compiler->builder, left, right, "addtmp");
-            } else if (strcmp(expr->operator, "-") == 0) {
-                return LLVMBuildSub(compiler->builder, left, right, "subtmp");
-            } else if (strcmp(expr->operator, "*") == 0) {
-                return LLVMBuildMul(compiler->builder, left, right, "multmp");
-            } else if (strcmp(expr->operator, "/") == 0) {
-                return LLVMBuildSDiv(compiler->builder, left, right, "divtmp"); // Signed division
-            } else {
-                fprintf(stderr, "Compiler Error: Unknown infix operator: %s\n", expr->operator);
+        case SET_STATEMENT:
+        case ASSIGN_STATEMENT: { // Resolved to the variable either one writes
+            AST_Statement_Set* stmt = (AST_Statement_Set*)node;
+            if (stmt->value != NULL && stmt->value->type == FN_LITERAL) {
+                if (compiler->locals != NULL || compiler->frame != NULL) {
+                    compiler_error(compiler, "Nested functions are not supported by the compiler yet.");
+                    return NULL;
+                }
+                AST_Expression_FnLiteral* fn = (AST_Expression_FnLiteral*)stmt->value;
+                compile_function_body(compiler, stmt->name->value, fn->parameters, fn->parameter_count, fn->body, 1);
+                return NULL;
+            }
+            LLVMValueRef value = compile_node(compiler, (AST_Node*)stmt->value);
+            LLVMValueRef slot = lookup_variable(compiler, stmt->name, 1);
+            if (value == NULL || slot == NULL) return NULL;
+            LLVMBuildStore(compiler->builder, value, slot);
+            return value; // Like the interpreter, `set` evaluates to the assigned value
+        }
+
+        case FN_DEFINITION: {
+            AST_Statement_FnDef* fn = (AST_Statement_FnDef*)node;
+            if (compiler->locals != NULL || compiler->frame != NULL) {
+                compiler_error(compiler, "Nested functions are not supported by the compiler yet.");
                 return NULL;
             }
+            compile_function_body(compiler, fn->name->value, fn->parameters, fn->parameter_count, fn->body, 1);
+            return NULL;
+        }
+
+        case RETURN_STATEMENT: {
+            AST_Statement_Return* stmt = (AST_Statement_Return*)node;
+            if (compiler->locals == NULL) {
+                compiler_error(compiler, "'return' outside of a function.");
+                return NULL;
+            }
+            LLVMValueRef value = stmt->return_value ? compile_node(compiler, (AST_Node*)stmt->return_value)
+                                                    : nil_value(compiler);
+            if (value == NULL) return NULL;
+            LLVMBuildRet(compiler->builder, value);
+            return NULL;
         }
 
+        case BLOCK_STATEMENT:
+            compile_block(compiler, (AST_Statement_Block*)node);
+            return NULL;
+
+        case IF_STATEMENT:
+            return compile_if(compiler, (AST_Statement_If*)node);
+
+        case WHILE_STATEMENT:
+            compile_while(compiler, (AST_Statement_While*)node);
+            return NULL;
+
+        case TRY_STATEMENT:
+            compile_try(compiler, (AST_Statement_Try*)node);
+            return NULL;
+
+        case IDENTIFIER: {
+            AST_Expression_Identifier* ident = (AST_Expression_Identifier*)node;
+            if (compiler->tiered && ident->scope == SCOPE_GLOBAL &&
+                (compiler->frame == NULL || symbol_table_get(compiler->frame, ident->value) == NULL)) {
+                LLVMValueRef name = name_constant(compiler, ident->value);
+                LLVMValueRef value = call_runtime(compiler, "omni_tier_get_global", compiler->value_type, &name, 1);
+                return static_value(compiler, (AST_Expression*)ident, value);
+            }
+            if (ident->outer != SCOPE_UNRESOLVED) {
+                LLVMValueRef value = load_local_or_outer(compiler, ident);
+                return value ? static_value(compiler, (AST_Expression*)ident, value) : NULL;
+            }
+            if (is_undefined(compiler, ident)) return build_undefined(compiler, ident);
+            LLVMValueRef slot = lookup_variable(compiler, ident, 0);
+            if (slot == NULL) return NULL;
+            LLVMValueRef value = LLVMIsAGlobalVariable(slot)
+                                 ? load_global(compiler, slot, ident)
+                                 : LLVMBuildLoad2(compiler->builder, compiler->value_type, slot, ident->value);
+            return static_value(compiler, (AST_Expression*)ident, value);
+        }
+
+        case INTEGER_LITERAL: {
+            AST_Expression_IntegerLiteral* literal = (AST_Expression_IntegerLiteral*)node;
+            return const_value(compiler, OMNI_INTEGER, (unsigned long long)literal->value);
+        }
+
+        case FLOAT_LITERAL: {
+            AST_Expression_FloatLiteral* literal = (AST_Expression_FloatLiteral*)node;
+            unsigned long long bits;
+            memcpy(&bits, &literal->value, sizeof(bits));
+            return const_value(compiler, OMNI_FLOAT, bits);
+        }
+
+        case BOOLEAN_LITERAL: {
+            AST_Expression_Boolean* literal = (AST_Expression_Boolean*)node;
+            return const_value(compiler, OMNI_BOOLEAN, literal->value ? 1 : 0);
+        }
+
+        case NIL_LITERAL:
+            return nil_value(compiler);
+
+        case STRING_LITERAL: {
+            // Strings are interned by the runtime, so pointer equality holds across engines
+            AST_Expression_StringLiteral* literal = (AST_Expression_StringLiteral*)node;
+            LLVMValueRef chars = LLVMBuildGlobalStringPtr(compiler->builder, literal->value, "str");
+            return call_runtime(compiler, "omni_new_string", compiler->value_type, &chars, 1);
+        }
+
+        case INFIX_EXPRESSION:
+            return compile_infix(compiler, (AST_Expression_Infix*)node);
+
+        case PREFIX_EXPRESSION:
+            return compile_prefix(compiler, (AST_Expression_Prefix*)node);
+
+        case CALL_EXPRESSION:
+            return compile_call(compiler, (AST_Expression_Call*)node);
+
         default:
-            fprintf(stderr, "Compiler Error: Unrecognized AST node type: %d\n", node->type);
+            compiler_error(compiler, "Unsupported AST node type: %d", node->type);
             return NULL;
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,532 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "inliner.h"
+#include "resolver.h"
+
+typedef struct {
+    const char* name; // Interned
+    AST_Expression_Identifier** parameters;
+    int parameter_count;
+    AST_Expression** body; // The returned expression; inlining inside it updates it
+    int defined_at;        // Index of the defining top-level statement
+    int escapes;           // Referenced other than as the callee of a call
+} Candidate;
+
+// A function around the call site being considered, innermost first.
+typedef struct EnclosingFunction {
+    struct EnclosingFunction* enclosing;
+    AST_Expression_Identifier** parameters;
+    int parameter_count;
+    AST_Statement_Block* body;
+} EnclosingFunction;
+
+typedef struct {
+    Candidate* candidates;
+    int candidate_count;
+    int finding_escapes; // First pass: only mark candidates that escape
+
+    EnclosingFunction* function; // NULL in top-level code
+    int statement_index;         // Top-level statement being visited
+    int loop_depth;
+    int depth;                   // Inlined bodies being visited
+    int inlined;
+} Inliner;
+
+// --- Declarations ---
+
+// Whether `name` would resolve to a variable of one of the functions around the call site.
+static int shadowed(EnclosingFunction* function, const char* name) {
+    for (; function != NULL; function = function->enclosing) {
+        for (int i = 0; i < function->parameter_count; i++) {
+            if (function->parameters[i]->value == name) return 1;
+        }
+        if (function->body != NULL && statement_binds((AST_Statement*)function->body, name)) return 1;
+    }
+    return 0;
+}
+
+// --- Candidates ---
+
+// Node count of an expression the inliner can copy, or -1.
+static int expression_size(AST_Expression* expr) {
+    if (expr == NULL) return -1;
+    switch (expr->type) {
+        case IDENTIFIER: case INTEGER_LITERAL: case FLOAT_LITERAL: case STRING_LITERAL:
+        case BOOLEAN_LITERAL: case NIL_LITERAL:
+            return 1;
+        case INFIX_EXPRESSION: {
+            int left = expression_size(((AST_Expression_Infix*)expr)->left);
+            int right = expression_size(((AST_Expression_Infix*)expr)->right);
+            return left < 0 || right < 0 ? -1 : left + right + 1;
+        }
+        case PREFIX_EXPRESSION: {
+            int right = expression_size(((AST_Expression_Prefix*)expr)->right);
+            return right < 0 ? -1 : right + 1;
+        }
+        case CALL_EXPRESSION: {
+            AST_Expression_Call* call = (AST_Expression_Call*)expr;
+            if (call->function->type != IDENTIFIER) return -1;
+            int size = 2;
+            for (int i = 0; i < call->argument_count; i++) {
+                int argument = expression_size(call->arguments[i]);
+                if (argument < 0) return -1;
+                size += argument;
+            }
+            return size;
+        }
+        default:
+            return -1; // Member accesses, closures and collections stay behind a call
+    }
+}
+
+static int references(AST_Expression* expr, const char* name) {
+    switch (expr->type) {
+        case IDENTIFIER:
+            return ((AST_Expression_Identifier*)expr)->value == name;
+        case INFIX_EXPRESSION:
+            return references(((AST_Expression_Infix*)expr)->left, name) ||
+                   references(((AST_Expression_Infix*)expr)->right, name);
+        case PREFIX_EXPRESSION:
+            return references(((AST_Expression_Prefix*)expr)->right, name);
+        case CALL_EXPRESSION: {
+            AST_Expression_Call* call = (AST_Expression_Call*)expr;
+            if (references(call->function, name)) return 1;
+            for (int i = 0; i < call->argument_count; i++) {
+                if (references(call->arguments[i], name)) return 1;
+            }
+            return 0;
+        }
+        default:
+            return 0;
+    }
+}
+
+static void add_candidate(Inliner* inliner, AST_Program* program, int index, const char* name,
+                          AST_Expression_Identifier** parameters, int parameter_count, AST_Statement_Block* body) {
+    if (body == NULL || body->statement_count != 1 || body->statements[0] == NULL) return;
+    if (body->statements[0]->type != RETURN_STATEMENT) return;
+    AST_Statement_Return* ret = (AST_Statement_Return*)body->statements[0];
+    if (expression_size(ret->return_value) < 0 || references(ret->return_value, name)) return;
+
+    int bindings = 0;
+    for (int i = 0; i < program->statement_count; i++) {
+        bindings += statement_binds(program->statements[i], name);
+    }
+    if (bindings != 1 || function_assigns_global(program, name)) return;
+
+    inliner->candidates = realloc(inliner->candidates, (inliner->candidate_count + 1) * sizeof(Candidate));
+    inliner->candidates[inliner->candidate_count++] = (Candidate){
+        name, parameters, parameter_count, &ret->return_value, index, 0
+    };
+}
+
+static Candidate* find_candidate(Inliner* inliner, const char* name) {
+    for (int i = 0; i < inliner->candidate_count; i++) {
+        if (inliner->candidates[i].name == name) return &inliner->candidates[i];
+    }
+    return NULL;
+}
+
+// --- Substitution ---
+
+static int is_atom(AST_Expression* expr) {
+    switch (expr->type) {
+        case IDENTIFIER: case INTEGER_LITERAL: case FLOAT_LITERAL: case STRING_LITERAL:
+        case BOOLEAN_LITERAL: case NIL_LITERAL:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static int parameter_index(Candidate* candidate, AST_Expression* expr) {
+    if (expr->type != IDENTIFIER) return -1;
+    AST_Expression_Identifier* ident = (AST_Expression_Identifier*)expr;
+    if (ident->scope != SCOPE_LOCAL) return -1;
+    for (int i = 0; i < candidate->parameter_count; i++) {
+        if (candidate->parameters[i]->value == ident->value) return i;
+    }
+    return -1;
+}
+
+static void count_uses(Candidate* candidate, AST_Expression* expr, int* uses) {
+    int index = parameter_index(candidate, expr);
+    if (index >= 0) {
+        uses[index]++;
+        return;
+    }
+    switch (expr->type) {
+        case INFIX_EXPRESSION:
+            count_uses(candidate, ((AST_Expression_Infix*)expr)->left, uses);
+            count_uses(candidate, ((AST_Expression_Infix*)expr)->right, uses);
+            break;
+        case PREFIX_EXPRESSION:
+            count_uses(candidate, ((AST_Expression_Prefix*)expr)->right, uses);
+            break;
+        case CALL_EXPRESSION: {
+            AST_Expression_Call* call = (AST_Expression_Call*)expr;
+            for (int i = 0; i < call->argument_count; i++) count_uses(candidate, call->arguments[i], uses);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+typedef struct {
+    AST_Expression** arguments;
+    int next;        // Next argument with effects, in argument order
+    int effect_seen; // An operation of the body that may fail or have effects already ran
+    int ok;
+} OrderCheck;
+
+// The interpreter evaluates all arguments before the body. Substituted
+// arguments with effects must therefore come first in the body's own
+// evaluation order, and in their original order.
+static void check_order(Candidate* candidate, AST_Expression* expr, OrderCheck* check) {
+    int index = parameter_index(candidate, expr);
+    if (index >= 0) {
+        if (is_atom(check->arguments[index])) return;
+        while (check->next < index && is_atom(check->arguments[check->next])) check->next++;
+        if (check->effect_seen || check->next != index) check->ok = 0;
+        check->next++;
+        return;
+    }
+    switch (expr->type) {
+        case INFIX_EXPRESSION:
+            check_order(candidate, ((AST_Expression_Infix*)expr)->left, check);
+            check_order(candidate, ((AST_Expression_Infix*)expr)->right, check);
+            check->effect_seen = 1;
+            break;
+        case PREFIX_EXPRESSION:
+            check_order(candidate, ((AST_Expression_Prefix*)expr)->right, check);
+            check->effect_seen = 1;
+            break;
+        case CALL_EXPRESSION: {
+            AST_Expression_Call* call = (AST_Expression_Call*)expr;
+            for (int i = 0; i < call->argument_count; i++) check_order(candidate, call->arguments[i], check);
+            check->effect_seen = 1;
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// Whether a name the body uses, other than a parameter, would be captured at the call site.
+static int body_is_captured(Inliner* inliner, Candidate* candidate, AST_Expression* expr) {
+    if (parameter_index(candidate, expr) >= 0) return 0;
+    switch (expr->type) {
+        case IDENTIFIER:
+            return shadowed(inliner->function, ((AST_Expression_Identifier*)expr)->value);
+        case INFIX_EXPRESSION:
+            return body_is_captured(inliner, candidate, ((AST_Expression_Infix*)expr)->left) ||
+                   body_is_captured(inliner, candidate, ((AST_Expression_Infix*)expr)->right);
+        case PREFIX_EXPRESSION:
+            return body_is_captured(inliner, candidate, ((AST_Expression_Prefix*)expr)->right);
+        case CALL_EXPRESSION: {
+            AST_Expression_Call* call = (AST_Expression_Call*)expr;
+            if (body_is_captured(inliner, candidate, call->function)) return 1;
+            for (int i = 0; i < call->argument_count; i++) {
+                if (body_is_captured(inliner, candidate, call->arguments[i])) return 1;
+            }
+            return 0;
+        }
+        default:
+            return 0;
+    }
+}
+
+static AST_Expression* copy_node(AST_Expression* expr, size_t size) {
+    AST_Expression* copy = malloc(size);
+    memcpy(copy, expr, size);
+    return copy;
+}
+
+static AST_Expression* copy_atom(AST_Expression* expr) {
+    switch (expr->type) {
+        case IDENTIFIER: return copy_node(expr, sizeof(AST_Expression_Identifier));
+        case INTEGER_LITERAL: return copy_node(expr, sizeof(AST_Expression_IntegerLiteral));
+        case FLOAT_LITERAL: return copy_node(expr, sizeof(AST_Expression_FloatLiteral));
+        case STRING_LITERAL: return copy_node(expr, sizeof(AST_Expression_StringLiteral));
+        case BOOLEAN_LITERAL: return copy_node(expr, sizeof(AST_Expression_Boolean));
+        case NIL_LITERAL: return copy_node(expr, sizeof(AST_Expression_NilLiteral));
+        default: return expr;
+    }
+}
+
+// Copies the body with the parameters replaced by `arguments`. Arguments
+// with effects are used exactly once (see try_inline) and move over as is.
+static AST_Expression* substitute(Candidate* candidate, AST_Expression* expr, AST_Expression** arguments) {
+    int index = parameter_index(candidate, expr);
+    if (index >= 0) {
+        AST_Expression* argument = arguments[index];
+        // Not substituted again: the caller's names aren't the callee's parameters
+        return is_atom(argument) ? copy_atom(argument) : argument;
+    }
+    switch (expr->type) {
+        case IDENTIFIER: case INTEGER_LITERAL: case FLOAT_LITERAL: case STRING_LITERAL:
+        case BOOLEAN_LITERAL: case NIL_LITERAL:
+            return copy_atom(expr);
+        case INFIX_EXPRESSION: {
+            AST_Expression_Infix* infix = (AST_Expression_Infix*)copy_node(expr, sizeof(AST_Expression_Infix));
+            infix->left = substitute(candidate, infix->left, arguments);
+            infix->right = substitute(candidate, infix->right, arguments);
+            return (AST_Expression*)infix;
+        }
+        case PREFIX_EXPRESSION: {
+            AST_Expression_Prefix* prefix = (AST_Expression_Prefix*)copy_node(expr, sizeof(AST_Expression_Prefix));
+            prefix->right = substitute(candidate, prefix->right, arguments);
+            return (AST_Expression*)prefix;
+        }
+        case CALL_EXPRESSION: {
+            AST_Expression_Call* call = (AST_Expression_Call*)copy_node(expr, sizeof(AST_Expression_Call));
+            call->function = substitute(candidate, call->function, arguments);
+            call->arguments = malloc((call->argument_count + 1) * sizeof(AST_Expression*));
+            for (int i = 0; i < call->argument_count; i++) {
+                call->arguments[i] = substitute(candidate, ((AST_Expression_Call*)expr)->arguments[i], arguments);
+            }
+            call->arguments[call->argument_count] = NULL;
+            call->method_cache.count = 0;
+            call->method_cache.epoch = 0;
+            call->profile = (CallProfile){0};
+            return (AST_Expression*)call;
+        }
+        default:
+            return expr; // Not reached: expression_size rejects everything else
+    }
+}
+
+// --- Inlining ---
+
+static void visit_expression(Inliner* inliner, AST_Expression** slot);
+static void visit_statement(Inliner* inliner, AST_Statement* stmt);
+
+// Replaces the call in `slot` with the body of the function it calls, if that's safe and worth it.
+static void try_inline(Inliner* inliner, AST_Expression** slot) {
+    AST_Expression_Call* call = (AST_Expression_Call*)*slot;
+    if (call->function->type != IDENTIFIER) return;
+    AST_Expression_Identifier* callee = (AST_Expression_Identifier*)call->function;
+    if (callee->scope != SCOPE_GLOBAL || shadowed(inliner->function, callee->value)) return;
+    Candidate* candidate = find_candidate(inliner, callee->value);
+    if (candidate == NULL || candidate->escapes || candidate->parameter_count != call->argument_count) return;
+    // Top-level code runs in order: before its definition the call is an error
+    if (inliner->function == NULL && inliner->statement_index <= candidate->defined_at) return;
+    if (inliner->depth >= INLINE_MAX_DEPTH) return;
+
+    AST_Expression* body = *candidate->body;
+    int limit = inliner->loop_depth > 0 ? INLINE_HOT_SIZE_LIMIT : INLINE_SIZE_LIMIT;
+    int size = expression_size(body);
+    if (size < 0 || size > limit) return;
+    if (body_is_captured(inliner, candidate, body)) return;
+
+    int* uses = calloc(candidate->parameter_count + 1, sizeof(int));
+    count_uses(candidate, body, uses);
+    int ok = 1;
+    for (int i = 0; i < call->argument_count; i++) {
+        if (!is_atom(call->arguments[i]) && uses[i] != 1) ok = 0;
+    }
+    free(uses);
+    OrderCheck check = { call->arguments, 0, 0, 1 };
+    check_order(candidate, body, &check);
+    if (!ok || !check.ok) return;
+
+    *slot = substitute(candidate, body, call->arguments);
+    inliner->inlined++;
+
+    // The body may call helpers of its own
+    inliner->depth++;
+    visit_expression(inliner, slot);
+    inliner->depth--;
+}
+
+static void visit_expression(Inliner* inliner, AST_Expression** slot) {
+    AST_Expression* expr = *slot;
+    if (expr == NULL) return;
+    switch (expr->type) {
+        case IDENTIFIER: {
+            // Reached only for identifiers used as values
+            Candidate* candidate = find_candidate(inliner, ((AST_Expression_Identifier*)expr)->value);
+            if (inliner->finding_escapes && candidate != NULL) candidate->escapes = 1;
+            break;
+        }
+        case INFIX_EXPRESSION:
+            visit_expression(inliner, &((AST_Expression_Infix*)expr)->left);
+            visit_expression(inliner, &((AST_Expression_Infix*)expr)->right);
+            break;
+        case PREFIX_EXPRESSION:
+            visit_expression(inliner, &((AST_Expression_Prefix*)expr)->right);
+            break;
+        case ARRAY_LITERAL: {
+            AST_Expression_ArrayLiteral* array = (AST_Expression_ArrayLiteral*)expr;
+            for (int i = 0; i < array->element_count; i++) visit_expression(inliner, &array->elements[i]);
+            break;
+        }
+        case MAP_LITERAL: {
+            AST_Expression_MapLiteral* map = (AST_Expression_MapLiteral*)expr;
+            for (int i = 0; i < map->entry_count; i++) {
+                visit_expression(inliner, &map->entries[i]->key);
+                visit_expression(inliner, &map->entries[i]->value);
+            }
+            break;
+        }
+        case MEMBER_ACCESS_EXPRESSION:
+            visit_expression(inliner, &((AST_Expression_MemberAccess*)expr)->object);
+            break;
+        case CALL_EXPRESSION: {
+            AST_Expression_Call* call = (AST_Expression_Call*)expr;
+            if (call->function->type != IDENTIFIER) visit_expression(inliner, &call->function);
+            for (int i = 0; i < call->argument_count; i++) visit_expression(inliner, &call->arguments[i]);
+            if (!inliner->finding_escapes) try_inline(inliner, slot);
+            break;
+        }
+        case FN_LITERAL: {
+            AST_Expression_FnLiteral* fn = (AST_Expression_FnLiteral*)expr;
+            EnclosingFunction function = { inliner->function, fn->parameters, fn->parameter_count, fn->body };
+            int loop_depth = inliner->loop_depth;
+            inliner->function = &function;
+            inliner->loop_depth = 0;
+            visit_statement(inliner, (AST_Statement*)fn->body);
+            inliner->function = function.enclosing;
+            inliner->loop_depth = loop_depth;
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+static void visit_function(Inliner* inliner, AST_Statement_FnDef* fn) {
+    EnclosingFunction function = { inliner->function, fn->parameters, fn->parameter_count, fn->body };
+    int loop_depth = inliner->loop_depth;
+    inliner->function = &function;
+    inliner->loop_depth = 0;
+    visit_statement(inliner, (AST_Statement*)fn->body);
+    inliner->function = function.enclosing;
+    inliner->loop_depth = loop_depth;
+}
+
+static void visit_statement(Inliner* inliner, AST_Statement* stmt) {
+    if (stmt == NULL) return;
+    switch (stmt->type) {
+        case SET_STATEMENT:
+        case ASSIGN_STATEMENT:
+            visit_expression(inliner, &((AST_Statement_Set*)stmt)->value);
+            break;
+        case MEMBER_SET_STATEMENT: {
+            AST_Statement_MemberSet* set = (AST_Statement_MemberSet*)stmt;
+            visit_expression(inliner, &set->target->object);
+            visit_expression(inliner, &set->value);
+            break;
+        }
+        case RETURN_STATEMENT:
+            visit_expression(inliner, &((AST_Statement_Return*)stmt)->return_value);
+            break;
+        case EXPRESSION_STATEMENT:
+            visit_expression(inliner, &((AST_Statement_Expression*)stmt)->expression);
+            break;
+        case BLOCK_STATEMENT: {
+            AST_Statement_Block* block = (AST_Statement_Block*)stmt;
+            for (int i = 0; i < block->statement_count; i++) visit_statement(inliner, block->statements[i]);
+            break;
+        }
+        case FN_DEFINITION:
+            visit_function(inliner, (AST_Statement_FnDef*)stmt);
+            break;
+        case CLASS_DEFINITION: {
+            AST_Statement_ClassDef* class_def = (AST_Statement_ClassDef*)stmt;
+            if (class_def->superclass != NULL) {
+                visit_expression(inliner, (AST_Expression**)&class_def->superclass);
+            }
+            for (int i = 0; class_def->body != NULL && i < class_def->body->statement_count; i++) {
+                AST_Statement* method = class_def->body->statements[i];
+                if (method != NULL && method->type == FN_DEFINITION) {
+                    visit_function(inliner, (AST_Statement_FnDef*)method);
+                } else {
+                    visit_statement(inliner, method);
+                }
+            }
+            break;
+        }
+        case IF_STATEMENT: {
+            AST_Statement_If* if_stmt = (AST_Statement_If*)stmt;
+            visit_expression(inliner, &if_stmt->condition);
+            visit_statement(inliner, (AST_Statement*)if_stmt->consequence);
+            visit_statement(inliner, if_stmt->alternative);
+            break;
+        }
+        case WHILE_STATEMENT: {
+            AST_Statement_While* while_stmt = (AST_Statement_While*)stmt;
+            inliner->loop_depth++;
+            visit_expression(inliner, &while_stmt->condition);
+            visit_statement(inliner, (AST_Statement*)while_stmt->body);
+            inliner->loop_depth--;
+            break;
+        }
+        case FOR_STATEMENT: {
+            AST_Statement_For* for_stmt = (AST_Statement_For*)stmt;
+            visit_expression(inliner, &for_stmt->iterable);
+            inliner->loop_depth++;
+            visit_statement(inliner, (AST_Statement*)for_stmt->body);
+            inliner->loop_depth--;
+            break;
+        }
+        case MATCH_STATEMENT: {
+            AST_Statement_Match* match = (AST_Statement_Match*)stmt;
+            visit_expression(inliner, &match->value);
+            for (int i = 0; i < match->case_count; i++) {
+                if (match->cases[i] == NULL) continue;
+                visit_expression(inliner, &match->cases[i]->pattern);
+                visit_statement(inliner, (AST_Statement*)match->cases[i]->consequence);
+            }
+            break;
+        }
+        case TRY_STATEMENT: {
+            AST_Statement_Try* try_stmt = (AST_Statement_Try*)stmt;
+            visit_statement(inliner, (AST_Statement*)try_stmt->body);
+            visit_statement(inliner, (AST_Statement*)try_stmt->handler);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+static void visit_program(Inliner* inliner, AST_Program* program) {
+    for (int i = 0; i < program->statement_count; i++) {
+        inliner->statement_index = i;
+        visit_statement(inliner, program->statements[i]);
+    }
+}
+
+int inline_program(AST_Program* program) {
+    if (program == NULL) return 0;
+    resolve_program(program);
+
+    Inliner inliner = {0};
+    for (int i = 0; i < program->statement_count; i++) {
+        AST_Statement* stmt = program->statements[i];
+        if (stmt == NULL) continue;
+        if (stmt->type == FN_DEFINITION) {
+            AST_Statement_FnDef* fn = (AST_Statement_FnDef*)stmt;
+            add_candidate(&inliner, program, i, fn->name->value, fn->parameters, fn->parameter_count, fn->body);
+        } else if (stmt->type == SET_STATEMENT && ((AST_Statement_Set*)stmt)->value != NULL &&
+                   ((AST_Statement_Set*)stmt)->value->type == FN_LITERAL) {
+            AST_Statement_Set* set = (AST_Statement_Set*)stmt;
+            AST_Expression_FnLiteral* fn = (AST_Expression_FnLiteral*)set->value;
+            add_candidate(&inliner, program, i, set->name->value, fn->parameters, fn->parameter_count, fn->body);
+        }
+    }
+    if (inliner.candidate_count == 0) return 0;
+
+    inliner.finding_escapes = 1;
+    visit_program(&inliner, program);
+    inliner.finding_escapes = 0;
+    visit_program(&inliner, program);
+
+    free(inliner.candidates);
+    // Inlined bodies carry the resolution of the function they came from
+    if (inliner.inlined > 0) resolve_program(program);
+    return inliner.inlined;
+}
@@ -0,0 +1,165 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#include "intern.h"
+
+#define INTERN_INITIAL_CAPACITY 256
+#define INTERN_PINNED -1
+
+// Each entry stores its metadata right in front of the characters, so the
+// handle handed out to callers (`chars`) leads back to its hash in O(1).
+typedef struct InternEntry {
+    unsigned int hash;
+    unsigned int length;
+    int refcount; // INTERN_PINNED for strong entries
+    char chars[];
+} InternEntry;
+
+// Marks a slot whose weak entry was reclaimed, so probing continues past it.
+static InternEntry tombstone;
+
+static InternEntry** table = NULL;
+static size_t capacity = 0;
+static size_t used = 0; // live entries + tombstones
+static pthread_mutex_t intern_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static InternEntry* entry_of(const char* interned) {
+    return (InternEntry*)(interned - offsetof(InternEntry, chars));
+}
+
+// FNV-1a
+static unsigned int hash_bytes(const char* str, size_t length) {
+    unsigned int hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)str[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Rehashes into a table twice the size, or the same size when most of
+// `used` was tombstones, so reclaiming weak entries doesn't grow it.
+static void grow_table() {
+    size_t old_capacity = capacity;
+    InternEntry** old_table = table;
+
+    size_t live = 0;
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old_table[i] != NULL && old_table[i] != &tombstone) live++;
+    }
+    capacity = old_capacity == 0 ? INTERN_INITIAL_CAPACITY
+             : (live + 1) * 2 > old_capacity ? old_capacity * 2 : old_capacity;
+    table = calloc(capacity, sizeof(InternEntry*));
+    if (table == NULL) {
+        fprintf(stderr, "Fatal: Memory allocation failed for intern table\n");
+        exit(1);
+    }
+    used = 0;
+
+    for (size_t i = 0; i < old_capacity; i++) {
+        InternEntry* entry = old_table[i];
+        if (entry == NULL || entry == &tombstone) continue;
+        size_t index = entry->hash & (capacity - 1);
+        while (table[index] != NULL) {
+            index = (index + 1) & (capacity - 1);
+        }
+        table[index] = entry;
+        used++;
+    }
+    free(old_table);
+}
+
+// Must be called with intern_lock held.
+static InternEntry* lookup_or_insert(const char* str, size_t length) {
+    if ((used + 1) * 4 > capacity * 3) {
+        grow_table();
+    }
+
+    unsigned int hash = hash_bytes(str, length);
+    size_t index = hash & (capacity - 1);
+    InternEntry** free_slot = NULL;
+
+    while (table[index] != NULL) {
+        InternEntry* entry = table[index];
+        if (entry == &tombstone) {
+            if (free_slot == NULL) free_slot = &table[index];
+        } else if (entry->hash == hash && entry->length == length &&
+                   memcmp(entry->chars, str, length) == 0) {
+            return entry;
+        }
+        index = (index + 1) & (capacity - 1);
+    }
+
+    InternEntry* entry = malloc(sizeof(InternEntry) + length + 1);
+    if (entry == NULL) {
+        fprintf(stderr, "Fatal: Memory allocation failed for interned string\n");
+        exit(1);
+    }
+    entry->hash = hash;
+    entry->length = (unsigned int)length;
+    entry->refcount = 0;
+    memcpy(entry->chars, str, length);
+    entry->chars[length] = '\0';
+
+    if (free_slot != NULL) {
+        *free_slot = entry; // Reuse a tombstone; `used` already counts it
+    } else {
+        table[index] = entry;
+        used++;
+    }
+    return entry;
+}
+
+const char* intern_n(const char* str, size_t length) {
+    pthread_mutex_lock(&intern_lock);
+    InternEntry* entry = lookup_or_insert(str, length);
+    entry->refcount = INTERN_PINNED;
+    pthread_mutex_unlock(&intern_lock);
+    return entry->chars;
+}
+
+const char* intern(const char* str) {
+    return intern_n(str, strlen(str));
+}
+
+const char* intern_weak_n(const char* str, size_t length) {
+    pthread_mutex_lock(&intern_lock);
+    InternEntry* entry = lookup_or_insert(str, length);
+    if (entry->refcount != INTERN_PINNED) {
+        entry->refcount++;
+    }
+    pthread_mutex_unlock(&intern_lock);
+    return entry->chars;
+}
+
+const char* intern_weak(const char* str) {
+    return intern_weak_n(str, strlen(str));
+}
+
+void intern_release(const char* interned) {
+    if (interned == NULL) return;
+    InternEntry* entry = entry_of(interned);
+
+    pthread_mutex_lock(&intern_lock);
+    if (entry->refcount != INTERN_PINNED && --entry->refcount == 0) {
+        size_t index = entry->hash & (capacity - 1);
+        while (table[index] != entry) {
+            index = (index + 1) & (capacity - 1);
+        }
+        table[index] = &tombstone;
+        free(entry);
+    }
+    pthread_mutex_unlock(&intern_lock);
+}
+
+unsigned int intern_hash(const char* interned) {
+    return entry_of(interned)->hash;
+}
+
+size_t intern_length(const char* interned) {
+    return entry_of(interned)->length;
+}
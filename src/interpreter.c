@@ -6,12 +6,42 @@
 #include "interpreter.h"
 #include "ast.h"
 #include "object.h"
+#include "intern.h"
+#include "omni_error.h"
+#include "resolver.h"
+#include "type_infer.h"
+#include "tier.h"
+
+// Arguments of most calls fit on the C stack; larger calls fall back to the heap.
+#define CALL_STACK_ARGS 8
 
 // --- Forward declarations for static functions ---
 static Object* eval(AST_Node* node, Environment* env);
 static int is_truthy(Object* obj);
 
 // --- Helper Functions ---
+// Fills in an Object the caller provides, on the heap or the stack.
+static void integer_value(Object* obj, long long value) {
+    obj->type = OBJ_INTEGER;
+    obj->value.integer = value;
+}
+
+static void float_value(Object* obj, double value) {
+    obj->type = OBJ_FLOAT;
+    obj->value.floating = value;
+}
+
+static void boolean_value(Object* obj, int value) {
+    obj->type = OBJ_BOOLEAN;
+    obj->value.boolean = value;
+}
+
+// Stores a scalar result of the runtime's kernels, which shares the Object's layout.
+static Object* set_object_value(Object* obj, OmniValue value) {
+    *(OmniValue*)obj = value;
+    return obj;
+}
+
 static Object* new_integer_object(long long value) {
     Object* obj = malloc(sizeof(Object));
     obj->type = OBJ_INTEGER;
@@ -19,6 +49,13 @@ static Object* new_integer_object(long long value) {
     return obj;
 }
 
+static Object* new_float_object(double value) {
+    Object* obj = malloc(sizeof(Object));
+    obj->type = OBJ_FLOAT;
+    obj->value.floating = value;
+    return obj;
+}
+
 static Object* new_boolean_object(int value) {
     Object* obj = malloc(sizeof(Object));
     obj->type = OBJ_BOOLEAN;
@@ -32,55 +69,150 @@ static Object* new_nil_object() {
     return obj;
 }
 
-static Object* new_string_object(char* value) {
+// `value` is an interned literal or message, shared rather than copied.
+static Object* new_string_object(const char* value) {
     Object* obj = malloc(sizeof(Object));
     obj->type = OBJ_STRING;
-    obj->value.string = strdup(value); // Duplicate the string
+    obj->value.string = value;
     return obj;
 }
 
-static Object* new_return_value_object(Object* value) {
+
+#define INSTANCE_INITIAL_SLOTS 4
+
+static Object* new_class_object(const char* name, ObjectClass* superclass) {
     Object* obj = malloc(sizeof(Object));
-    obj->type = OBJ_RETURN_VALUE;
-    obj->value.return_value = value;
+    obj->type = OBJ_CLASS;
+    ObjectClass* klass = malloc(sizeof(ObjectClass));
+    klass->name = name;
+    klass->superclass = superclass;
+    klass->root_shape = shape_new_root();
+    klass->members = NULL;
+    klass->member_count = 0;
+    obj->value.klass = klass;
     return obj;
 }
 
-static Object* new_function_object(AST_Expression_Identifier** params, int param_count, AST_Statement_Block* body, Environment* env) {
+static Object* new_instance_object(ObjectClass* klass) {
     Object* obj = malloc(sizeof(Object));
-    obj->type = OBJ_FUNCTION;
-    ObjectFunction* fn = malloc(sizeof(ObjectFunction));
-    fn->parameters = params;
-    fn->parameter_count = param_count;
-    fn->body = body;
-    fn->env = env;
-    obj->value.function = fn;
+    obj->type = OBJ_INSTANCE;
+    ObjectInstance* instance = malloc(sizeof(ObjectInstance) + INSTANCE_INITIAL_SLOTS * sizeof(Object*));
+    instance->klass = klass;
+    instance->shape = klass->root_shape;
+    instance->slot_capacity = INSTANCE_INITIAL_SLOTS;
+    obj->value.instance = instance;
+    return obj;
+}
+
+static Object* new_bound_method_object(Object* receiver, Object* method) {
+    Object* obj = malloc(sizeof(Object));
+    obj->type = OBJ_BOUND_METHOD;
+    ObjectBoundMethod* bound = malloc(sizeof(ObjectBoundMethod));
+    bound->receiver = receiver;
+    bound->method = method;
+    obj->value.bound_method = bound;
     return obj;
 }
 
+// --- Classes ---
+static const char* init_name = NULL; // Interned "init", set up by interpret()
+static unsigned int class_epoch = 1; // Bumped whenever a class is mutated
+
+static Object* class_find_member(ObjectClass* klass, const char* name) {
+    for (; klass != NULL; klass = klass->superclass) {
+        for (int i = 0; i < klass->member_count; i++) {
+            if (klass->members[i].name == name) {
+                return klass->members[i].value;
+            }
+        }
+    }
+    return NULL;
+}
+
+static void class_set_member(ObjectClass* klass, const char* name, Object* value) {
+    class_epoch++; // Invalidates every cached method resolution
+    for (int i = 0; i < klass->member_count; i++) {
+        if (klass->members[i].name == name) {
+            klass->members[i].value = value;
+            return;
+        }
+    }
+    klass->member_count++;
+    klass->members = realloc(klass->members, klass->member_count * sizeof(ClassMember));
+    klass->members[klass->member_count - 1].name = name;
+    klass->members[klass->member_count - 1].value = value;
+}
+
 // --- Environment ---
-typedef struct EnvEntry {
-    char* name;
-    Object* value;
+// An entry doubles as the box a closure shares when it captures the variable.
+struct EnvEntry {
+    const char* name; // Interned
+    Object* value;    // NULL until assigned
     struct EnvEntry* next;
-} EnvEntry;
+};
 
+// Function environments are flat: `outer` is always the global environment,
+// and variables of enclosing functions are reached through `upvalues`.
 struct Environment {
     EnvEntry* store;
     struct Environment* outer;
+    EnvEntry** upvalues; // Captures of the running closure
+
+    // Entries of a call whose variables don't escape, on the caller's stack (see apply_function)
+    EnvEntry* frame;
+    int frame_used;
+    int frame_size;
+
+    Object returned; // The wrapper of a `return`, unwrapped before anything else runs here
 };
 
 Environment* new_environment() {
     Environment* env = malloc(sizeof(Environment));
     env->store = NULL;
     env->outer = NULL;
+    env->upvalues = NULL;
+    env->frame = NULL;
+    env->frame_used = 0;
+    env->frame_size = 0;
     return env;
 }
 
-Object* get_environment(Environment* env, char* name) {
+static EnvEntry* env_new_entry(Environment* env, const char* name, Object* value) {
+    EnvEntry* entry = env->frame_used < env->frame_size ? &env->frame[env->frame_used++] : malloc(sizeof(EnvEntry));
+    entry->name = name;
+    entry->value = value;
+    entry->next = env->store;
+    env->store = entry;
+    return entry;
+}
+
+static Environment* globals_of(Environment* env) {
+    return env->outer != NULL ? env->outer : env;
+}
+
+static EnvEntry* env_find_local(Environment* env, const char* name) {
+    for (EnvEntry* entry = env->store; entry != NULL; entry = entry->next) {
+        if (entry->name == name) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+// Returns the box for `name` in `env`, declaring it (unassigned) if needed,
+// so a closure can capture a variable that is only assigned later.
+static EnvEntry* env_box(Environment* env, const char* name) {
+    EnvEntry* entry = env_find_local(env, name);
+    if (entry == NULL) {
+        entry = env_new_entry(env, name, NULL);
+    }
+    return entry;
+}
+
+Object* get_environment(Environment* env, const char* name) {
     EnvEntry* entry = env->store;
     while (entry != NULL) {
-        if (strcmp(entry->name, name) == 0) {
+        if (entry->name == name && entry->value != NULL) {
             return entry->value;
         }
         entry = entry->next;
@@ -91,10 +223,10 @@ Object* get_environment(Environment* env, char* name) {
     return NULL; // Not found
 }
 
-void set_environment(Environment* env, char* name, Object* val) {
+void set_environment(Environment* env, const char* name, Object* val) {
     EnvEntry* entry = env->store;
     while (entry != NULL) {
-        if (strcmp(entry->name, name) == 0) {
+        if (entry->name == name) {
             entry->value = val;
             return;
         }
@@ -102,41 +234,293 @@ void set_environment(Environment* env, char* name, Object* val) {
     }
 
     // Not found, add new entry
-    EnvEntry* new_entry = malloc(sizeof(EnvEntry));
-    new_entry->name = strdup(name);
-    new_entry->value = val;
-    new_entry->next = env->store;
-    env->store = new_entry;
+    env_new_entry(env, name, val);
 }
 
-// --- Function Application ---
-static Environment* extend_function_env(ObjectFunction* fn, Object** args, int arg_count) {
-    Environment* env = new_environment();
-    env->outer = fn->env; // Set the function's closure as the outer environment
+// --- Closures ---
+// Captures only the free variables the resolver found, as shared boxes,
+// instead of keeping the whole defining environment alive.
+static Object* new_function_object(const char* name, AST_Expression_Identifier** params, int param_count,
+                                   AST_Statement_Block* body, AST_Capture* captures, int capture_count,
+                                   AST_Frame frame, Environment* env) {
+    Object* obj = malloc(sizeof(Object));
+    obj->type = OBJ_FUNCTION;
+    ObjectFunction* fn = malloc(sizeof(ObjectFunction));
+    fn->name = name;
+    fn->parameters = params;
+    fn->parameter_count = param_count;
+    fn->body = body;
+    fn->globals = globals_of(env);
+    fn->upvalues = NULL;
+    fn->upvalue_count = capture_count;
+    fn->frame = frame;
+    if (capture_count > 0) {
+        fn->upvalues = malloc(capture_count * sizeof(EnvEntry*));
+        for (int i = 0; i < capture_count; i++) {
+            if (captures[i].from_local) {
+                fn->upvalues[i] = env_box(env, captures[i].name);
+            } else {
+                fn->upvalues[i] = env->upvalues[captures[i].index];
+            }
+        }
+    }
+    fn->call_count = 0;
+    fn->backedge_count = 0;
+    fn->deopt_count = 0;
+    fn->tier = capture_count > 0 ? TIER_FAILED : TIER_INTERPRETED; // Compiled code has no upvalues
+    fn->native = NULL;
+    fn->ticket = NULL;
+    obj->value.function = fn;
+    return obj;
+}
 
+// --- Function Application ---
+static void bind_arguments(Environment* env, ObjectFunction* fn, Object** args, int arg_count) {
+    env->outer = fn->globals;
+    env->upvalues = fn->upvalues;
     for (int i = 0; i < arg_count; i++) {
         set_environment(env, fn->parameters[i]->value, args[i]);
     }
-    return env;
 }
 
-static Object* apply_function(Object* func, Object** args, int arg_count) {
+static Object* apply_function(Object* func, Object** args, int arg_count, Object* into);
+
+// Calls `method` with `receiver` bound to its first parameter (`self`).
+static Object* apply_method(Object* method, Object* receiver, Object** args, int arg_count) {
+    Object** method_args = malloc((arg_count + 1) * sizeof(Object*));
+    method_args[0] = receiver;
+    for (int i = 0; i < arg_count; i++) {
+        method_args[i + 1] = args[i];
+    }
+    Object* result = apply_function(method, method_args, arg_count + 1, NULL);
+    free(method_args);
+    return result;
+}
+
+static Object* instantiate_class(ObjectClass* klass, Object** args, int arg_count) {
+    Object* instance = new_instance_object(klass);
+    Object* init = class_find_member(klass, init_name);
+    if (init != NULL) {
+        apply_method(init, instance, args, arg_count);
+    } else if (arg_count != 0) {
+        omni_raise("Class '%s' takes no arguments, got %d.", klass->name, arg_count);
+    }
+    return instance;
+}
+
+// --- Tiered Execution ---
+// Functions are promoted to native code once they get hot (see tier.h).
+
+static Environment* tier_globals = NULL;           // Environment the bridges resolve names in
+static ObjectFunction* current_function = NULL;   // Interpreted function whose loops count back-edges
+
+// Scalars are read in place; anything else travels as a pointer to the Object.
+static OmniValue object_to_omni(Object* obj) {
+    if (obj == NULL) return omni_new_nil();
+    if (object_is_scalar(obj)) return *object_value(obj);
+    OmniValue value;
+    value.type = OMNI_OBJECT;
+    value.value.object = obj;
+    return value;
+}
+
+static Object* omni_to_object(OmniValue value) {
+    if (value.type == OMNI_OBJECT) return value.value.object;
+    return set_object_value(malloc(sizeof(Object)), value);
+}
+
+// Runs the native code of `fn`; returns 0 if it deoptimized, in which case
+// the function is back to being interpreted (and profiled) and the call has
+// to be interpreted too. A scalar result is stored in `into` if set (see
+// eval_operand), and only copied to the heap otherwise.
+static int call_native(ObjectFunction* fn, Object** args, int arg_count, Object* into, Object** result) {
+    OmniValue stack_values[CALL_STACK_ARGS];
+    OmniValue* values = arg_count <= CALL_STACK_ARGS ? stack_values : malloc(arg_count * sizeof(OmniValue));
+    for (int i = 0; i < arg_count; i++) {
+        values[i] = object_to_omni(args[i]);
+    }
+    OmniValue value;
+    int done = fn->native(values, &value) == TIER_EXIT_DONE;
+    if (values != stack_values) free(values);
+
+    if (!done) {
+        fn->native = NULL;
+        fn->tier = TIER_INTERPRETED;
+        fn->call_count = 0;
+        fn->backedge_count = 0;
+        fn->deopt_count++;
+        return 0;
+    }
+    *result = value.type == OMNI_OBJECT ? value.value.object
+                                        : set_object_value(into != NULL ? into : malloc(sizeof(Object)), value);
+    return 1;
+}
+
+// Starts compiling `fn` in the background, speculating on the argument types
+// of the call that made it hot unless it already deoptimized too often.
+static void tier_up(ObjectFunction* fn, Object** args, int arg_count) {
+    OmniValue stack_values[CALL_STACK_ARGS];
+    OmniValue* values = arg_count <= CALL_STACK_ARGS ? stack_values : malloc(arg_count * sizeof(OmniValue));
+    for (int i = 0; i < arg_count; i++) {
+        values[i] = object_to_omni(args[i]);
+    }
+    int speculate = fn->deopt_count < TIER_MAX_DEOPTS;
+    fn->ticket = tier_compile(fn->name, fn->parameters, fn->parameter_count, fn->body, speculate ? values : NULL);
+    fn->tier = fn->ticket != NULL ? TIER_COMPILING : TIER_FAILED;
+    if (values != stack_values) free(values);
+}
+
+// Swaps in the native code of `fn` once its background compile is done.
+static void tier_poll(ObjectFunction* fn) {
+    void* entry;
+    if (!tier_ticket_poll(fn->ticket, &entry)) return;
+    fn->ticket = NULL;
+    fn->native = (TierEntry)entry;
+    fn->tier = fn->native != NULL ? TIER_COMPILED : TIER_FAILED;
+}
+
+OmniValue omni_tier_get_global(const char* name) {
+    Object* val = get_environment(tier_globals, name);
+    if (val == NULL) {
+        omni_raise("Identifier '%s' not found.", name);
+    }
+    return object_to_omni(val);
+}
+
+OmniValue omni_tier_call(const char* name, const OmniValue* args, int arg_count) {
+    Object* function = get_environment(tier_globals, name);
+    if (function == NULL) {
+        omni_raise("Identifier '%s' not found.", name);
+    }
+    Object* stack_args[CALL_STACK_ARGS];
+    Object** objects = arg_count <= CALL_STACK_ARGS ? stack_args : malloc(arg_count * sizeof(Object*));
+    for (int i = 0; i < arg_count; i++) {
+        objects[i] = omni_to_object(args[i]);
+    }
+    Object scratch; // Read right away, so a native callee's scalar result needs no heap copy
+    OmniValue result = object_to_omni(apply_function(function, objects, arg_count, &scratch));
+    if (objects != stack_args) free(objects);
+    return result;
+}
+
+void omni_osr_flush(OsrFrame* frame) {
+    for (int i = 0; i < frame->count; i++) {
+        set_environment(tier_globals, frame->names[i], omni_to_object(frame->values[i]));
+    }
+}
+
+void omni_osr_reload(OsrFrame* frame) {
+    for (int i = 0; i < frame->count; i++) {
+        frame->values[i] = object_to_omni(get_environment(tier_globals, frame->names[i]));
+    }
+}
+
+// Moves a hot top-level loop onto native code at the current iteration
+// boundary. Returns 1 if the loop ran to completion natively, 0 if the
+// interpreter has to carry on with it (not compiled yet, or deoptimized).
+static int osr_enter(AST_Statement_While* loop) {
+    OsrLoop* osr = loop->osr;
+    if (osr == NULL) {
+        osr = loop->osr = tier_osr_prepare(loop);
+    }
+    if (osr->ticket != NULL) {
+        // Compiling in the background; the back-edge counter stays tripped, so this
+        // is polled again after every iteration until the code is ready
+        void* entry;
+        if (!tier_ticket_poll(osr->ticket, &entry)) return 0;
+        osr->ticket = NULL;
+        osr->entry = (OsrEntry)entry;
+        if (osr->entry == NULL) {
+            osr->failed = 1;
+            return 0;
+        }
+    }
+    loop->backedge_count = 0;
+
+    OmniValue stack_values[CALL_STACK_ARGS];
+    OmniValue* values = osr->count <= CALL_STACK_ARGS ? stack_values : malloc(osr->count * sizeof(OmniValue));
+    OsrFrame frame = { osr->names, values, osr->count };
+    for (int i = 0; i < osr->count; i++) {
+        if (get_environment(tier_globals, osr->names[i]) == NULL) {
+            osr->failed = 1; // Not defined yet: let the interpreter report it
+            break;
+        }
+    }
+    if (!osr->failed) omni_osr_reload(&frame);
+    if (!osr->failed && osr->entry == NULL) {
+        osr->ticket = tier_osr_compile(osr, loop, values);
+        if (osr->ticket == NULL) {
+            osr->failed = 1;
+        } else {
+            loop->backedge_count = TIER_OSR_THRESHOLD;
+        }
+    }
+
+    int done = 0;
+    if (!osr->failed && osr->entry != NULL) {
+        done = osr->entry(values, &frame) == TIER_EXIT_DONE;
+        omni_osr_flush(&frame);
+        if (!done && ++osr->deopt_count >= TIER_MAX_DEOPTS) {
+            osr->failed = 1; // Keeps changing types; stay interpreted
+        }
+        if (!done) osr->entry = NULL; // Recompiled for the new types next time
+    }
+    if (values != stack_values) free(values);
+    return done;
+}
+
+// With `into` set, a scalar result of native code is stored there (see eval_operand).
+static Object* apply_function(Object* func, Object** args, int arg_count, Object* into) {
+    if (func->type == OBJ_BUILTIN) {
+        return func->value.builtin(args, arg_count);
+    }
+    if (func->type == OBJ_CLASS) {
+        return instantiate_class(func->value.klass, args, arg_count);
+    }
+    if (func->type == OBJ_BOUND_METHOD) {
+        ObjectBoundMethod* bound = func->value.bound_method;
+        return apply_method(bound->method, bound->receiver, args, arg_count);
+    }
     if (func->type != OBJ_FUNCTION) {
-        fprintf(stderr, "RuntimeError: Expected a function, but got type %d.\n", func->type);
-        exit(1);
+        omni_raise("Expected a function, but got type %d.", func->type);
     }
 
     ObjectFunction* fn = func->value.function;
 
     if (arg_count != fn->parameter_count) {
-        fprintf(stderr, "RuntimeError: Wrong number of arguments. Expected %d, got %d.\n", fn->parameter_count, arg_count);
-        exit(1);
+        omni_raise("Wrong number of arguments. Expected %d, got %d.", fn->parameter_count, arg_count);
     }
 
-    Environment* extended_env = extend_function_env(fn, args, arg_count);
-    Object* evaluated = eval((AST_Node*)fn->body, extended_env);
+    if (fn->tier == TIER_INTERPRETED && tier_enabled()) {
+        if (++fn->call_count >= TIER_CALL_THRESHOLD || fn->backedge_count >= TIER_BACKEDGE_THRESHOLD) {
+            tier_up(fn, args, arg_count);
+        }
+    }
+    if (fn->tier == TIER_COMPILING) {
+        tier_poll(fn);
+    }
+    Object* result;
+    if (fn->native != NULL && call_native(fn, args, arg_count, into, &result)) {
+        return result;
+    }
 
-    // TODO: Free extended_env
+    ObjectFunction* caller = current_function;
+    current_function = fn;
+    Object* evaluated;
+    if (!fn->frame.locals_escape) {
+        // No closure can reach the call's variables once it returns, and
+        // nothing else keeps its environment: both live on this stack frame.
+        EnvEntry entries[fn->frame.local_count > 0 ? fn->frame.local_count : 1];
+        Environment env = { .frame = entries, .frame_size = fn->frame.local_count };
+        bind_arguments(&env, fn, args, arg_count);
+        evaluated = eval((AST_Node*)fn->body, &env);
+        if (evaluated == &env.returned) evaluated = evaluated->value.return_value; // Unwrapped before it goes away
+    } else {
+        Environment* extended_env = new_environment();
+        bind_arguments(extended_env, fn, args, arg_count);
+        evaluated = eval((AST_Node*)fn->body, extended_env);
+    }
+    current_function = caller;
 
     if (evaluated != NULL && evaluated->type == OBJ_RETURN_VALUE) {
         return evaluated->value.return_value; // Unwrap the return value
@@ -160,97 +544,139 @@ static Object* eval_set_statement(AST_Statement_Set* stmt, Environment* env) {
     if (val == NULL) { // Error handling for evaluation
         return NULL; // Or an error object
     }
+    if (val->type == OBJ_FUNCTION && val->value.function->name == NULL) {
+        val->value.function->name = stmt->name->value; // `set f = fn(...)` names the function
+    }
     set_environment(env, stmt->name->value, val);
     return val;
 }
 
-static Object* eval_identifier(AST_Expression_Identifier* ident, Environment* env) {
-    Object* val = get_environment(env, ident->value);
+// `name = value` without `set`: writes the variable `name` resolved to.
+static Object* eval_assign_statement(AST_Statement_Set* stmt, Environment* env) {
+    Object* val = eval((AST_Node*)stmt->value, env);
     if (val == NULL) {
-        // TODO: Create a proper error object
-        fprintf(stderr, "RuntimeError: Identifier '%s' not found.\n", ident->value);
-        exit(1);
+        return NULL;
+    }
+    switch (stmt->name->scope) {
+        case SCOPE_UPVALUE:
+            env->upvalues[stmt->name->index]->value = val;
+            break;
+        case SCOPE_GLOBAL:
+            set_environment(globals_of(env), stmt->name->value, val);
+            break;
+        default:
+            set_environment(env, stmt->name->value, val);
+            break;
     }
     return val;
 }
 
-static Object* eval_infix_expression(AST_Expression_Infix* infix, Environment* env) {
-    Object* left = eval((AST_Node*)infix->left, env);
-    Object* right = eval((AST_Node*)infix->right, env);
-
-    // Only handle integer arithmetic for now
-    if (left->type == OBJ_INTEGER && right->type == OBJ_INTEGER) {
-        long long left_val = left->value.integer;
-        long long right_val = right->value.integer;
-
-        if (strcmp(infix->operator, "+") == 0) {
-            return new_integer_object(left_val + right_val);
-        } else if (strcmp(infix->operator, "-") == 0) {
-            return new_integer_object(left_val - right_val);
-        } else if (strcmp(infix->operator, "*") == 0) {
-            return new_integer_object(left_val * right_val);
-        } else if (strcmp(infix->operator, "/") == 0) {
-            if (right_val == 0) {
-                fprintf(stderr, "RuntimeError: Division by zero.\n");
-                exit(1);
+static Object* eval_identifier(AST_Expression_Identifier* ident, Environment* env) {
+    Object* val;
+    switch (ident->scope) {
+        case SCOPE_UPVALUE:
+            val = env->upvalues[ident->index]->value;
+            break;
+        case SCOPE_LOCAL: {
+            EnvEntry* entry = env_find_local(env, ident->value);
+            val = entry != NULL ? entry->value : NULL;
+            if (val == NULL && ident->outer == SCOPE_UPVALUE) {
+                val = env->upvalues[ident->outer_index]->value;
+            } else if (val == NULL && ident->outer == SCOPE_GLOBAL) {
+                val = get_environment(globals_of(env), ident->value);
             }
-            return new_integer_object(left_val / right_val);
-        } else if (strcmp(infix->operator, "==") == 0) {
-            return new_boolean_object(left_val == right_val);
-        } else if (strcmp(infix->operator, "!=") == 0) {
-            return new_boolean_object(left_val != right_val);
-        } else if (strcmp(infix->operator, "<") == 0) {
-            return new_boolean_object(left_val < right_val);
-        } else if (strcmp(infix->operator, ">") == 0) {
-            return new_boolean_object(left_val > right_val);
-        } else if (strcmp(infix->operator, "<=") == 0) {
-            return new_boolean_object(left_val <= right_val);
-        } else if (strcmp(infix->operator, ">=") == 0) {
-            return new_boolean_object(left_val >= right_val);
-        }
-    } else if (left->type == OBJ_STRING && right->type == OBJ_STRING) {
-        if (strcmp(infix->operator, "+") == 0) {
-            char* left_val = left->value.string;
-            char* right_val = right->value.string;
-            int new_len = strlen(left_val) + strlen(right_val);
-            char* new_str = malloc(new_len + 1);
-            strcpy(new_str, left_val);
-            strcat(new_str, right_val);
-            return new_string_object(new_str);
+            break;
         }
+        case SCOPE_GLOBAL:
+            val = get_environment(globals_of(env), ident->value);
+            break;
+        default:
+            val = get_environment(env, ident->value);
+            break;
     }
-    // TODO: Handle other types and errors
-    return NULL;
+    if (val == NULL) {
+        // TODO: Create a proper error object
+        omni_raise("Identifier '%s' not found.", ident->value);
+    }
+    return val;
+}
+
+static Object* eval_operand(AST_Expression* expr, Environment* env, Object* scratch);
+static Object* eval_call_expression(AST_Expression_Call* call, Environment* env, Object* into);
+
+// With `into` set, the value is built there instead of on the heap (see eval_operand).
+static Object* eval_infix_expression(AST_Expression_Infix* infix, Environment* env, Object* into) {
+    Object left_scratch, right_scratch;
+    Object* left = eval_operand(infix->left, env, &left_scratch);
+    Object* right = eval_operand(infix->right, env, &right_scratch);
+
+    if (infix->op < 0) {
+        return NULL; // TODO: Handle other operators
+    }
+    Object* result = into != NULL ? into : malloc(sizeof(Object));
+    OmniStatus status = omni_binary(infix->op, object_to_omni(left), object_to_omni(right), (OmniValue*)result);
+    if (status != OMNI_OK) {
+        omni_fail(status, omni_binary_op_names[infix->op]);
+    }
+    // Strings concatenated into scratch die here, so `a + b + c` drops the
+    // reference on the intermediate string at once
+    if (infix->left->type == INFIX_EXPRESSION && left == &left_scratch && left->type == OBJ_STRING) {
+        intern_release(left->value.string);
+    }
+    if (infix->right->type == INFIX_EXPRESSION && right == &right_scratch && right->type == OBJ_STRING) {
+        intern_release(right->value.string);
+    }
+    return result;
 }
 
-static Object* eval_prefix_expression(char* operator, Object* right) {
+static Object* eval_prefix_expression(char* operator, Object* right, Object* into) {
+    OmniValue value;
     if (strcmp(operator, "!") == 0) {
-        if (is_truthy(right)) {
-            return new_boolean_object(0);
-        } else {
-            return new_boolean_object(1);
-        }
+        value = omni_new_boolean(!is_truthy(right));
     } else if (strcmp(operator, "-") == 0) {
-        if (right->type != OBJ_INTEGER) {
-            // TODO: Error handling
-            return new_nil_object();
+        OmniStatus status = omni_unary_minus(object_to_omni(right), &value);
+        if (status != OMNI_OK) {
+            omni_fail(status, "negation");
         }
-        long long value = right->value.integer;
-        return new_integer_object(-value);
+    } else {
+        value = omni_new_nil(); // TODO: Error handling for unknown operator
     }
-    // TODO: Error handling for unknown operator
-    return new_nil_object();
+    return set_object_value(into != NULL ? into : malloc(sizeof(Object)), value);
 }
 
-static int is_truthy(Object* obj) {
-    if (obj == NULL || obj->type == OBJ_NIL) {
-        return 0; // nil and NULL are falsy
-    }
-    if (obj->type == OBJ_BOOLEAN) {
-        return obj->value.boolean;
+// Evaluates an expression whose value the caller reads right away and
+// never keeps: an operand of arithmetic or a comparison, or a condition.
+// Such a value can't escape, so literals, arithmetic and the scalars native
+// code returns are built in `scratch`, on the caller's stack, instead of on
+// the heap.
+static Object* eval_operand(AST_Expression* expr, Environment* env, Object* scratch) {
+    switch (expr->type) {
+        case INTEGER_LITERAL:
+            integer_value(scratch, ((AST_Expression_IntegerLiteral*)expr)->value);
+            return scratch;
+        case FLOAT_LITERAL:
+            float_value(scratch, ((AST_Expression_FloatLiteral*)expr)->value);
+            return scratch;
+        case BOOLEAN_LITERAL:
+            boolean_value(scratch, ((AST_Expression_Boolean*)expr)->value);
+            return scratch;
+        case INFIX_EXPRESSION:
+            return eval_infix_expression((AST_Expression_Infix*)expr, env, scratch);
+        case PREFIX_EXPRESSION: {
+            AST_Expression_Prefix* prefix = (AST_Expression_Prefix*)expr;
+            Object right_scratch;
+            Object* right = eval_operand(prefix->right, env, &right_scratch);
+            return eval_prefix_expression(prefix->operator, right, scratch);
+        }
+        case CALL_EXPRESSION:
+            return eval_call_expression((AST_Expression_Call*)expr, env, scratch);
+        default:
+            return eval((AST_Node*)expr, env);
     }
-    // All other objects (integers, strings, etc.) are truthy for now
-    return 1;
+}
+
+static int is_truthy(Object* obj) {
+    return obj != NULL && omni_is_truthy(object_to_omni(obj)); // NULL is falsy
 }
 
 static Object* eval_block_statement(AST_Statement_Block* block, Environment* env) {
@@ -265,11 +691,15 @@ static Object* eval_block_statement(AST_Statement_Block* block, Environment* env
 }
 
 static Object* eval_if_statement(AST_Statement_If* if_stmt, Environment* env) {
-    Object* condition = eval((AST_Node*)if_stmt->condition, env);
+    Object scratch;
+    Object* condition = eval_operand(if_stmt->condition, env, &scratch);
 
     if (is_truthy(condition)) {
+        if_stmt->profile.taken++;
         return eval_block_statement(if_stmt->consequence, env);
-    } else if (if_stmt->alternative != NULL) {
+    }
+    if_stmt->profile.not_taken++;
+    if (if_stmt->alternative != NULL) {
         // Recursively evaluate elif/else
         return eval((AST_Node*)if_stmt->alternative, env);
     } else {
@@ -277,24 +707,266 @@ static Object* eval_if_statement(AST_Statement_If* if_stmt, Environment* env) {
     }
 }
 
-static Object** eval_expressions(AST_Expression** exprs, int count, Environment* env) {
-    Object** result = malloc(count * sizeof(Object*));
-    if (result == NULL) {
-        fprintf(stderr, "Fatal: Memory allocation failed for evaluated expressions.\n");
-        exit(1);
+static Object* eval_while_statement(AST_Statement_While* while_stmt, Environment* env) {
+    // Only top-level loops are replaced on the stack; loops in functions tier up with them
+    int osr_candidate = env == tier_globals && current_function == NULL && tier_enabled();
+    Object scratch;
+    while (is_truthy(eval_operand(while_stmt->condition, env, &scratch))) {
+        while_stmt->profile.taken++;
+        if (current_function != NULL) current_function->backedge_count++;
+        Object* result = eval_block_statement(while_stmt->body, env);
+        if (result != NULL && result->type == OBJ_RETURN_VALUE) {
+            return result; // Propagate return value up
+        }
+        // At the end of an iteration, the native loop picks up right at its header
+        if (osr_candidate && (while_stmt->osr == NULL || !while_stmt->osr->failed) &&
+            ++while_stmt->backedge_count >= TIER_OSR_THRESHOLD) {
+            if (osr_enter(while_stmt)) return new_nil_object(); // A deopt resumes here, with the condition
+        }
+    }
+    while_stmt->profile.not_taken++;
+    return new_nil_object();
+}
+
+// The body runs exactly as it would outside a `try`: an error unwinds
+// straight back here from wherever it was raised (see omni_error.h).
+static Object* eval_try_statement(AST_Statement_Try* try_stmt, Environment* env) {
+    ObjectFunction* function = current_function;
+    OmniHandler handler;
+    if (OMNI_TRY(&handler)) {
+        Object* result = eval_block_statement(try_stmt->body, env);
+        omni_try_end(&handler);
+        return result; // Possibly a return, propagated like any block's
+    }
+
+    current_function = function; // The calls the error came out of never restored it
+    if (try_stmt->name != NULL) {
+        set_environment(env, try_stmt->name->value, new_string_object(omni_error_message()));
+    }
+    return eval_block_statement(try_stmt->handler, env);
+}
+
+static Object* eval_class_definition(AST_Statement_ClassDef* class_def, Environment* env) {
+    ObjectClass* superclass = NULL;
+    if (class_def->superclass != NULL) {
+        Object* parent = get_environment(env, class_def->superclass->value);
+        if (parent == NULL || parent->type != OBJ_CLASS) {
+            omni_raise("Superclass '%s' of '%s' is not a class.",
+                       class_def->superclass->value, class_def->name->value);
+        }
+        superclass = parent->value.klass;
+    }
+
+    Object* class_obj = new_class_object(class_def->name->value, superclass);
+    set_environment(env, class_def->name->value, class_obj);
+
+    AST_Statement_Block* body = class_def->body;
+    for (int i = 0; body != NULL && i < body->statement_count; i++) {
+        AST_Statement* stmt = body->statements[i];
+        if (stmt->type == FN_DEFINITION) {
+            AST_Statement_FnDef* fn_def = (AST_Statement_FnDef*)stmt;
+            Object* method = new_function_object(fn_def->name->value, fn_def->parameters, fn_def->parameter_count,
+                                                 fn_def->body, fn_def->captures, fn_def->capture_count,
+                                                 fn_def->frame, env);
+            class_set_member(class_obj->value.klass, fn_def->name->value, method);
+        } else if (stmt->type == SET_STATEMENT || stmt->type == ASSIGN_STATEMENT) {
+            AST_Statement_Set* set_stmt = (AST_Statement_Set*)stmt;
+            Object* value = eval((AST_Node*)set_stmt->value, env);
+            class_set_member(class_obj->value.klass, set_stmt->name->value, value);
+        } else {
+            eval((AST_Node*)stmt, env);
+        }
+    }
+    return class_obj;
+}
+
+static Object* get_member(AST_Expression_MemberAccess* member, Object* object) {
+    if (object->type == OBJ_INSTANCE) {
+        ObjectInstance* instance = object->value.instance;
+
+        // Fast path: a shape check and a load.
+        const InlineCacheEntry* hit = inline_cache_find(&member->cache, instance->shape);
+        if (hit != NULL) {
+            return instance->slots[hit->slot];
+        }
+
+        int slot = shape_lookup(instance->shape, member->property);
+        if (slot >= 0) {
+            inline_cache_record(&member->cache, instance->shape, NULL, slot);
+            return instance->slots[slot];
+        }
+
+        Object* value = class_find_member(instance->klass, member->property);
+        if (value != NULL) {
+            if (value->type == OBJ_FUNCTION) {
+                return new_bound_method_object(object, value);
+            }
+            return value;
+        }
+    } else if (object->type == OBJ_CLASS) {
+        Object* value = class_find_member(object->value.klass, member->property);
+        if (value != NULL) {
+            return value;
+        }
+    }
+
+    omni_raise("Object has no property '%s'.", member->property);
+}
+
+static Object* eval_member_access(AST_Expression_MemberAccess* member, Environment* env) {
+    Object* object = eval((AST_Node*)member->object, env);
+    return get_member(member, object);
+}
+
+static Object* eval_member_set(AST_Statement_MemberSet* stmt, Environment* env) {
+    AST_Expression_MemberAccess* target = stmt->target;
+    Object* object = eval((AST_Node*)target->object, env);
+    Object* val = eval((AST_Node*)stmt->value, env);
+    if (val == NULL) {
+        return NULL;
+    }
+
+    if (object->type == OBJ_CLASS) {
+        class_set_member(object->value.klass, target->property, val);
+        return val;
+    }
+    if (object->type != OBJ_INSTANCE) {
+        omni_raise("Cannot set property '%s' on a non-instance.", target->property);
+    }
+
+    ObjectInstance* instance = object->value.instance;
+    Shape* transition;
+    int slot;
+
+    const InlineCacheEntry* hit = inline_cache_find(&target->cache, instance->shape);
+    if (hit != NULL) {
+        transition = hit->transition;
+        slot = hit->slot;
+    } else {
+        slot = shape_lookup(instance->shape, target->property);
+        transition = NULL;
+        if (slot < 0) {
+            transition = shape_add_property(instance->shape, target->property);
+            slot = transition->slot_count - 1;
+        }
+        inline_cache_record(&target->cache, instance->shape, transition, slot);
+    }
+
+    if (transition != NULL) {
+        if (slot >= instance->slot_capacity) {
+            int capacity = instance->slot_capacity * 2;
+            instance = realloc(instance, sizeof(ObjectInstance) + capacity * sizeof(Object*));
+            instance->slot_capacity = capacity;
+            object->value.instance = instance;
+        }
+        instance->shape = transition;
+    }
+    instance->slots[slot] = val;
+    return val;
+}
+
+// Evaluates the call's arguments into `args`, starting at index `offset`.
+static void eval_call_arguments(AST_Expression_Call* call, Environment* env, Object** args, int offset) {
+    for (int i = 0; i < call->argument_count; i++) {
+        args[offset + i] = eval((AST_Node*)call->arguments[i], env);
     }
-    for (int i = 0; i < count; i++) {
-        result[i] = eval((AST_Node*)exprs[i], env);
+}
+
+static Object* method_cache_lookup(MethodCache* cache, Shape* shape) {
+    if (cache->epoch != class_epoch) {
+        cache->count = 0;
+        cache->epoch = class_epoch;
+        return NULL;
+    }
+    for (int i = 0; i < cache->count; i++) {
+        if (cache->entries[i].shape == shape) {
+            return cache->entries[i].method;
+        }
+    }
+    return NULL;
+}
+
+static void method_cache_record(MethodCache* cache, Shape* shape, Object* method) {
+    if (cache->count >= INLINE_CACHE_ENTRIES) return; // Megamorphic: keep the resolved entries
+    cache->entries[cache->count].shape = shape;
+    cache->entries[cache->count].method = method;
+    cache->count++;
+}
+
+// `obj.method(args)`: resolves the method through the call-site cache and
+// passes the receiver as `self` directly, without building a bound method.
+static Object* eval_method_call(AST_Expression_Call* call, Environment* env, Object* into) {
+    AST_Expression_MemberAccess* member = (AST_Expression_MemberAccess*)call->function;
+    Object* receiver = eval((AST_Node*)member->object, env);
+    Object* method = NULL;
+
+    if (receiver->type == OBJ_INSTANCE) {
+        ObjectInstance* instance = receiver->value.instance;
+        method = method_cache_lookup(&call->method_cache, instance->shape);
+        if (method == NULL && shape_lookup(instance->shape, member->property) < 0) {
+            method = class_find_member(instance->klass, member->property);
+            if (method != NULL && method->type == OBJ_FUNCTION) {
+                method_cache_record(&call->method_cache, instance->shape, method);
+            } else {
+                method = NULL;
+            }
+        }
+    }
+
+    int arg_count = call->argument_count;
+    Object* stack_args[CALL_STACK_ARGS];
+    Object** args = stack_args;
+    if (arg_count + 1 > CALL_STACK_ARGS) {
+        args = malloc((arg_count + 1) * sizeof(Object*));
+    }
+
+    call->profile.count++;
+    Object* result;
+    if (method != NULL) {
+        args[0] = receiver;
+        eval_call_arguments(call, env, args, 1);
+        result = apply_function(method, args, arg_count + 1, into);
+    } else {
+        // A field holding a callable, a class attribute, or a non-instance receiver.
+        Object* function = get_member(member, receiver);
+        eval_call_arguments(call, env, args, 0);
+        result = apply_function(function, args, arg_count, into);
+    }
+
+    if (args != stack_args) {
+        free(args);
     }
     return result;
 }
 
+// With `into` set, a scalar result of native code is stored there (see eval_operand).
+static Object* eval_call_expression(AST_Expression_Call* call, Environment* env, Object* into) {
+    if (call->function->type == MEMBER_ACCESS_EXPRESSION) {
+        return eval_method_call(call, env, into);
+    }
+    Object* function = eval((AST_Node*)call->function, env);
+    if (function == NULL) return NULL; // Error handling
+    call->profile.count++;
+
+    // The callee copies the arguments into its environment, so the array can live here
+    int arg_count = call->argument_count;
+    Object* stack_args[CALL_STACK_ARGS];
+    Object** args = arg_count <= CALL_STACK_ARGS ? stack_args : malloc(arg_count * sizeof(Object*));
+    eval_call_arguments(call, env, args, 0);
+
+    Object* result = apply_function(function, args, arg_count, into);
+    if (args != stack_args) free(args);
+    return result;
+}
+
 static Object* eval(AST_Node* node, Environment* env) {
     switch (node->type) {
         case EXPRESSION_STATEMENT:
             return eval((AST_Node*)((AST_Statement_Expression*)node)->expression, env);
         case INTEGER_LITERAL:
             return new_integer_object(((AST_Expression_IntegerLiteral*)node)->value);
+        case FLOAT_LITERAL:
+            return new_float_object(((AST_Expression_FloatLiteral*)node)->value);
         case BOOLEAN_LITERAL:
             return new_boolean_object(((AST_Expression_Boolean*)node)->value);
         case NIL_LITERAL:
@@ -303,49 +975,86 @@ static Object* eval(AST_Node* node, Environment* env) {
             return new_string_object(((AST_Expression_StringLiteral*)node)->value);
         case SET_STATEMENT:
             return eval_set_statement((AST_Statement_Set*)node, env);
+        case ASSIGN_STATEMENT:
+            return eval_assign_statement((AST_Statement_Set*)node, env);
+        case MEMBER_SET_STATEMENT:
+            return eval_member_set((AST_Statement_MemberSet*)node, env);
+        case MEMBER_ACCESS_EXPRESSION:
+            return eval_member_access((AST_Expression_MemberAccess*)node, env);
+        case CLASS_DEFINITION:
+            return eval_class_definition((AST_Statement_ClassDef*)node, env);
         case IDENTIFIER:
             return eval_identifier((AST_Expression_Identifier*)node, env);
         case INFIX_EXPRESSION:
-            return eval_infix_expression((AST_Expression_Infix*)node, env);
+            return eval_infix_expression((AST_Expression_Infix*)node, env, NULL);
         case PREFIX_EXPRESSION: {
             AST_Expression_Prefix* prefix_expr = (AST_Expression_Prefix*)node;
-            Object* right = eval((AST_Node*)prefix_expr->right, env);
-            return eval_prefix_expression(prefix_expr->operator, right);
+            Object right_scratch;
+            Object* right = eval_operand(prefix_expr->right, env, &right_scratch);
+            return eval_prefix_expression(prefix_expr->operator, right, NULL);
         }
         case IF_STATEMENT:
             return eval_if_statement((AST_Statement_If*)node, env);
+        case WHILE_STATEMENT:
+            return eval_while_statement((AST_Statement_While*)node, env);
+        case TRY_STATEMENT:
+            return eval_try_statement((AST_Statement_Try*)node, env);
         case BLOCK_STATEMENT: // This case is needed for consequence and alternative blocks
             return eval_block_statement((AST_Statement_Block*)node, env);
         case RETURN_STATEMENT: {
             AST_Statement_Return* ret_stmt = (AST_Statement_Return*)node;
             Object* val = eval((AST_Node*)ret_stmt->return_value, env);
-            return new_return_value_object(val);
+            // Only the enclosing blocks and the call see the wrapper
+            env->returned.type = OBJ_RETURN_VALUE;
+            env->returned.value.return_value = val;
+            return &env->returned;
         }
         case FN_DEFINITION: {
             AST_Statement_FnDef* fn_def = (AST_Statement_FnDef*)node;
-            Object* fn_obj = new_function_object(fn_def->parameters, fn_def->parameter_count, fn_def->body, env);
+            Object* fn_obj = new_function_object(fn_def->name->value, fn_def->parameters, fn_def->parameter_count,
+                                                 fn_def->body, fn_def->captures, fn_def->capture_count,
+                                                 fn_def->frame, env);
             set_environment(env, fn_def->name->value, fn_obj);
             return fn_obj;
         }
-        case CALL_EXPRESSION: {
-            AST_Expression_Call* call_expr = (AST_Expression_Call*)node;
-            Object* function = eval((AST_Node*)call_expr->function, env);
-            if (function == NULL) return NULL; // Error handling
-
-            Object** args = eval_expressions(call_expr->arguments, call_expr->argument_count, env);
-            if (args == NULL) return NULL; // Error handling
-
-            Object* result = apply_function(function, args, call_expr->argument_count);
-            // TODO: Free args array
-            return result;
+        case FN_LITERAL: {
+            AST_Expression_FnLiteral* fn_lit = (AST_Expression_FnLiteral*)node;
+            return new_function_object(NULL, fn_lit->parameters, fn_lit->parameter_count, fn_lit->body,
+                                       fn_lit->captures, fn_lit->capture_count, fn_lit->frame, env);
         }
+        case CALL_EXPRESSION:
+            return eval_call_expression((AST_Expression_Call*)node, env, NULL);
         default:
             return NULL;
     }
 }
 
+// --- Builtins ---
+
+// Prints its arguments on one line, separated by spaces.
+static Object* builtin_print(Object** args, int arg_count) {
+    for (int i = 0; i < arg_count; i++) {
+        if (i > 0) printf(" ");
+        print_object(args[i]);
+    }
+    printf("\n");
+    return new_nil_object();
+}
+
+static void define_builtin(Environment* env, const char* name, BuiltinFunction function) {
+    Object* obj = malloc(sizeof(Object));
+    obj->type = OBJ_BUILTIN;
+    obj->value.builtin = function;
+    set_environment(env, intern(name), obj);
+}
+
 Object* interpret(AST_Program* program) {
+    init_name = intern("init");
+    resolve_program(program);
+    infer_types(program, NULL); // Used by the tiered JIT
     Environment* env = new_environment();
+    tier_globals = env;
+    define_builtin(env, "print", builtin_print);
     return eval_program(program, env);
 }
 
@@ -358,6 +1067,9 @@ void print_object(Object* obj) {
         case OBJ_INTEGER:
             printf("%lld", obj->value.integer);
             break;
+        case OBJ_FLOAT:
+            printf("%g", obj->value.floating);
+            break;
         case OBJ_BOOLEAN:
             printf("%s", obj->value.boolean ? "true" : "false");
             break;
@@ -373,6 +1085,18 @@ void print_object(Object* obj) {
         case OBJ_FUNCTION:
             printf("<function>");
             break;
+        case OBJ_CLASS:
+            printf("<class %s>", obj->value.klass->name);
+            break;
+        case OBJ_INSTANCE:
+            printf("<%s instance>", obj->value.instance->klass->name);
+            break;
+        case OBJ_BOUND_METHOD:
+            printf("<bound method>");
+            break;
+        case OBJ_BUILTIN:
+            printf("<builtin function>");
+            break;
         default:
             printf("Unknown object type\n");
             break;
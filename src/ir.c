@@ -0,0 +1,830 @@
+#include "ir.h"
+#include "resolver.h"
+#include "type_infer.h"
+#include "intern.h"
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+// --- Name Index ---
+
+// The slot holding `name`, or the empty slot where it belongs.
+static int name_slot(const IRNameIndex* index, const char* name) {
+    int mask = index->capacity - 1;
+    int slot = intern_hash(name) & mask;
+    while (index->names[slot] != NULL && index->names[slot] != name) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+int ir_name_index_get(const IRNameIndex* index, const char* name) {
+    if (index->capacity == 0) return -1;
+    int slot = name_slot(index, name);
+    return index->names[slot] != NULL ? index->indices[slot] : -1;
+}
+
+void ir_name_index_set(IRNameIndex* index, const char* name, int value) {
+    if ((index->count + 1) * 4 > index->capacity * 3) { // Under 3/4 load
+        IRNameIndex grown = { NULL, NULL, index->capacity ? index->capacity * 2 : 16, 0 };
+        grown.names = calloc(grown.capacity, sizeof(const char*));
+        grown.indices = malloc(grown.capacity * sizeof(int));
+        for (int i = 0; i < index->capacity; i++) {
+            if (index->names[i] != NULL) ir_name_index_set(&grown, index->names[i], index->indices[i]);
+        }
+        ir_name_index_free(index);
+        *index = grown;
+    }
+    int slot = name_slot(index, name);
+    if (index->names[slot] == NULL) {
+        index->names[slot] = name;
+        index->count++;
+    }
+    index->indices[slot] = value;
+}
+
+void ir_name_index_free(IRNameIndex* index) {
+    free(index->names);
+    free(index->indices);
+    *index = (IRNameIndex){0};
+}
+
+// --- Construction ---
+
+int ir_add_block(IRFunction* fn) {
+    if (fn->block_count == fn->block_capacity) {
+        fn->block_capacity = fn->block_capacity ? fn->block_capacity * 2 : 8;
+        fn->blocks = realloc(fn->blocks, fn->block_capacity * sizeof(IRBlock));
+    }
+    fn->blocks[fn->block_count] = (IRBlock){0};
+    return fn->block_count++;
+}
+
+static void block_insert(IRBlock* block, int position, int value) {
+    if (block->instr_count == block->instr_capacity) {
+        block->instr_capacity = block->instr_capacity ? block->instr_capacity * 2 : 8;
+        block->instrs = realloc(block->instrs, block->instr_capacity * sizeof(int));
+    }
+    memmove(&block->instrs[position + 1], &block->instrs[position], (block->instr_count - position) * sizeof(int));
+    block->instrs[position] = value;
+    block->instr_count++;
+}
+
+static int new_instr(IRFunction* fn, int block, IROp op, IRType type, const int* args, int arg_count) {
+    if (fn->instr_count == fn->instr_capacity) {
+        fn->instr_capacity = fn->instr_capacity ? fn->instr_capacity * 2 : 32;
+        fn->instrs = realloc(fn->instrs, fn->instr_capacity * sizeof(IRInstr));
+    }
+    IRInstr* instr = &fn->instrs[fn->instr_count];
+    *instr = (IRInstr){0};
+    instr->op = op;
+    instr->type = type;
+    instr->block = block;
+    instr->targets[0] = instr->targets[1] = -1;
+    if (arg_count > 0) {
+        instr->args = malloc(arg_count * sizeof(int));
+        memcpy(instr->args, args, arg_count * sizeof(int));
+    }
+    instr->arg_count = arg_count;
+    return fn->instr_count++;
+}
+
+int ir_insert(IRFunction* fn, int block, int position, IROp op, IRType type, const int* args, int arg_count) {
+    int value = new_instr(fn, block, op, type, args, arg_count);
+    block_insert(&fn->blocks[block], position, value);
+    return value;
+}
+
+int ir_append(IRFunction* fn, int block, IROp op, IRType type, const int* args, int arg_count) {
+    return ir_insert(fn, block, fn->blocks[block].instr_count, op, type, args, arg_count);
+}
+
+// Phis go after the block's other phis, ahead of everything else.
+static int insert_phi(IRFunction* fn, int block) {
+    IRBlock* b = &fn->blocks[block];
+    int position = 0;
+    while (position < b->instr_count && fn->instrs[b->instrs[position]].op == IR_PHI) position++;
+    return ir_insert(fn, block, position, IR_PHI, IR_VALUE, NULL, 0);
+}
+
+static void add_arg(IRInstr* instr, int value) {
+    instr->args = realloc(instr->args, (instr->arg_count + 1) * sizeof(int));
+    instr->args[instr->arg_count++] = value;
+}
+
+void ir_add_pred(IRFunction* fn, int block, int pred) {
+    IRBlock* b = &fn->blocks[block];
+    b->preds = realloc(b->preds, (b->pred_count + 1) * sizeof(int));
+    b->preds[b->pred_count++] = pred;
+}
+
+void ir_remove_instr(IRFunction* fn, int value) {
+    IRInstr* instr = &fn->instrs[value];
+    if (instr->block < 0) return;
+    IRBlock* b = &fn->blocks[instr->block];
+    for (int i = 0; i < b->instr_count; i++) {
+        if (b->instrs[i] == value) {
+            memmove(&b->instrs[i], &b->instrs[i + 1], (b->instr_count - i - 1) * sizeof(int));
+            b->instr_count--;
+            break;
+        }
+    }
+    instr->block = -1;
+}
+
+void ir_replace_uses(IRFunction* fn, int value, int replacement) {
+    for (int i = 0; i < fn->instr_count; i++) {
+        IRInstr* instr = &fn->instrs[i];
+        if (instr->block < 0) continue;
+        for (int j = 0; j < instr->arg_count; j++) {
+            if (instr->args[j] == value) instr->args[j] = replacement;
+        }
+    }
+}
+
+int ir_is_terminator(IROp op) {
+    return op == IR_JUMP || op == IR_BRANCH || op == IR_RETURN;
+}
+
+int ir_terminator(IRFunction* fn, int block) {
+    IRBlock* b = &fn->blocks[block];
+    if (b->instr_count == 0) return -1;
+    int last = b->instrs[b->instr_count - 1];
+    return ir_is_terminator(fn->instrs[last].op) ? last : -1;
+}
+
+int ir_reverse_postorder(IRFunction* fn, int* order) {
+    char* visited = calloc(fn->block_count, 1);
+    int* stack = malloc(fn->block_count * sizeof(int));
+    int* next = malloc(fn->block_count * sizeof(int)); // Successor to visit next, per stacked block
+    int depth = 0, count = 0;
+
+    visited[0] = 1;
+    stack[depth] = 0;
+    next[depth++] = 0;
+    while (depth > 0) {
+        int block = stack[depth - 1];
+        int terminator = ir_terminator(fn, block);
+        int successor = -1;
+        while (successor < 0 && terminator >= 0 && next[depth - 1] < 2) {
+            int target = fn->instrs[terminator].targets[next[depth - 1]++];
+            if (target >= 0 && !visited[target]) successor = target;
+        }
+        if (successor >= 0) {
+            visited[successor] = 1;
+            stack[depth] = successor;
+            next[depth++] = 0;
+        } else {
+            order[count++] = block; // Postorder, reversed below
+            depth--;
+        }
+    }
+    for (int i = 0; i < count / 2; i++) {
+        int swap = order[i];
+        order[i] = order[count - 1 - i];
+        order[count - 1 - i] = swap;
+    }
+    free(visited);
+    free(stack);
+    free(next);
+    return count;
+}
+
+static IRFunction* new_function(const char* name, int parameter_count) {
+    IRFunction* fn = calloc(1, sizeof(IRFunction));
+    fn->name = name;
+    fn->parameter_count = parameter_count;
+    return fn;
+}
+
+static void function_free(IRFunction* fn) {
+    if (fn == NULL) return;
+    for (int i = 0; i < fn->instr_count; i++) free(fn->instrs[i].args);
+    for (int i = 0; i < fn->block_count; i++) {
+        free(fn->blocks[i].instrs);
+        free(fn->blocks[i].preds);
+    }
+    free(fn->instrs);
+    free(fn->blocks);
+    free(fn);
+}
+
+void ir_program_free(IRProgram* program) {
+    if (program == NULL) return;
+    function_free(program->main);
+    for (int i = 0; i < program->function_count; i++) function_free(program->functions[i]);
+    free(program->functions);
+    free(program->globals);
+    ir_name_index_free(&program->function_indices);
+    ir_name_index_free(&program->global_indices);
+    free(program);
+}
+
+// --- Lowering ---
+
+typedef struct {
+    const char* name;
+    int value;
+} VarDef;
+
+typedef struct {
+    IRNameIndex defs;   // Current definition of each variable at the end of the block
+    VarDef* incomplete; // Phis of an unsealed block waiting for their operands
+    int incomplete_count;
+} BlockVars;
+
+typedef struct {
+    AST_Program* ast;
+    IRProgram* program;
+    const char* error;   // First reason the program can't be lowered
+
+    IRFunction* fn;
+    BlockVars* vars;     // Per block of fn
+    int vars_capacity;
+    int block;           // Current block; -1 once it is terminated
+    int in_function;
+    const char* print_name;
+    const char* result_name;
+    IRNameIndex arities; // Top-level function -> parameter count
+} Lowering;
+
+static void lower_error(Lowering* l, const char* format, ...) {
+    static char message[256];
+    if (l->error != NULL) return;
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+    l->error = message;
+}
+
+static int new_block(Lowering* l) {
+    int block = ir_add_block(l->fn);
+    if (block >= l->vars_capacity) {
+        l->vars_capacity = l->vars_capacity ? l->vars_capacity * 2 : 16;
+        l->vars = realloc(l->vars, l->vars_capacity * sizeof(BlockVars));
+    }
+    l->vars[block] = (BlockVars){0};
+    return block;
+}
+
+
+static int emit(Lowering* l, IROp op, IRType type, const int* args, int arg_count) {
+    return ir_append(l->fn, l->block, op, type, args, arg_count);
+}
+
+static int emit_const(Lowering* l, IRType type, OmniValue constant) {
+    int value = emit(l, IR_CONST, type, NULL, 0);
+    l->fn->instrs[value].constant = constant;
+    return value;
+}
+
+static int emit_nil(Lowering* l) {
+    return emit_const(l, IR_VALUE, omni_new_nil());
+}
+
+static void emit_jump(Lowering* l, int target) {
+    int jump = emit(l, IR_JUMP, IR_VALUE, NULL, 0);
+    l->fn->instrs[jump].targets[0] = target;
+    ir_add_pred(l->fn, target, l->block);
+}
+
+// --- SSA Construction ---
+
+static int read_variable(Lowering* l, int block, const char* name);
+
+static void write_variable(Lowering* l, int block, const char* name, int value) {
+    ir_name_index_set(&l->vars[block].defs, name, value);
+}
+
+static void add_phi_operands(Lowering* l, int block, const char* name, int phi) {
+    for (int i = 0; i < l->fn->blocks[block].pred_count; i++) {
+        int value = read_variable(l, l->fn->blocks[block].preds[i], name);
+        add_arg(&l->fn->instrs[phi], value);
+    }
+}
+
+static int read_variable_recursive(Lowering* l, int block, const char* name) {
+    IRBlock* b = &l->fn->blocks[block];
+    int value;
+    if (!b->sealed) {
+        value = insert_phi(l->fn, block);
+        BlockVars* vars = &l->vars[block]; // Once per name: the phi becomes its definition below
+        vars->incomplete = realloc(vars->incomplete, (vars->incomplete_count + 1) * sizeof(VarDef));
+        vars->incomplete[vars->incomplete_count++] = (VarDef){ name, value };
+    } else if (b->pred_count == 1) {
+        value = read_variable(l, b->preds[0], name);
+    } else if (b->pred_count == 0) {
+        lower_error(l, "'%s' may be used before it is set", name);
+        value = ir_append(l->fn, block, IR_CONST, IR_VALUE, NULL, 0);
+        l->fn->instrs[value].constant = omni_new_nil();
+    } else {
+        value = insert_phi(l->fn, block);
+        write_variable(l, block, name, value); // Breaks cycles through loops
+        add_phi_operands(l, block, name, value);
+    }
+    write_variable(l, block, name, value);
+    return value;
+}
+
+static int read_variable(Lowering* l, int block, const char* name) {
+    int value = ir_name_index_get(&l->vars[block].defs, name);
+    return value >= 0 ? value : read_variable_recursive(l, block, name);
+}
+
+static void seal_block(Lowering* l, int block) {
+    BlockVars* vars = &l->vars[block];
+    for (int i = 0; i < vars->incomplete_count; i++) {
+        add_phi_operands(l, block, vars->incomplete[i].name, vars->incomplete[i].value);
+    }
+    free(vars->incomplete);
+    vars->incomplete = NULL;
+    vars->incomplete_count = 0;
+    l->fn->blocks[block].sealed = 1;
+}
+
+// --- Conversions ---
+
+static IRType ir_type_of(AST_StaticType type) {
+    switch (type) {
+        case STATIC_INTEGER: return IR_INT;
+        case STATIC_FLOAT: return IR_FLOAT;
+        case STATIC_BOOLEAN: return IR_BOOL;
+        default: return IR_VALUE;
+    }
+}
+
+static int boxed(Lowering* l, int value) {
+    if (l->fn->instrs[value].type == IR_VALUE) return value;
+    return emit(l, IR_BOX, IR_VALUE, &value, 1);
+}
+
+// `value` as `type`, which type inference proved it has.
+static int unboxed(Lowering* l, int value, IRType type) {
+    IRType from = l->fn->instrs[value].type;
+    if (from == type) return value;
+    if (from == IR_INT && type == IR_FLOAT) return emit(l, IR_INT_TO_FLOAT, IR_FLOAT, &value, 1);
+    if (from != IR_VALUE) value = boxed(l, value);
+    return emit(l, IR_UNBOX, type, &value, 1);
+}
+
+static int truthy(Lowering* l, int value) {
+    if (l->fn->instrs[value].type == IR_BOOL) return value;
+    value = boxed(l, value);
+    return emit(l, IR_TRUTHY, IR_BOOL, &value, 1);
+}
+
+// --- Expressions ---
+
+static const struct {
+    const char* operator;
+    IRBinaryOp op;
+} binary_operators[] = {
+    { "+", IR_ADD }, { "-", IR_SUB }, { "*", IR_MUL }, { "/", IR_DIV },
+    { "==", IR_EQ }, { "!=", IR_NE }, { "<", IR_LT }, { ">", IR_GT }, { "<=", IR_LE }, { ">=", IR_GE },
+};
+
+static int is_global(Lowering* l, const char* name) {
+    return ir_name_index_get(&l->program->global_indices, name) >= 0;
+}
+
+static int find_function(Lowering* l, const char* name) {
+    return ir_name_index_get(&l->arities, name);
+}
+
+static int lower_expression(Lowering* l, AST_Expression* expr);
+
+static int lower_identifier(Lowering* l, AST_Expression_Identifier* ident) {
+    int value;
+    if (l->in_function && ident->scope == SCOPE_LOCAL) {
+        value = read_variable(l, l->block, ident->value);
+    } else if ((ident->scope == SCOPE_GLOBAL || !l->in_function) && is_global(l, ident->value)) {
+        value = emit(l, IR_GLOBAL_GET, IR_VALUE, NULL, 0);
+        l->fn->instrs[value].name = ident->value;
+    } else {
+        lower_error(l, "'%s' can't be referenced as a value", ident->value);
+        return emit_nil(l);
+    }
+    IRType type = ir_type_of(ident->base.static_type);
+    return type == IR_VALUE ? value : unboxed(l, value, type);
+}
+
+static int lower_infix(Lowering* l, AST_Expression_Infix* expr) {
+    int left = lower_expression(l, expr->left);
+    int right = lower_expression(l, expr->right);
+    for (size_t i = 0; i < sizeof(binary_operators) / sizeof(binary_operators[0]); i++) {
+        if (strcmp(expr->operator, binary_operators[i].operator) != 0) continue;
+        IRBinaryOp op = binary_operators[i].op;
+
+        // Statically numeric operands are computed unboxed; division stays
+        // with the runtime, which reports division by zero.
+        AST_StaticType left_type = expr->left->static_type, right_type = expr->right->static_type;
+        int numeric = (left_type == STATIC_INTEGER || left_type == STATIC_FLOAT) &&
+                      (right_type == STATIC_INTEGER || right_type == STATIC_FLOAT);
+        int args[2];
+        int value;
+        if (numeric && op != IR_DIV) {
+            IRType type = left_type == STATIC_INTEGER && right_type == STATIC_INTEGER ? IR_INT : IR_FLOAT;
+            args[0] = unboxed(l, left, type);
+            args[1] = unboxed(l, right, type);
+            value = emit(l, IR_BINARY, op >= IR_EQ ? IR_BOOL : type, args, 2);
+        } else {
+            args[0] = boxed(l, left);
+            args[1] = boxed(l, right);
+            value = emit(l, IR_BINARY, IR_VALUE, args, 2);
+        }
+        l->fn->instrs[value].binary = op;
+        return value;
+    }
+    lower_error(l, "Unknown infix operator: %s", expr->operator);
+    return emit_nil(l);
+}
+
+static int lower_prefix(Lowering* l, AST_Expression_Prefix* expr) {
+    int right = lower_expression(l, expr->right);
+    if (strcmp(expr->operator, "-") == 0) {
+        IRType type = ir_type_of(expr->right->static_type);
+        if (type == IR_INT || type == IR_FLOAT) {
+            right = unboxed(l, right, type);
+            return emit(l, IR_NEG, type, &right, 1);
+        }
+        right = boxed(l, right);
+        return emit(l, IR_NEG, IR_VALUE, &right, 1);
+    }
+    if (strcmp(expr->operator, "!") == 0) {
+        int condition = truthy(l, right);
+        return emit(l, IR_NOT, IR_BOOL, &condition, 1);
+    }
+    lower_error(l, "Unknown prefix operator: %s", expr->operator);
+    return emit_nil(l);
+}
+
+static int lower_call(Lowering* l, AST_Expression_Call* call) {
+    if (call->function->type != IDENTIFIER) {
+        lower_error(l, "Only calls to named functions are supported");
+        return emit_nil(l);
+    }
+    AST_Expression_Identifier* callee = (AST_Expression_Identifier*)call->function;
+    int parameter_count = callee->scope == SCOPE_GLOBAL ? find_function(l, callee->value) : -1;
+    int is_print = callee->value == l->print_name && parameter_count < 0;
+    if (!is_print && parameter_count < 0) {
+        lower_error(l, "'%s' is not a top-level function", callee->value);
+        return emit_nil(l);
+    }
+    if (!is_print && parameter_count != call->argument_count) {
+        lower_error(l, "Wrong number of arguments to '%s'. Expected %d, got %d.",
+                    callee->value, parameter_count, call->argument_count);
+        return emit_nil(l);
+    }
+
+    int* args = malloc((call->argument_count + 1) * sizeof(int));
+    for (int i = 0; i < call->argument_count; i++) {
+        args[i] = boxed(l, lower_expression(l, call->arguments[i]));
+    }
+    int value = emit(l, is_print ? IR_PRINT : IR_CALL, IR_VALUE, args, call->argument_count);
+    l->fn->instrs[value].name = callee->value;
+    free(args);
+    return value;
+}
+
+static int lower_expression(Lowering* l, AST_Expression* expr) {
+    if (expr == NULL) return emit_nil(l);
+    switch (expr->type) {
+        case INTEGER_LITERAL:
+            return emit_const(l, IR_INT, omni_new_integer(((AST_Expression_IntegerLiteral*)expr)->value));
+        case FLOAT_LITERAL:
+            return emit_const(l, IR_FLOAT, omni_new_float(((AST_Expression_FloatLiteral*)expr)->value));
+        case BOOLEAN_LITERAL:
+            return emit_const(l, IR_BOOL, omni_new_boolean(((AST_Expression_Boolean*)expr)->value ? 1 : 0));
+        case NIL_LITERAL:
+            return emit_nil(l);
+        case STRING_LITERAL: {
+            OmniValue string = { .type = OMNI_STRING };
+            string.value.string = ((AST_Expression_StringLiteral*)expr)->value; // Already interned
+            return emit_const(l, IR_VALUE, string);
+        }
+        case IDENTIFIER:
+            return lower_identifier(l, (AST_Expression_Identifier*)expr);
+        case INFIX_EXPRESSION:
+            return lower_infix(l, (AST_Expression_Infix*)expr);
+        case PREFIX_EXPRESSION:
+            return lower_prefix(l, (AST_Expression_Prefix*)expr);
+        case CALL_EXPRESSION:
+            return lower_call(l, (AST_Expression_Call*)expr);
+        default:
+            lower_error(l, "Unsupported expression type: %d", expr->type);
+            return emit_nil(l);
+    }
+}
+
+// --- Statements ---
+
+static int lower_statement(Lowering* l, AST_Statement* stmt);
+static void lower_function(Lowering* l, const char* name, AST_Expression_Identifier** parameters,
+                           int parameter_count, AST_Statement_Block* body);
+
+// Returns the value of the last statement, or -1.
+static int lower_block(Lowering* l, AST_Statement_Block* block) {
+    int value = -1;
+    if (block == NULL) return value;
+    for (int i = 0; i < block->statement_count && l->block >= 0; i++) {
+        value = lower_statement(l, block->statements[i]);
+    }
+    return value;
+}
+
+// An `if` evaluates to the branch it took, which matters for the program's
+// result; each branch leaves its value in a variable no program can name.
+static void write_branch_result(Lowering* l, int value) {
+    if (l->in_function || l->block < 0) return;
+    write_variable(l, l->block, l->result_name, value >= 0 ? boxed(l, value) : emit_nil(l));
+}
+
+static int lower_if(Lowering* l, AST_Statement_If* stmt) {
+    int condition = truthy(l, lower_expression(l, stmt->condition));
+    int then_block = new_block(l), else_block = new_block(l), merge_block = new_block(l);
+    int branch = emit(l, IR_BRANCH, IR_VALUE, &condition, 1);
+    l->fn->instrs[branch].targets[0] = then_block;
+    l->fn->instrs[branch].targets[1] = else_block;
+    ir_add_pred(l->fn, then_block, l->block);
+    ir_add_pred(l->fn, else_block, l->block);
+    seal_block(l, then_block);
+    seal_block(l, else_block);
+
+    l->block = then_block;
+    write_branch_result(l, lower_block(l, stmt->consequence));
+    if (l->block >= 0) emit_jump(l, merge_block);
+
+    l->block = else_block;
+    write_branch_result(l, stmt->alternative != NULL ? lower_statement(l, stmt->alternative) : -1);
+    if (l->block >= 0) emit_jump(l, merge_block);
+
+    seal_block(l, merge_block);
+    l->block = l->fn->blocks[merge_block].pred_count > 0 ? merge_block : -1;
+    if (l->in_function || l->block < 0) return -1;
+    return read_variable(l, l->block, l->result_name);
+}
+
+static void lower_while(Lowering* l, AST_Statement_While* stmt) {
+    int header = new_block(l), body = new_block(l), exit = new_block(l);
+    emit_jump(l, header);
+
+    l->block = header; // Unsealed until the back-edge is known
+    int condition = truthy(l, lower_expression(l, stmt->condition));
+    int branch = emit(l, IR_BRANCH, IR_VALUE, &condition, 1);
+    l->fn->instrs[branch].targets[0] = body;
+    l->fn->instrs[branch].targets[1] = exit;
+    ir_add_pred(l->fn, body, l->block);
+    ir_add_pred(l->fn, exit, l->block);
+    seal_block(l, body);
+    seal_block(l, exit);
+
+    l->block = body;
+    lower_block(l, stmt->body);
+    if (l->block >= 0) emit_jump(l, header);
+    seal_block(l, header);
+    l->block = exit;
+}
+
+// Returns the statement's value (what the interpreter would evaluate it to), or -1.
+static int lower_statement(Lowering* l, AST_Statement* stmt) {
+    if (stmt == NULL) return -1;
+    switch (stmt->type) {
+        case EXPRESSION_STATEMENT:
+            return lower_expression(l, ((AST_Statement_Expression*)stmt)->expression);
+
+        case SET_STATEMENT:
+        case ASSIGN_STATEMENT: {
+            AST_Statement_Set* set = (AST_Statement_Set*)stmt;
+            if (set->value != NULL && set->value->type == FN_LITERAL) {
+                AST_Expression_FnLiteral* fn = (AST_Expression_FnLiteral*)set->value;
+                lower_function(l, set->name->value, fn->parameters, fn->parameter_count, fn->body);
+                return -1;
+            }
+            int value = lower_expression(l, set->value);
+            if (l->in_function && set->name->scope == SCOPE_LOCAL) {
+                write_variable(l, l->block, set->name->value, boxed(l, value));
+            } else if (l->in_function && (set->name->scope != SCOPE_GLOBAL || !is_global(l, set->name->value))) {
+                lower_error(l, "'%s' can't be assigned", set->name->value);
+            } else {
+                int args[] = { boxed(l, value) };
+                int store = emit(l, IR_GLOBAL_SET, IR_VALUE, args, 1);
+                l->fn->instrs[store].name = set->name->value;
+            }
+            return value;
+        }
+
+        case FN_DEFINITION: {
+            AST_Statement_FnDef* fn = (AST_Statement_FnDef*)stmt;
+            lower_function(l, fn->name->value, fn->parameters, fn->parameter_count, fn->body);
+            return -1;
+        }
+
+        case RETURN_STATEMENT: {
+            AST_Statement_Return* ret = (AST_Statement_Return*)stmt;
+            if (!l->in_function) {
+                lower_error(l, "'return' outside of a function");
+                return -1;
+            }
+            int value = boxed(l, lower_expression(l, ret->return_value));
+            emit(l, IR_RETURN, IR_VALUE, &value, 1);
+            l->block = -1;
+            return -1;
+        }
+
+        case BLOCK_STATEMENT:
+            return lower_block(l, (AST_Statement_Block*)stmt);
+
+        case IF_STATEMENT:
+            return lower_if(l, (AST_Statement_If*)stmt);
+
+        case WHILE_STATEMENT:
+            lower_while(l, (AST_Statement_While*)stmt);
+            return emit_nil(l);
+
+        default:
+            lower_error(l, "Unsupported statement type: %d", stmt->type);
+            return -1;
+    }
+}
+
+static void lower_function(Lowering* l, const char* name, AST_Expression_Identifier** parameters,
+                           int parameter_count, AST_Statement_Block* body) {
+    if (l->in_function) {
+        lower_error(l, "Nested functions are not supported");
+        return;
+    }
+    IRFunction* saved_fn = l->fn;
+    BlockVars* saved_vars = l->vars;
+    int saved_capacity = l->vars_capacity, saved_block = l->block;
+
+    IRFunction* fn = new_function(name, parameter_count);
+    l->fn = fn;
+    l->vars = NULL;
+    l->vars_capacity = 0;
+    l->in_function = 1;
+    l->block = new_block(l);
+    seal_block(l, l->block);
+    for (int i = 0; i < parameter_count; i++) {
+        int param = emit(l, IR_PARAM, IR_VALUE, NULL, 0);
+        fn->instrs[param].index = i;
+        write_variable(l, l->block, parameters[i]->value, param);
+    }
+    lower_block(l, body);
+    if (l->block >= 0) { // Falling off the end returns nil
+        int nil = emit_nil(l);
+        emit(l, IR_RETURN, IR_VALUE, &nil, 1);
+    }
+
+    for (int i = 0; i < fn->block_count; i++) {
+        ir_name_index_free(&l->vars[i].defs);
+        free(l->vars[i].incomplete);
+    }
+    free(l->vars);
+    l->program->functions = realloc(l->program->functions, (l->program->function_count + 1) * sizeof(IRFunction*));
+    if (ir_name_index_get(&l->program->function_indices, name) < 0) { // Calls reach the first definition
+        ir_name_index_set(&l->program->function_indices, name, l->program->function_count);
+    }
+    l->program->functions[l->program->function_count++] = fn;
+
+    l->fn = saved_fn;
+    l->vars = saved_vars;
+    l->vars_capacity = saved_capacity;
+    l->block = saved_block;
+    l->in_function = 0;
+}
+
+IRProgram* ir_lower_program(AST_Program* ast) {
+    resolve_program(ast);
+    infer_types(ast, NULL);
+
+    Lowering l = {0};
+    l.ast = ast;
+    l.program = calloc(1, sizeof(IRProgram));
+    l.print_name = intern("print");
+    l.result_name = intern("<result>");
+
+    // Top-level functions and variables, so functions can refer to those defined further down
+    for (int i = 0; i < ast->statement_count; i++) {
+        AST_Statement* stmt = ast->statements[i];
+        if (stmt != NULL && stmt->type == FN_DEFINITION) {
+            AST_Statement_FnDef* fn = (AST_Statement_FnDef*)stmt;
+            if (find_function(&l, fn->name->value) < 0) {
+                ir_name_index_set(&l.arities, fn->name->value, fn->parameter_count);
+            }
+            continue;
+        }
+        AST_Statement_Set* set = (AST_Statement_Set*)stmt;
+        if (set == NULL || (set->base.type != SET_STATEMENT && set->base.type != ASSIGN_STATEMENT)) continue;
+        if (set->value != NULL && set->value->type == FN_LITERAL) {
+            if (set->base.type == SET_STATEMENT && find_function(&l, set->name->value) < 0) {
+                ir_name_index_set(&l.arities, set->name->value,
+                                  ((AST_Expression_FnLiteral*)set->value)->parameter_count);
+            }
+            continue;
+        }
+        if (is_global(&l, set->name->value)) continue;
+        l.program->globals = realloc(l.program->globals, (l.program->global_count + 1) * sizeof(const char*));
+        ir_name_index_set(&l.program->global_indices, set->name->value, l.program->global_count);
+        l.program->globals[l.program->global_count++] = set->name->value;
+    }
+
+    l.fn = l.program->main = new_function(NULL, 0);
+    l.block = new_block(&l);
+    seal_block(&l, l.block);
+    int last_value = -1;
+    for (int i = 0; i < ast->statement_count && l.block >= 0; i++) {
+        last_value = lower_statement(&l, ast->statements[i]);
+    }
+    if (l.block >= 0) {
+        int result = last_value >= 0 ? boxed(&l, last_value) : emit_nil(&l);
+        emit(&l, IR_RETURN, IR_VALUE, &result, 1);
+    }
+    for (int i = 0; i < l.fn->block_count; i++) {
+        ir_name_index_free(&l.vars[i].defs);
+        free(l.vars[i].incomplete);
+    }
+    free(l.vars);
+    ir_name_index_free(&l.arities);
+
+    if (l.error != NULL) {
+        fprintf(stderr, "IR: Can't lower the program: %s.\n", l.error);
+        ir_program_free(l.program);
+        return NULL;
+    }
+    return l.program;
+}
+
+// --- Printing ---
+
+static const char* type_names[] = { "value", "int", "float", "bool" };
+
+const char* ir_binary_name(IRBinaryOp op) {
+    static const char* names[] = { "add", "sub", "mul", "div", "eq", "ne", "lt", "gt", "le", "ge" };
+    return names[op];
+}
+
+static void print_instr(IRFunction* fn, int value, FILE* out) {
+    static const char* op_names[] = {
+        "const", "param", "phi", "box", "unbox", "truthy", "int_to_float", "", "neg", "not",
+        "global_get", "global_set", "call", "print", "jump", "branch", "return",
+    };
+    IRInstr* instr = &fn->instrs[value];
+    fprintf(out, "    ");
+    if (!ir_is_terminator(instr->op) && instr->op != IR_GLOBAL_SET) {
+        fprintf(out, "v%d:%s = ", value, type_names[instr->type]);
+    }
+    fprintf(out, "%s", instr->op == IR_BINARY ? ir_binary_name(instr->binary) : op_names[instr->op]);
+
+    if (instr->op == IR_CONST) {
+        switch (instr->constant.type) {
+            case OMNI_INTEGER: fprintf(out, " %lld", instr->constant.value.integer); break;
+            case OMNI_FLOAT: fprintf(out, " %g", instr->constant.value.floating); break;
+            case OMNI_BOOLEAN: fprintf(out, " %s", instr->constant.value.boolean ? "true" : "false"); break;
+            case OMNI_STRING: fprintf(out, " \"%s\"", instr->constant.value.string); break;
+            default: fprintf(out, " nil"); break;
+        }
+    } else if (instr->op == IR_PARAM) {
+        fprintf(out, " %d", instr->index);
+    } else if (instr->name != NULL) {
+        fprintf(out, " %s", instr->name);
+    }
+    for (int i = 0; i < instr->arg_count; i++) {
+        fprintf(out, "%s v%d", i == 0 ? "" : ",", instr->args[i]);
+        if (instr->op == IR_PHI) fprintf(out, " [b%d]", fn->blocks[instr->block].preds[i]);
+    }
+    if (instr->op == IR_JUMP) fprintf(out, " b%d", instr->targets[0]);
+    if (instr->op == IR_BRANCH) fprintf(out, ", b%d, b%d", instr->targets[0], instr->targets[1]);
+    fprintf(out, "\n");
+}
+
+static void print_function(IRFunction* fn, FILE* out) {
+    if (fn->name != NULL) {
+        fprintf(out, "fn %s/%d:\n", fn->name, fn->parameter_count);
+    } else {
+        fprintf(out, "main:\n");
+    }
+    for (int b = 0; b < fn->block_count; b++) {
+        IRBlock* block = &fn->blocks[b];
+        if (block->instr_count == 0) continue; // Removed
+        fprintf(out, "  b%d:", b);
+        if (block->pred_count > 0) {
+            fprintf(out, " ; preds");
+            for (int i = 0; i < block->pred_count; i++) fprintf(out, " b%d", block->preds[i]);
+        }
+        fprintf(out, "\n");
+        for (int i = 0; i < block->instr_count; i++) {
+            print_instr(fn, block->instrs[i], out);
+        }
+    }
+}
+
+void ir_print_program(IRProgram* program, FILE* out) {
+    for (int i = 0; i < program->global_count; i++) {
+        fprintf(out, "global %s\n", program->globals[i]);
+    }
+    for (int i = 0; i < program->function_count; i++) {
+        print_function(program->functions[i], out);
+    }
+    print_function(program->main, out);
+}
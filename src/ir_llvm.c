@@ -0,0 +1,390 @@
+#include "ir.h"
+#include <stdlib.h>
+#include <string.h>
+
+#include <llvm-c/Analysis.h>
+#include <llvm-c/Core.h>
+
+// --- IR -> LLVM ---
+// A direct translation: unboxed IR values become i64, double and i1 SSA
+// values, IR phis become LLVM phis, and boxed operations call the runtime
+// functions in omni_runtime.c.
+
+typedef struct {
+    LLVMContextRef context;
+    LLVMModuleRef main_module;
+    LLVMModuleRef module;      // Module being emitted into
+    LLVMBuilderRef builder;
+    LLVMTypeRef value_type;    // %OmniValue = { i32, i64 }
+    IRProgram* program;
+
+    IRFunction* fn;
+    LLVMValueRef function;
+    LLVMValueRef* values;      // Per IR value
+    LLVMBasicBlockRef* blocks; // Per IR block
+} Emitter;
+
+static LLVMTypeRef i1_type(Emitter* e) { return LLVMInt1TypeInContext(e->context); }
+static LLVMTypeRef i32_type(Emitter* e) { return LLVMInt32TypeInContext(e->context); }
+static LLVMTypeRef i64_type(Emitter* e) { return LLVMInt64TypeInContext(e->context); }
+static LLVMTypeRef double_type(Emitter* e) { return LLVMDoubleTypeInContext(e->context); }
+
+static LLVMTypeRef llvm_type(Emitter* e, IRType type) {
+    switch (type) {
+        case IR_INT: return i64_type(e);
+        case IR_FLOAT: return double_type(e);
+        case IR_BOOL: return i1_type(e);
+        default: return e->value_type;
+    }
+}
+
+// --- Values ---
+
+static LLVMValueRef const_value(Emitter* e, OmniType type, unsigned long long payload) {
+    LLVMValueRef fields[] = { LLVMConstInt(i32_type(e), type, 0), LLVMConstInt(i64_type(e), payload, 0) };
+    return LLVMConstNamedStruct(e->value_type, fields, 2);
+}
+
+static LLVMValueRef make_value(Emitter* e, OmniType type, LLVMValueRef payload) {
+    LLVMValueRef value = LLVMGetUndef(e->value_type);
+    value = LLVMBuildInsertValue(e->builder, value, LLVMConstInt(i32_type(e), type, 0), 0, "");
+    return LLVMBuildInsertValue(e->builder, value, payload, 1, "");
+}
+
+static LLVMValueRef payload(Emitter* e, LLVMValueRef value) {
+    return LLVMBuildExtractValue(e->builder, value, 1, "");
+}
+
+static LLVMValueRef runtime_function(Emitter* e, const char* name, LLVMTypeRef return_type,
+                                     LLVMTypeRef* params, unsigned param_count) {
+    LLVMValueRef function = LLVMGetNamedFunction(e->module, name);
+    if (function == NULL) {
+        LLVMTypeRef type = LLVMFunctionType(return_type, params, param_count, 0);
+        function = LLVMAddFunction(e->module, name, type);
+    }
+    return function;
+}
+
+static LLVMValueRef call_runtime(Emitter* e, const char* name, LLVMTypeRef return_type,
+                                 LLVMValueRef* args, unsigned arg_count) {
+    LLVMTypeRef params[4];
+    for (unsigned i = 0; i < arg_count; i++) {
+        params[i] = LLVMTypeOf(args[i]);
+    }
+    LLVMValueRef function = runtime_function(e, name, return_type, params, arg_count);
+    return LLVMBuildCall2(e->builder, LLVMGlobalGetValueType(function), function, args, arg_count, "");
+}
+
+static LLVMValueRef emit_constant(Emitter* e, IRInstr* instr) {
+    OmniValue constant = instr->constant;
+    switch (instr->type) {
+        case IR_INT: return LLVMConstInt(i64_type(e), (unsigned long long)constant.value.integer, 1);
+        case IR_FLOAT: return LLVMConstReal(double_type(e), constant.value.floating);
+        case IR_BOOL: return LLVMConstInt(i1_type(e), constant.value.boolean ? 1 : 0, 0);
+        default: break;
+    }
+    switch (constant.type) {
+        case OMNI_INTEGER: return const_value(e, OMNI_INTEGER, (unsigned long long)constant.value.integer);
+        case OMNI_FLOAT: {
+            unsigned long long bits;
+            memcpy(&bits, &constant.value.floating, sizeof(bits));
+            return const_value(e, OMNI_FLOAT, bits);
+        }
+        case OMNI_BOOLEAN: return const_value(e, OMNI_BOOLEAN, constant.value.boolean ? 1 : 0);
+        case OMNI_STRING: {
+            // Strings are interned by the runtime, so pointer equality holds across engines
+            LLVMValueRef chars = LLVMBuildGlobalStringPtr(e->builder, constant.value.string, "str");
+            return call_runtime(e, "omni_new_string", e->value_type, &chars, 1);
+        }
+        default: return const_value(e, OMNI_NIL, 0);
+    }
+}
+
+static LLVMValueRef emit_box(Emitter* e, LLVMValueRef value, IRType type) {
+    switch (type) {
+        case IR_INT: return make_value(e, OMNI_INTEGER, value);
+        case IR_FLOAT: return make_value(e, OMNI_FLOAT, LLVMBuildBitCast(e->builder, value, i64_type(e), ""));
+        case IR_BOOL: return make_value(e, OMNI_BOOLEAN, LLVMBuildZExt(e->builder, value, i64_type(e), ""));
+        default: return value;
+    }
+}
+
+static LLVMValueRef emit_unbox(Emitter* e, LLVMValueRef value, IRType type) {
+    LLVMValueRef bits = payload(e, value);
+    switch (type) {
+        case IR_INT: return bits;
+        case IR_FLOAT: return LLVMBuildBitCast(e->builder, bits, double_type(e), "");
+        default: {
+            // `boolean` is an int in the payload's low half
+            LLVMValueRef low = LLVMBuildTrunc(e->builder, bits, i32_type(e), "");
+            return LLVMBuildICmp(e->builder, LLVMIntNE, low, LLVMConstInt(i32_type(e), 0, 0), "");
+        }
+    }
+}
+
+// omni_is_truthy, inline so conditions on known types fold away.
+static LLVMValueRef emit_truthy(Emitter* e, LLVMValueRef value) {
+    LLVMValueRef tag = LLVMBuildExtractValue(e->builder, value, 0, "");
+    LLVMValueRef is_nil = LLVMBuildICmp(e->builder, LLVMIntEQ, tag, LLVMConstInt(i32_type(e), OMNI_NIL, 0), "");
+    LLVMValueRef is_boolean = LLVMBuildICmp(e->builder, LLVMIntEQ, tag, LLVMConstInt(i32_type(e), OMNI_BOOLEAN, 0), "");
+    return LLVMBuildSelect(e->builder, is_boolean, emit_unbox(e, value, IR_BOOL),
+                           LLVMBuildNot(e->builder, is_nil, ""), "truthy");
+}
+
+static LLVMValueRef emit_binary(Emitter* e, IRInstr* instr) {
+    static const char* runtime_names[] = {
+        "omni_add", "omni_subtract", "omni_multiply", "omni_divide", "omni_equal", "omni_not_equal",
+        "omni_less_than", "omni_greater_than", "omni_less_than_equal", "omni_greater_than_equal",
+    };
+    static const LLVMIntPredicate int_predicates[] = {
+        LLVMIntEQ, LLVMIntNE, LLVMIntSLT, LLVMIntSGT, LLVMIntSLE, LLVMIntSGE,
+    };
+    static const LLVMRealPredicate real_predicates[] = {
+        LLVMRealOEQ, LLVMRealUNE, LLVMRealOLT, LLVMRealOGT, LLVMRealOLE, LLVMRealOGE,
+    };
+    LLVMValueRef left = e->values[instr->args[0]], right = e->values[instr->args[1]];
+    IRType operand_type = e->fn->instrs[instr->args[0]].type;
+
+    if (operand_type == IR_VALUE) {
+        LLVMValueRef args[] = { left, right };
+        return call_runtime(e, runtime_names[instr->binary], e->value_type, args, 2);
+    }
+    if (operand_type == IR_INT) {
+        switch (instr->binary) {
+            case IR_ADD: return LLVMBuildAdd(e->builder, left, right, "");
+            case IR_SUB: return LLVMBuildSub(e->builder, left, right, "");
+            case IR_MUL: return LLVMBuildMul(e->builder, left, right, "");
+            case IR_DIV: return LLVMBuildSDiv(e->builder, left, right, "");
+            default: return LLVMBuildICmp(e->builder, int_predicates[instr->binary - IR_EQ], left, right, "");
+        }
+    }
+    switch (instr->binary) {
+        case IR_ADD: return LLVMBuildFAdd(e->builder, left, right, "");
+        case IR_SUB: return LLVMBuildFSub(e->builder, left, right, "");
+        case IR_MUL: return LLVMBuildFMul(e->builder, left, right, "");
+        case IR_DIV: return LLVMBuildFDiv(e->builder, left, right, "");
+        default: return LLVMBuildFCmp(e->builder, real_predicates[instr->binary - IR_EQ], left, right, "");
+    }
+}
+
+// --- Cross-Module References ---
+
+static LLVMTypeRef function_type(Emitter* e, int parameter_count) {
+    LLVMTypeRef* params = malloc((parameter_count + 1) * sizeof(LLVMTypeRef));
+    for (int i = 0; i < parameter_count; i++) {
+        params[i] = e->value_type;
+    }
+    LLVMTypeRef type = LLVMFunctionType(e->value_type, params, parameter_count, 0);
+    free(params);
+    return type;
+}
+
+static IRFunction* find_function(Emitter* e, const char* name) {
+    int index = ir_name_index_get(&e->program->function_indices, name);
+    return index >= 0 ? e->program->functions[index] : NULL;
+}
+
+// `omni.fn.<name>` in the module being emitted into, declaring it if needed.
+static LLVMValueRef function_symbol(Emitter* e, IRFunction* fn) {
+    char symbol[256];
+    snprintf(symbol, sizeof(symbol), "omni.fn.%s", fn->name);
+    LLVMValueRef function = LLVMGetNamedFunction(e->module, symbol);
+    return function ? function : LLVMAddFunction(e->module, symbol, function_type(e, fn->parameter_count));
+}
+
+// `omni.global.<name>`, defined in the main module and declared elsewhere.
+static LLVMValueRef global_symbol(Emitter* e, const char* name) {
+    char symbol[256];
+    snprintf(symbol, sizeof(symbol), "omni.global.%s", name);
+    LLVMValueRef global = LLVMGetNamedGlobal(e->module, symbol);
+    if (global == NULL) {
+        global = LLVMAddGlobal(e->module, e->value_type, symbol);
+        if (e->module == e->main_module) LLVMSetInitializer(global, const_value(e, OMNI_NIL, 0));
+    }
+    return global;
+}
+
+// --- Instructions ---
+
+static LLVMValueRef emit_call(Emitter* e, IRInstr* instr) {
+    LLVMValueRef* args = malloc((instr->arg_count + 1) * sizeof(LLVMValueRef));
+    for (int i = 0; i < instr->arg_count; i++) {
+        args[i] = e->values[instr->args[i]];
+    }
+    LLVMValueRef callee = function_symbol(e, find_function(e, instr->name));
+    LLVMValueRef result = LLVMBuildCall2(e->builder, LLVMGlobalGetValueType(callee), callee, args,
+                                         instr->arg_count, "");
+    free(args);
+    return result;
+}
+
+static LLVMValueRef emit_print(Emitter* e, IRInstr* instr) {
+    LLVMTypeRef array_type = LLVMArrayType(e->value_type, instr->arg_count ? instr->arg_count : 1);
+
+    // In the entry block so loops don't grow the stack
+    LLVMBuilderRef entry = LLVMCreateBuilderInContext(e->context);
+    LLVMBasicBlockRef entry_block = LLVMGetEntryBasicBlock(e->function);
+    LLVMValueRef first = LLVMGetFirstInstruction(entry_block);
+    if (first != NULL) {
+        LLVMPositionBuilderBefore(entry, first);
+    } else {
+        LLVMPositionBuilderAtEnd(entry, entry_block);
+    }
+    LLVMValueRef array = LLVMBuildAlloca(entry, array_type, "values");
+    LLVMDisposeBuilder(entry);
+
+    for (int i = 0; i < instr->arg_count; i++) {
+        LLVMValueRef indices[] = { LLVMConstInt(i32_type(e), 0, 0), LLVMConstInt(i32_type(e), i, 0) };
+        LLVMValueRef element = LLVMBuildGEP2(e->builder, array_type, array, indices, 2, "");
+        LLVMBuildStore(e->builder, e->values[instr->args[i]], element);
+    }
+    LLVMValueRef indices[] = { LLVMConstInt(i32_type(e), 0, 0), LLVMConstInt(i32_type(e), 0, 0) };
+    LLVMValueRef args[] = {
+        LLVMBuildGEP2(e->builder, array_type, array, indices, 2, ""),
+        LLVMConstInt(i32_type(e), instr->arg_count, 0),
+    };
+    call_runtime(e, "omni_print_values", LLVMVoidTypeInContext(e->context), args, 2);
+    return const_value(e, OMNI_NIL, 0);
+}
+
+static void emit_return(Emitter* e, LLVMValueRef value) {
+    if (e->fn->name == NULL) { // `main` returns the exit value
+        LLVMBuildRet(e->builder, call_runtime(e, "omni_as_integer", i64_type(e), &value, 1));
+    } else {
+        LLVMBuildRet(e->builder, value);
+    }
+}
+
+static LLVMValueRef emit_instr(Emitter* e, IRInstr* instr) {
+    LLVMValueRef arg = instr->arg_count > 0 ? e->values[instr->args[0]] : NULL;
+    switch (instr->op) {
+        case IR_CONST:
+            return emit_constant(e, instr);
+        case IR_PARAM:
+            return LLVMGetParam(e->function, instr->index);
+        case IR_PHI:
+            return LLVMBuildPhi(e->builder, llvm_type(e, instr->type), ""); // Incoming values are added later
+        case IR_BOX:
+            return emit_box(e, arg, e->fn->instrs[instr->args[0]].type);
+        case IR_UNBOX:
+            return emit_unbox(e, arg, instr->type);
+        case IR_TRUTHY:
+            return emit_truthy(e, arg);
+        case IR_INT_TO_FLOAT:
+            return LLVMBuildSIToFP(e->builder, arg, double_type(e), "");
+        case IR_BINARY:
+            return emit_binary(e, instr);
+        case IR_NEG:
+            if (instr->type == IR_INT) return LLVMBuildNeg(e->builder, arg, "");
+            if (instr->type == IR_FLOAT) return LLVMBuildFNeg(e->builder, arg, "");
+            return call_runtime(e, "omni_negate", e->value_type, &arg, 1);
+        case IR_NOT:
+            return LLVMBuildNot(e->builder, arg, "");
+        case IR_GLOBAL_GET:
+            return LLVMBuildLoad2(e->builder, e->value_type, global_symbol(e, instr->name), instr->name);
+        case IR_GLOBAL_SET:
+            LLVMBuildStore(e->builder, arg, global_symbol(e, instr->name));
+            return NULL;
+        case IR_CALL:
+            return emit_call(e, instr);
+        case IR_PRINT:
+            return emit_print(e, instr);
+        case IR_JUMP:
+            LLVMBuildBr(e->builder, e->blocks[instr->targets[0]]);
+            return NULL;
+        case IR_BRANCH:
+            LLVMBuildCondBr(e->builder, arg, e->blocks[instr->targets[0]], e->blocks[instr->targets[1]]);
+            return NULL;
+        case IR_RETURN:
+            emit_return(e, arg);
+            return NULL;
+    }
+    return NULL;
+}
+
+static void emit_function(Emitter* e, IRFunction* fn, LLVMValueRef function) {
+    e->fn = fn;
+    e->function = function;
+    e->values = calloc(fn->instr_count, sizeof(LLVMValueRef));
+    e->blocks = calloc(fn->block_count, sizeof(LLVMBasicBlockRef));
+
+    int* order = malloc(fn->block_count * sizeof(int));
+    int count = ir_reverse_postorder(fn, order);
+    for (int i = 0; i < count; i++) {
+        char name[32];
+        snprintf(name, sizeof(name), i == 0 ? "entry" : "b%d", order[i]);
+        e->blocks[order[i]] = LLVMAppendBasicBlockInContext(e->context, function, name);
+    }
+
+    // Dominators first, so every operand but a phi's is emitted before its use
+    for (int i = 0; i < count; i++) {
+        IRBlock* block = &fn->blocks[order[i]];
+        LLVMPositionBuilderAtEnd(e->builder, e->blocks[order[i]]);
+        for (int j = 0; j < block->instr_count; j++) {
+            int value = block->instrs[j];
+            e->values[value] = emit_instr(e, &fn->instrs[value]);
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        IRBlock* block = &fn->blocks[order[i]];
+        for (int j = 0; j < block->instr_count && fn->instrs[block->instrs[j]].op == IR_PHI; j++) {
+            IRInstr* phi = &fn->instrs[block->instrs[j]];
+            for (int k = 0; k < phi->arg_count; k++) {
+                LLVMValueRef incoming = e->values[phi->args[k]];
+                LLVMBasicBlockRef from = e->blocks[block->preds[k]];
+                LLVMAddIncoming(e->values[block->instrs[j]], &incoming, &from, 1);
+            }
+        }
+    }
+    free(order);
+    free(e->values);
+    free(e->blocks);
+}
+
+static void add_module(CompiledProgram* program, LLVMModuleRef module) {
+    program->modules = realloc(program->modules, (program->module_count + 1) * sizeof(LLVMModuleRef));
+    program->modules[program->module_count++] = module;
+}
+
+CompiledProgram* ir_compile_to_llvm(IRProgram* program, LLVMContextRef context) {
+    Emitter e = {0};
+    e.context = context;
+    e.program = program;
+    e.builder = LLVMCreateBuilderInContext(context);
+    e.value_type = LLVMGetTypeByName2(context, "OmniValue");
+    if (e.value_type == NULL) {
+        e.value_type = LLVMStructCreateNamed(context, "OmniValue");
+        LLVMTypeRef fields[] = { i32_type(&e), i64_type(&e) };
+        LLVMStructSetBody(e.value_type, fields, 2, 0);
+    }
+    e.main_module = e.module = LLVMModuleCreateWithNameInContext("omni_module", context);
+    CompiledProgram* compiled = calloc(1, sizeof(CompiledProgram));
+    add_module(compiled, e.main_module);
+
+    for (int i = 0; i < program->global_count; i++) {
+        global_symbol(&e, program->globals[i]);
+    }
+    LLVMValueRef main_function = LLVMAddFunction(e.main_module, "main", LLVMFunctionType(i64_type(&e), NULL, 0, 0));
+    emit_function(&e, program->main, main_function);
+
+    for (int i = 0; i < program->function_count; i++) {
+        char module_name[256];
+        snprintf(module_name, sizeof(module_name), "omni.fn.%s", program->functions[i]->name);
+        e.module = LLVMModuleCreateWithNameInContext(module_name, context);
+        add_module(compiled, e.module);
+        emit_function(&e, program->functions[i], function_symbol(&e, program->functions[i]));
+    }
+    LLVMDisposeBuilder(e.builder);
+
+    for (int i = 0; i < compiled->module_count; i++) {
+        char* error = NULL;
+        if (LLVMVerifyModule(compiled->modules[i], LLVMPrintMessageAction, &error)) {
+            LLVMDisposeMessage(error);
+            compiled_program_dispose(compiled);
+            return NULL;
+        }
+        LLVMDisposeMessage(error);
+    }
+    return compiled;
+}
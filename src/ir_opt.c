@@ -0,0 +1,481 @@
+#include "ir.h"
+#include <stdlib.h>
+#include <string.h>
+
+// --- Optimization Passes ---
+// Each pass returns whether it changed the function; ir_optimize runs them
+// until none does. All of them are local rewrites on the SSA graph, so they
+// apply equally to whatever backend executes the IR afterwards.
+
+#define MAX_ROUNDS 16
+
+static int live(IRFunction* fn, int value) {
+    return fn->instrs[value].block >= 0;
+}
+
+// Turns `value` into a constant in place, so its uses needn't change.
+static void make_const(IRFunction* fn, int value, IRType type, OmniValue constant) {
+    IRInstr* instr = &fn->instrs[value];
+    free(instr->args);
+    instr->args = NULL;
+    instr->arg_count = 0;
+    instr->op = IR_CONST;
+    instr->type = type;
+    instr->constant = constant;
+}
+
+static void replace(IRFunction* fn, int value, int replacement) {
+    ir_replace_uses(fn, value, replacement);
+    ir_remove_instr(fn, value);
+}
+
+// Drops the edge from `pred` into `block`, along with the phi operands it carried.
+static void remove_edge(IRFunction* fn, int block, int pred) {
+    IRBlock* b = &fn->blocks[block];
+    int k = 0;
+    while (k < b->pred_count && b->preds[k] != pred) k++;
+    if (k == b->pred_count) return;
+    memmove(&b->preds[k], &b->preds[k + 1], (b->pred_count - k - 1) * sizeof(int));
+    b->pred_count--;
+    for (int i = 0; i < b->instr_count; i++) {
+        IRInstr* phi = &fn->instrs[b->instrs[i]];
+        if (phi->op != IR_PHI) break;
+        memmove(&phi->args[k], &phi->args[k + 1], (phi->arg_count - k - 1) * sizeof(int));
+        phi->arg_count--;
+    }
+}
+
+// --- Trivial Phis ---
+// A phi that only merges one value (besides itself) is that value. SSA
+// construction leaves these behind for every variable read across a loop
+// or join it isn't assigned in.
+
+static int remove_trivial_phis(IRFunction* fn) {
+    int changed = 0;
+    for (int value = 0; value < fn->instr_count; value++) {
+        IRInstr* phi = &fn->instrs[value];
+        if (phi->op != IR_PHI || phi->block < 0) continue;
+        int same = -1, trivial = 1;
+        for (int i = 0; i < phi->arg_count; i++) {
+            int arg = phi->args[i];
+            if (arg == same || arg == value) continue;
+            if (same >= 0) {
+                trivial = 0;
+                break;
+            }
+            same = arg;
+        }
+        if (!trivial || same < 0) continue;
+        replace(fn, value, same);
+        changed = 1;
+    }
+    return changed;
+}
+
+// --- Constant Folding ---
+
+// Folds an operation on two constants with the runtime's kernel, unless it
+// would fail at run time or build a new string; returns 0 then.
+static int fold_binary(IRBinaryOp op, OmniValue left, OmniValue right, OmniValue* result) {
+    if ((left.type == OMNI_STRING || right.type == OMNI_STRING) && op != IR_EQ && op != IR_NE) return 0;
+    return omni_binary((OmniBinaryOp)op, left, right, result) == OMNI_OK;
+}
+
+static int fold_instr(IRFunction* fn, int value) {
+    IRInstr* instr = &fn->instrs[value];
+    int a = instr->arg_count > 0 ? instr->args[0] : -1;
+    int b = instr->arg_count > 1 ? instr->args[1] : -1;
+    IRInstr* arg = a >= 0 ? &fn->instrs[a] : NULL;
+
+    switch (instr->op) {
+        case IR_BOX:
+            if (arg->op == IR_CONST) {
+                make_const(fn, value, IR_VALUE, arg->constant);
+                return 1;
+            }
+            return 0;
+
+        case IR_UNBOX:
+            if (arg->op == IR_BOX && fn->instrs[arg->args[0]].type == instr->type) {
+                replace(fn, value, arg->args[0]);
+                return 1;
+            }
+            if (arg->op == IR_CONST) {
+                make_const(fn, value, instr->type, arg->constant);
+                return 1;
+            }
+            return 0;
+
+        case IR_TRUTHY:
+            if (arg->op == IR_CONST) {
+                make_const(fn, value, IR_BOOL, omni_new_boolean(omni_is_truthy(arg->constant)));
+                return 1;
+            }
+            if (arg->op == IR_BOX) {
+                int boxed = arg->args[0];
+                if (fn->instrs[boxed].type == IR_BOOL) {
+                    replace(fn, value, boxed);
+                } else {
+                    make_const(fn, value, IR_BOOL, omni_new_boolean(1)); // Numbers are always truthy
+                }
+                return 1;
+            }
+            return 0;
+
+        case IR_NOT:
+            if (arg->op == IR_CONST) {
+                make_const(fn, value, IR_BOOL, omni_new_boolean(!arg->constant.value.boolean));
+                return 1;
+            }
+            if (arg->op == IR_NOT) {
+                replace(fn, value, arg->args[0]);
+                return 1;
+            }
+            return 0;
+
+        case IR_INT_TO_FLOAT:
+            if (arg->op == IR_CONST) {
+                make_const(fn, value, IR_FLOAT, omni_new_float((double)arg->constant.value.integer));
+                return 1;
+            }
+            return 0;
+
+        case IR_NEG: {
+            OmniValue negated;
+            if (arg->op != IR_CONST || omni_unary_minus(arg->constant, &negated) != OMNI_OK) return 0;
+            make_const(fn, value, instr->type, negated);
+            return 1;
+        }
+
+        case IR_BINARY: {
+            if (arg->op != IR_CONST || fn->instrs[b].op != IR_CONST) return 0;
+            OmniValue left = arg->constant, right = fn->instrs[b].constant;
+            OmniValue result;
+            if (!fold_binary(instr->binary, left, right, &result)) return 0;
+            IRType type = instr->type;
+            make_const(fn, value, type, result);
+            return 1;
+        }
+
+        case IR_BRANCH: {
+            if (arg->op != IR_CONST) return 0;
+            int taken = instr->targets[arg->constant.value.boolean ? 0 : 1];
+            int dropped = instr->targets[arg->constant.value.boolean ? 1 : 0];
+            remove_edge(fn, dropped, instr->block);
+            free(instr->args);
+            instr->args = NULL;
+            instr->arg_count = 0;
+            instr->op = IR_JUMP;
+            instr->targets[0] = taken;
+            instr->targets[1] = -1;
+            return 1;
+        }
+
+        default:
+            return 0;
+    }
+}
+
+static int fold_constants(IRFunction* fn) {
+    int changed = 0;
+    for (int value = 0; value < fn->instr_count; value++) {
+        if (live(fn, value)) changed |= fold_instr(fn, value);
+    }
+    return changed;
+}
+
+// --- Unreachable Blocks ---
+
+static int remove_unreachable_blocks(IRFunction* fn) {
+    char* reachable = calloc(fn->block_count, 1);
+    int* order = malloc(fn->block_count * sizeof(int));
+    int count = ir_reverse_postorder(fn, order);
+    for (int i = 0; i < count; i++) reachable[order[i]] = 1;
+
+    int changed = 0;
+    for (int block = 0; block < fn->block_count; block++) {
+        if (reachable[block] || fn->blocks[block].instr_count == 0) continue;
+        int terminator = ir_terminator(fn, block);
+        for (int i = 0; terminator >= 0 && i < 2; i++) {
+            int target = fn->instrs[terminator].targets[i];
+            if (target >= 0) remove_edge(fn, target, block);
+        }
+        while (fn->blocks[block].instr_count > 0) {
+            ir_remove_instr(fn, fn->blocks[block].instrs[0]);
+        }
+        fn->blocks[block].pred_count = 0;
+        changed = 1;
+    }
+    free(reachable);
+    free(order);
+    return changed;
+}
+
+// --- Phi Unboxing ---
+// A variable assigned unboxed values on every path is merged boxed, since
+// variables are stored boxed; the phi then gets unboxed again right after.
+// Merging the unboxed values instead, and boxing the result once for
+// whoever still wants a box, keeps loop counters in registers: the
+// UNBOX(BOX) pairs around the phi fold away.
+
+// The unboxed form of phi operand `arg`, as `type`; -1 if it has none.
+static int unboxed_operand(IRFunction* fn, int arg, IRType type) {
+    IRInstr* instr = &fn->instrs[arg];
+    if (instr->op == IR_BOX && fn->instrs[instr->args[0]].type == type) return instr->args[0];
+    if (instr->op == IR_CONST && instr->type == IR_VALUE) {
+        OmniType expected = type == IR_INT ? OMNI_INTEGER : type == IR_FLOAT ? OMNI_FLOAT : OMNI_BOOLEAN;
+        if (instr->constant.type == expected) return arg;
+    }
+    return -1;
+}
+
+static int unbox_phi(IRFunction* fn, int phi) {
+    IRInstr* instr = &fn->instrs[phi];
+    IRType type = IR_VALUE;
+    for (int i = 0; i < instr->arg_count; i++) {
+        int arg = instr->args[i];
+        if (arg == phi) continue;
+        if (fn->instrs[arg].op == IR_BOX) {
+            type = fn->instrs[fn->instrs[arg].args[0]].type;
+            break;
+        }
+    }
+    if (type == IR_VALUE) return 0;
+    for (int i = 0; i < instr->arg_count; i++) {
+        if (instr->args[i] != phi && unboxed_operand(fn, instr->args[i], type) < 0) return 0;
+    }
+
+    int block = instr->block;
+    int arg_count = instr->arg_count;
+    for (int i = 0; i < arg_count; i++) {
+        int arg = fn->instrs[phi].args[i];
+        if (arg == phi) continue;
+        int unboxed = unboxed_operand(fn, arg, type);
+        if (unboxed == arg) { // A boxed constant: rematerialize it unboxed at the end of the predecessor
+            int pred = fn->blocks[block].preds[i];
+            OmniValue constant = fn->instrs[arg].constant;
+            unboxed = ir_insert(fn, pred, fn->blocks[pred].instr_count - 1, IR_CONST, type, NULL, 0);
+            fn->instrs[unboxed].constant = constant;
+        }
+        fn->instrs[phi].args[i] = unboxed;
+    }
+    fn->instrs[phi].type = type;
+
+    IRBlock* b = &fn->blocks[block];
+    int position = 0;
+    while (position < b->instr_count && fn->instrs[b->instrs[position]].op == IR_PHI) position++;
+    int box = ir_insert(fn, block, position, IR_BOX, IR_VALUE, &phi, 1);
+    ir_replace_uses(fn, phi, box);
+    fn->instrs[box].args[0] = phi;
+    for (int i = 0; i < fn->instrs[phi].arg_count; i++) {
+        if (fn->instrs[phi].args[i] == box) fn->instrs[phi].args[i] = phi;
+    }
+    return 1;
+}
+
+static int unbox_phis(IRFunction* fn) {
+    int changed = 0;
+    for (int value = 0; value < fn->instr_count; value++) {
+        if (fn->instrs[value].op == IR_PHI && live(fn, value) && fn->instrs[value].type == IR_VALUE) {
+            changed |= unbox_phi(fn, value);
+        }
+    }
+    return changed;
+}
+
+// --- Common Subexpressions ---
+// Within a block, a pure instruction that repeats an earlier one is
+// replaced by it.
+
+static int is_pure(IRInstr* instr) {
+    switch (instr->op) {
+        case IR_CONST: case IR_BOX: case IR_UNBOX: case IR_TRUTHY: case IR_INT_TO_FLOAT: case IR_NOT:
+            return 1;
+        case IR_BINARY:
+            // Boxed arithmetic may fail at runtime and so stays put; equality never does
+            return instr->type != IR_VALUE || instr->binary == IR_EQ || instr->binary == IR_NE;
+        case IR_NEG:
+            return instr->type != IR_VALUE;
+        default:
+            return 0;
+    }
+}
+
+static int same_constant(OmniValue a, OmniValue b) {
+    if (a.type != b.type) return 0;
+    switch (a.type) {
+        case OMNI_INTEGER: return a.value.integer == b.value.integer;
+        case OMNI_FLOAT: return memcmp(&a.value.floating, &b.value.floating, sizeof(double)) == 0;
+        case OMNI_BOOLEAN: return a.value.boolean == b.value.boolean;
+        case OMNI_STRING: return a.value.string == b.value.string;
+        case OMNI_NIL: return 1;
+        default: return 0;
+    }
+}
+
+static int same_computation(IRInstr* a, IRInstr* b) {
+    if (a->op != b->op || a->type != b->type || a->arg_count != b->arg_count) return 0;
+    if (a->op == IR_BINARY && a->binary != b->binary) return 0;
+    if (a->op == IR_CONST && !same_constant(a->constant, b->constant)) return 0;
+    for (int i = 0; i < a->arg_count; i++) {
+        if (a->args[i] != b->args[i]) return 0;
+    }
+    return 1;
+}
+
+static unsigned int computation_hash(IRInstr* instr) {
+    unsigned int hash = ((unsigned int)instr->op * 31u + (unsigned int)instr->type) * 31u;
+    if (instr->op == IR_BINARY) hash += (unsigned int)instr->binary;
+    if (instr->op == IR_CONST) {
+        OmniValue constant = instr->constant; // Hashed as same_constant compares
+        unsigned long long bits = 0;
+        switch (constant.type) {
+            case OMNI_INTEGER: bits = (unsigned long long)constant.value.integer; break;
+            case OMNI_FLOAT: memcpy(&bits, &constant.value.floating, sizeof(double)); break;
+            case OMNI_BOOLEAN: bits = (unsigned long long)constant.value.boolean; break;
+            case OMNI_STRING:
+                for (const char* c = constant.value.string; *c; c++) bits = bits * 31u + (unsigned char)*c;
+                break;
+            default: break;
+        }
+        hash = hash * 31u + (unsigned int)constant.type + (unsigned int)(bits ^ (bits >> 32));
+    }
+    for (int i = 0; i < instr->arg_count; i++) {
+        hash = hash * 31u + (unsigned int)instr->args[i];
+    }
+    // Nearby constants and arguments hash to nearby slots otherwise, which
+    // linear probing turns into long runs
+    hash ^= hash >> 16;
+    hash *= 0x45d9f3bu;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+// Each block's pure instructions go into a hash table of the computations
+// seen so far. Replaced uses are rewritten in one pass at the end rather
+// than one pass per replacement.
+static int eliminate_common_subexpressions(IRFunction* fn) {
+    int changed = 0;
+    int* replacement = malloc(fn->instr_count * sizeof(int)); // -1 unless replaced
+    for (int value = 0; value < fn->instr_count; value++) replacement[value] = -1;
+    int* seen = NULL;
+    int seen_capacity = 0;
+
+    for (int block = 0; block < fn->block_count; block++) {
+        IRBlock* b = &fn->blocks[block];
+        int capacity = 16;
+        while (capacity < b->instr_count * 2) capacity *= 2;
+        if (capacity > seen_capacity) {
+            seen_capacity = capacity;
+            seen = realloc(seen, seen_capacity * sizeof(int));
+        }
+        for (int i = 0; i < capacity; i++) seen[i] = -1;
+
+        int kept = 0;
+        for (int i = 0; i < b->instr_count; i++) {
+            int value = b->instrs[i];
+            IRInstr* instr = &fn->instrs[value];
+            for (int j = 0; j < instr->arg_count; j++) {
+                if (replacement[instr->args[j]] >= 0) instr->args[j] = replacement[instr->args[j]];
+            }
+            if (is_pure(instr)) {
+                unsigned int slot = computation_hash(instr) & (unsigned int)(capacity - 1);
+                while (seen[slot] >= 0 && !same_computation(&fn->instrs[seen[slot]], instr)) {
+                    slot = (slot + 1) & (unsigned int)(capacity - 1);
+                }
+                if (seen[slot] >= 0) {
+                    replacement[value] = seen[slot];
+                    instr->block = -1;
+                    changed = 1;
+                    continue;
+                }
+                seen[slot] = value;
+            }
+            b->instrs[kept++] = value;
+        }
+        b->instr_count = kept;
+    }
+
+    if (changed) { // Uses in other blocks, phis in particular
+        for (int value = 0; value < fn->instr_count; value++) {
+            IRInstr* instr = &fn->instrs[value];
+            if (!live(fn, value)) continue;
+            for (int j = 0; j < instr->arg_count; j++) {
+                if (replacement[instr->args[j]] >= 0) instr->args[j] = replacement[instr->args[j]];
+            }
+        }
+    }
+    free(seen);
+    free(replacement);
+    return changed;
+}
+
+// --- Dead Code ---
+
+static int has_effects(IRInstr* instr) {
+    switch (instr->op) {
+        case IR_GLOBAL_SET: case IR_CALL: case IR_PRINT: case IR_JUMP: case IR_BRANCH: case IR_RETURN:
+            return 1;
+        default:
+            return !is_pure(instr) && instr->op != IR_PHI && instr->op != IR_PARAM && instr->op != IR_GLOBAL_GET;
+    }
+}
+
+static int eliminate_dead_code(IRFunction* fn) {
+    char* used = calloc(fn->instr_count, 1);
+    int* worklist = malloc(fn->instr_count * sizeof(int));
+    int count = 0;
+    for (int value = 0; value < fn->instr_count; value++) {
+        if (live(fn, value) && has_effects(&fn->instrs[value])) {
+            used[value] = 1;
+            worklist[count++] = value;
+        }
+    }
+    while (count > 0) {
+        IRInstr* instr = &fn->instrs[worklist[--count]];
+        for (int i = 0; i < instr->arg_count; i++) {
+            if (!used[instr->args[i]]) {
+                used[instr->args[i]] = 1;
+                worklist[count++] = instr->args[i];
+            }
+        }
+    }
+
+    int changed = 0;
+    for (int block = 0; block < fn->block_count; block++) { // Compacted in place, not removed one by one
+        IRBlock* b = &fn->blocks[block];
+        int kept = 0;
+        for (int i = 0; i < b->instr_count; i++) {
+            int value = b->instrs[i];
+            if (used[value]) {
+                b->instrs[kept++] = value;
+            } else {
+                fn->instrs[value].block = -1;
+                changed = 1;
+            }
+        }
+        b->instr_count = kept;
+    }
+    free(used);
+    free(worklist);
+    return changed;
+}
+
+static void optimize_function(IRFunction* fn) {
+    for (int round = 0; round < MAX_ROUNDS; round++) {
+        int changed = remove_trivial_phis(fn);
+        changed |= fold_constants(fn);
+        changed |= remove_unreachable_blocks(fn);
+        changed |= unbox_phis(fn);
+        changed |= eliminate_common_subexpressions(fn);
+        changed |= eliminate_dead_code(fn);
+        if (!changed) break;
+    }
+}
+
+void ir_optimize(IRProgram* program) {
+    optimize_function(program->main);
+    for (int i = 0; i < program->function_count; i++) {
+        optimize_function(program->functions[i]);
+    }
+}
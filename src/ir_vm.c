@@ -0,0 +1,407 @@
+#include "ir.h"
+#include "omni_error.h"
+#include <stdlib.h>
+#include <string.h>
+
+// --- Register VM ---
+// Every IR value has a register of its own, holding an OmniValue. Unboxed
+// values are kept tagged with their type (omni_new_integer and friends),
+// so boxing and unboxing are plain moves and boxed operations can hand
+// registers straight to the runtime.
+
+#define VM_STACK_SIZE (1 << 18) // Registers, across all active calls
+
+typedef enum {
+    VM_CONST,        // dest = constant
+    VM_MOVE,         // dest = a
+    VM_TRUTHY,       // dest = truthy(a)
+    VM_INT_TO_FLOAT,
+    VM_INT_BINARY,   // dest = a `binary` b
+    VM_FLOAT_BINARY,
+    VM_VALUE_BINARY,
+    VM_INT_NEG,
+    VM_FLOAT_NEG,
+    VM_VALUE_NEG,
+    VM_NOT,
+    VM_GLOBAL_GET,   // dest = globals[a]
+    VM_GLOBAL_SET,   // globals[a] = b
+    VM_CALL,         // dest = functions[a](registers operands[b .. b + count])
+    VM_PRINT,        // print(registers operands[b .. b + count]); dest = nil
+    VM_JUMP,         // pc = target
+    VM_BRANCH_FALSE, // if !a: pc = target
+    VM_RETURN,       // return a
+} VMOp;
+
+typedef struct {
+    VMOp op;
+    IRBinaryOp binary;
+    int dest;
+    int a;
+    int b;
+    int count;
+    int target;         // Jumps: the IR block until the code is laid out, then the pc
+    OmniValue constant;
+} VMInstr;
+
+typedef struct {
+    VMInstr* code;
+    int code_count;
+    int code_capacity;
+    int register_count;
+    int parameter_count;
+    int* parameter_registers; // -1 for unused parameters
+} VMFunction;
+
+struct IRBytecode {
+    VMFunction main;
+    VMFunction* functions;
+    int function_count;
+    int* operands;           // Argument registers of calls and prints
+    int operand_count;
+    OmniValue* globals;
+    int global_count;
+};
+
+// --- Compilation ---
+
+static VMInstr* emit(VMFunction* function, VMOp op) {
+    if (function->code_count == function->code_capacity) {
+        function->code_capacity = function->code_capacity ? function->code_capacity * 2 : 64;
+        function->code = realloc(function->code, function->code_capacity * sizeof(VMInstr));
+    }
+    VMInstr* instr = &function->code[function->code_count++];
+    memset(instr, 0, sizeof(VMInstr));
+    instr->op = op;
+    return instr;
+}
+
+static int add_operands(IRBytecode* code, const int* registers, int count) {
+    int offset = code->operand_count;
+    code->operands = realloc(code->operands, (code->operand_count + count + 1) * sizeof(int));
+    memcpy(&code->operands[offset], registers, count * sizeof(int));
+    code->operand_count += count;
+    return offset;
+}
+
+static int global_index(IRProgram* program, const char* name) {
+    return ir_name_index_get(&program->global_indices, name);
+}
+
+static int function_index(IRProgram* program, const char* name) {
+    return ir_name_index_get(&program->function_indices, name);
+}
+
+// The phis of `block` take their operands from `pred`: a parallel copy,
+// staged through the scratch registers past the IR values unless there's
+// only one.
+static void emit_edge_moves(VMFunction* function, IRFunction* fn, int pred, int block) {
+    IRBlock* b = &fn->blocks[block];
+    int k = 0;
+    while (k < b->pred_count && b->preds[k] != pred) k++;
+    int phi_count = 0;
+    while (phi_count < b->instr_count && fn->instrs[b->instrs[phi_count]].op == IR_PHI) phi_count++;
+    if (phi_count == 0) return;
+
+    if (phi_count == 1) {
+        VMInstr* move = emit(function, VM_MOVE);
+        move->dest = b->instrs[0];
+        move->a = fn->instrs[b->instrs[0]].args[k];
+        return;
+    }
+    for (int i = 0; i < phi_count; i++) {
+        VMInstr* move = emit(function, VM_MOVE);
+        move->dest = fn->instr_count + i;
+        move->a = fn->instrs[b->instrs[i]].args[k];
+    }
+    for (int i = 0; i < phi_count; i++) {
+        VMInstr* move = emit(function, VM_MOVE);
+        move->dest = b->instrs[i];
+        move->a = fn->instr_count + i;
+    }
+}
+
+static void emit_jump(VMFunction* function, IRFunction* fn, int from, int to) {
+    emit_edge_moves(function, fn, from, to);
+    emit(function, VM_JUMP)->target = to;
+}
+
+static void compile_instr(IRBytecode* code, IRProgram* program, VMFunction* function, IRFunction* fn, int value) {
+    IRInstr* instr = &fn->instrs[value];
+    int a = instr->arg_count > 0 ? instr->args[0] : -1;
+    int b = instr->arg_count > 1 ? instr->args[1] : -1;
+    VMInstr* out;
+
+    switch (instr->op) {
+        case IR_PARAM: case IR_PHI:
+            return; // Written by the call and by the edges into the block
+        case IR_CONST:
+            out = emit(function, VM_CONST);
+            out->constant = instr->constant;
+            if (instr->type == IR_INT) out->constant.type = OMNI_INTEGER;
+            if (instr->type == IR_FLOAT) out->constant.type = OMNI_FLOAT;
+            if (instr->type == IR_BOOL) out->constant.type = OMNI_BOOLEAN;
+            break;
+        case IR_BOX: case IR_UNBOX:
+            out = emit(function, VM_MOVE);
+            break;
+        case IR_TRUTHY:
+            out = emit(function, VM_TRUTHY);
+            break;
+        case IR_INT_TO_FLOAT:
+            out = emit(function, VM_INT_TO_FLOAT);
+            break;
+        case IR_BINARY: {
+            IRType operand_type = fn->instrs[a].type;
+            out = emit(function, operand_type == IR_INT ? VM_INT_BINARY
+                                 : operand_type == IR_FLOAT ? VM_FLOAT_BINARY : VM_VALUE_BINARY);
+            out->binary = instr->binary;
+            break;
+        }
+        case IR_NEG:
+            out = emit(function, instr->type == IR_INT ? VM_INT_NEG : instr->type == IR_FLOAT ? VM_FLOAT_NEG : VM_VALUE_NEG);
+            break;
+        case IR_NOT:
+            out = emit(function, VM_NOT);
+            break;
+        case IR_GLOBAL_GET:
+            out = emit(function, VM_GLOBAL_GET);
+            out->dest = value;
+            out->a = global_index(program, instr->name);
+            return;
+        case IR_GLOBAL_SET:
+            out = emit(function, VM_GLOBAL_SET);
+            out->a = global_index(program, instr->name);
+            out->b = a;
+            return;
+        case IR_CALL: case IR_PRINT: {
+            int operands = add_operands(code, instr->args, instr->arg_count);
+            out = emit(function, instr->op == IR_CALL ? VM_CALL : VM_PRINT);
+            out->dest = value;
+            out->a = instr->op == IR_CALL ? function_index(program, instr->name) : 0;
+            out->b = operands;
+            out->count = instr->arg_count;
+            return;
+        }
+        case IR_JUMP:
+            emit_jump(function, fn, instr->block, instr->targets[0]);
+            return;
+        case IR_BRANCH:
+            out = emit(function, VM_BRANCH_FALSE);
+            out->a = a;
+            {
+                int false_edge = function->code_count - 1;
+                emit_jump(function, fn, instr->block, instr->targets[0]);
+                function->code[false_edge].target = -(function->code_count + 1); // A pc, not a block
+            }
+            emit_jump(function, fn, instr->block, instr->targets[1]);
+            return;
+        case IR_RETURN:
+            emit(function, VM_RETURN)->a = a;
+            return;
+        default:
+            return;
+    }
+    out->dest = value;
+    out->a = a;
+    out->b = b;
+}
+
+static void compile_function(IRBytecode* code, IRProgram* program, VMFunction* function, IRFunction* fn) {
+    int max_phis = 0;
+    for (int i = 0; i < fn->block_count; i++) {
+        int phis = 0;
+        while (phis < fn->blocks[i].instr_count && fn->instrs[fn->blocks[i].instrs[phis]].op == IR_PHI) phis++;
+        if (phis > max_phis) max_phis = phis;
+    }
+    function->register_count = fn->instr_count + max_phis;
+    function->parameter_count = fn->parameter_count;
+    function->parameter_registers = malloc((fn->parameter_count + 1) * sizeof(int));
+    for (int i = 0; i < fn->parameter_count; i++) function->parameter_registers[i] = -1;
+    for (int value = 0; value < fn->instr_count; value++) {
+        if (fn->instrs[value].op == IR_PARAM && fn->instrs[value].block >= 0) {
+            function->parameter_registers[fn->instrs[value].index] = value;
+        }
+    }
+
+    int* order = malloc(fn->block_count * sizeof(int));
+    int* block_pc = malloc(fn->block_count * sizeof(int));
+    int count = ir_reverse_postorder(fn, order);
+    for (int i = 0; i < count; i++) {
+        IRBlock* block = &fn->blocks[order[i]];
+        block_pc[order[i]] = function->code_count;
+        for (int j = 0; j < block->instr_count; j++) {
+            compile_instr(code, program, function, fn, block->instrs[j]);
+        }
+    }
+
+    // Blocks have their places now
+    for (int pc = 0; pc < function->code_count; pc++) {
+        VMInstr* instr = &function->code[pc];
+        if (instr->op != VM_JUMP && instr->op != VM_BRANCH_FALSE) continue;
+        instr->target = instr->target < 0 ? -instr->target - 1 : block_pc[instr->target];
+    }
+    free(order);
+    free(block_pc);
+}
+
+IRBytecode* ir_compile_bytecode(IRProgram* program) {
+    IRBytecode* code = calloc(1, sizeof(IRBytecode));
+    code->global_count = program->global_count;
+    code->globals = malloc((program->global_count + 1) * sizeof(OmniValue));
+    for (int i = 0; i < program->global_count; i++) code->globals[i] = omni_new_nil();
+
+    code->function_count = program->function_count;
+    code->functions = calloc(program->function_count + 1, sizeof(VMFunction));
+    for (int i = 0; i < program->function_count; i++) {
+        compile_function(code, program, &code->functions[i], program->functions[i]);
+    }
+    compile_function(code, program, &code->main, program->main);
+    return code;
+}
+
+void ir_bytecode_free(IRBytecode* code) {
+    if (code == NULL) return;
+    for (int i = 0; i <= code->function_count; i++) {
+        VMFunction* function = i < code->function_count ? &code->functions[i] : &code->main;
+        free(function->code);
+        free(function->parameter_registers);
+    }
+    free(code->functions);
+    free(code->operands);
+    free(code->globals);
+    free(code);
+}
+
+// --- Execution ---
+
+static OmniValue stack[VM_STACK_SIZE];
+
+static OmniValue value_binary(IRBinaryOp op, OmniValue left, OmniValue right) {
+    switch (op) {
+        case IR_ADD: return omni_add(left, right);
+        case IR_SUB: return omni_subtract(left, right);
+        case IR_MUL: return omni_multiply(left, right);
+        case IR_DIV: return omni_divide(left, right);
+        case IR_EQ: return omni_equal(left, right);
+        case IR_NE: return omni_not_equal(left, right);
+        case IR_LT: return omni_less_than(left, right);
+        case IR_GT: return omni_greater_than(left, right);
+        case IR_LE: return omni_less_than_equal(left, right);
+        default: return omni_greater_than_equal(left, right);
+    }
+}
+
+static OmniValue int_binary(IRBinaryOp op, long long left, long long right) {
+    unsigned long long l = (unsigned long long)left, r = (unsigned long long)right; // Wrapping
+    switch (op) {
+        case IR_ADD: return omni_new_integer((long long)(l + r));
+        case IR_SUB: return omni_new_integer((long long)(l - r));
+        case IR_MUL: return omni_new_integer((long long)(l * r));
+        case IR_EQ: return omni_new_boolean(left == right);
+        case IR_NE: return omni_new_boolean(left != right);
+        case IR_LT: return omni_new_boolean(left < right);
+        case IR_GT: return omni_new_boolean(left > right);
+        case IR_LE: return omni_new_boolean(left <= right);
+        case IR_GE: return omni_new_boolean(left >= right);
+        default: return omni_divide(omni_new_integer(left), omni_new_integer(right));
+    }
+}
+
+static OmniValue float_binary(IRBinaryOp op, double left, double right) {
+    switch (op) {
+        case IR_ADD: return omni_new_float(left + right);
+        case IR_SUB: return omni_new_float(left - right);
+        case IR_MUL: return omni_new_float(left * right);
+        case IR_DIV: return omni_divide(omni_new_float(left), omni_new_float(right));
+        case IR_EQ: return omni_new_boolean(left == right);
+        case IR_NE: return omni_new_boolean(left != right);
+        case IR_LT: return omni_new_boolean(left < right);
+        case IR_GT: return omni_new_boolean(left > right);
+        case IR_LE: return omni_new_boolean(left <= right);
+        default: return omni_new_boolean(left >= right);
+    }
+}
+
+static OmniValue run(IRBytecode* code, VMFunction* function, OmniValue* r) {
+    if (r + function->register_count > stack + VM_STACK_SIZE) {
+        omni_raise("Stack overflow.");
+    }
+    VMInstr* instrs = function->code;
+    int pc = 0;
+    for (;;) {
+        VMInstr* instr = &instrs[pc++];
+        switch (instr->op) {
+            case VM_CONST:
+                r[instr->dest] = instr->constant;
+                break;
+            case VM_MOVE:
+                r[instr->dest] = r[instr->a];
+                break;
+            case VM_TRUTHY:
+                r[instr->dest] = omni_new_boolean(omni_is_truthy(r[instr->a]));
+                break;
+            case VM_INT_TO_FLOAT:
+                r[instr->dest] = omni_new_float((double)r[instr->a].value.integer);
+                break;
+            case VM_INT_BINARY:
+                r[instr->dest] = int_binary(instr->binary, r[instr->a].value.integer, r[instr->b].value.integer);
+                break;
+            case VM_FLOAT_BINARY:
+                r[instr->dest] = float_binary(instr->binary, r[instr->a].value.floating, r[instr->b].value.floating);
+                break;
+            case VM_VALUE_BINARY:
+                r[instr->dest] = value_binary(instr->binary, r[instr->a], r[instr->b]);
+                break;
+            case VM_INT_NEG:
+                r[instr->dest] = omni_new_integer((long long)(0ULL - (unsigned long long)r[instr->a].value.integer));
+                break;
+            case VM_FLOAT_NEG:
+                r[instr->dest] = omni_new_float(-r[instr->a].value.floating);
+                break;
+            case VM_VALUE_NEG:
+                r[instr->dest] = omni_negate(r[instr->a]);
+                break;
+            case VM_NOT:
+                r[instr->dest] = omni_new_boolean(!r[instr->a].value.boolean);
+                break;
+            case VM_GLOBAL_GET:
+                r[instr->dest] = code->globals[instr->a];
+                break;
+            case VM_GLOBAL_SET:
+                code->globals[instr->a] = r[instr->b];
+                break;
+            case VM_CALL: {
+                VMFunction* callee = &code->functions[instr->a];
+                OmniValue* frame = r + function->register_count;
+                const int* operands = &code->operands[instr->b];
+                for (int i = 0; i < instr->count; i++) {
+                    int parameter = callee->parameter_registers[i];
+                    if (parameter >= 0 && frame + parameter < stack + VM_STACK_SIZE) frame[parameter] = r[operands[i]];
+                }
+                r[instr->dest] = run(code, callee, frame);
+                break;
+            }
+            case VM_PRINT: {
+                OmniValue values[16];
+                OmniValue* buffer = instr->count <= 16 ? values : malloc(instr->count * sizeof(OmniValue));
+                for (int i = 0; i < instr->count; i++) buffer[i] = r[code->operands[instr->b + i]];
+                omni_print_values(buffer, instr->count);
+                if (buffer != values) free(buffer);
+                r[instr->dest] = omni_new_nil();
+                break;
+            }
+            case VM_JUMP:
+                pc = instr->target;
+                break;
+            case VM_BRANCH_FALSE:
+                if (!r[instr->a].value.boolean) pc = instr->target;
+                break;
+            case VM_RETURN:
+                return r[instr->a];
+        }
+    }
+}
+
+OmniValue ir_execute(IRBytecode* code) {
+    return run(code, &code->main, stack);
+}
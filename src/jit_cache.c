@@ -0,0 +1,228 @@
+#define _POSIX_C_SOURCE 200809L // strdup, mkdir, utime
+#include "jit_cache.h"
+#include "runtime_inline.h"
+#include <dirent.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+
+#include <llvm-c/Core.h>
+#include <llvm-c/TargetMachine.h>
+#include <llvm/Config/llvm-config.h>
+
+struct JitCache {
+    char* directory;
+    char* salt; // Everything besides the IR that goes into a key
+    long long limit;
+    int hits;
+    int misses;
+};
+
+typedef struct {
+    char* path;
+    long long size;
+    time_t modified;
+} CacheEntry;
+
+// --- Keys ---
+// Two 64-bit FNV-1a hashes with different offset bases make up the 128-bit key.
+
+#define FNV_PRIME 0x100000001b3ULL
+
+static unsigned long long fnv1a(unsigned long long hash, const char* data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+void jit_cache_key(JitCache* cache, LLVMModuleRef module, char key[JIT_CACHE_KEY_SIZE]) {
+    char* ir = LLVMPrintModuleToString(module);
+    unsigned long long hashes[2] = { 0xcbf29ce484222325ULL, 0x84222325cbf29ce4ULL };
+    for (int i = 0; i < 2; i++) {
+        hashes[i] = fnv1a(hashes[i], cache->salt, strlen(cache->salt));
+        hashes[i] = fnv1a(hashes[i], ir, strlen(ir));
+    }
+    LLVMDisposeMessage(ir);
+    snprintf(key, JIT_CACHE_KEY_SIZE, "%016llx%016llx", hashes[0], hashes[1]);
+}
+
+// --- Directory ---
+
+static char* join_path(const char* directory, const char* name) {
+    size_t length = strlen(directory) + strlen(name) + 2;
+    char* path = malloc(length);
+    snprintf(path, length, "%s/%s", directory, name);
+    return path;
+}
+
+// `mkdir -p`
+static int make_directories(const char* directory) {
+    char* path = strdup(directory);
+    for (char* slash = strchr(path + 1, '/'); ; slash = strchr(slash + 1, '/')) {
+        if (slash) *slash = '\0';
+        if (mkdir(path, 0755) != 0 && errno != EEXIST) {
+            free(path);
+            return 1;
+        }
+        if (slash == NULL) break;
+        *slash = '/';
+    }
+    free(path);
+    return 0;
+}
+
+static char* default_directory() {
+    const char* directory = getenv("OMNI_JIT_CACHE_DIR");
+    if (directory != NULL && directory[0] != '\0') return strdup(directory);
+
+    const char* base = getenv("XDG_CACHE_HOME");
+    if (base != NULL && base[0] != '\0') return join_path(base, "omnikarai");
+
+    const char* home = getenv("HOME");
+    if (home == NULL || home[0] == '\0') return NULL;
+    return join_path(home, ".cache/omnikarai");
+}
+
+static char* entry_path(JitCache* cache, const char* key) {
+    char name[JIT_CACHE_KEY_SIZE + 2];
+    snprintf(name, sizeof(name), "%s.o", key);
+    return join_path(cache->directory, name);
+}
+
+JitCache* jit_cache_open(const char* directory, int opt_level) {
+    char* path = directory ? strdup(directory) : default_directory();
+    if (path == NULL || make_directories(path) != 0) {
+        fprintf(stderr, "JIT Cache: No usable cache directory, caching disabled.\n");
+        free(path);
+        return NULL;
+    }
+
+    JitCache* cache = calloc(1, sizeof(JitCache));
+    cache->directory = path;
+    cache->limit = JIT_CACHE_DEFAULT_LIMIT;
+    const char* megabytes = getenv("OMNI_JIT_CACHE_MB");
+    if (megabytes != NULL && atoll(megabytes) > 0) {
+        cache->limit = atoll(megabytes) * 1024 * 1024;
+    }
+
+    char* triple = LLVMGetDefaultTargetTriple();
+    char* cpu = LLVMGetHostCPUName();
+    char* features = LLVMGetHostCPUFeatures();
+    size_t bitcode_size;
+    const char* bitcode = runtime_bitcode(&bitcode_size); // Inlined into every module
+    size_t length = strlen(triple) + strlen(cpu) + strlen(features) + 96;
+    cache->salt = malloc(length);
+    snprintf(cache->salt, length, "omnikarai %s llvm %s O%d %s %s %s runtime %016llx\n",
+             OMNI_VERSION, LLVM_VERSION_STRING, opt_level, triple, cpu, features,
+             fnv1a(0xcbf29ce484222325ULL, bitcode, bitcode_size));
+    LLVMDisposeMessage(triple);
+    LLVMDisposeMessage(cpu);
+    LLVMDisposeMessage(features);
+    return cache;
+}
+
+void jit_cache_close(JitCache* cache) {
+    if (cache == NULL) return;
+    free(cache->directory);
+    free(cache->salt);
+    free(cache);
+}
+
+// --- Lookup ---
+
+LLVMMemoryBufferRef jit_cache_load(JitCache* cache, const char* key) {
+    char* path = entry_path(cache, key);
+    LLVMMemoryBufferRef buffer = NULL;
+    char* error = NULL;
+
+    if (access(path, R_OK) == 0 && LLVMCreateMemoryBufferWithContentsOfFile(path, &buffer, &error) == 0) {
+        utime(path, NULL); // Most recently used
+        cache->hits++;
+    } else {
+        if (error) LLVMDisposeMessage(error);
+        buffer = NULL;
+        cache->misses++;
+    }
+    free(path);
+    return buffer;
+}
+
+// --- Store & LRU Eviction ---
+
+static int compare_entries(const void* a, const void* b) {
+    time_t left = ((const CacheEntry*)a)->modified;
+    time_t right = ((const CacheEntry*)b)->modified;
+    return (left > right) - (left < right);
+}
+
+static void evict(JitCache* cache) {
+    DIR* directory = opendir(cache->directory);
+    if (directory == NULL) return;
+
+    CacheEntry* entries = NULL;
+    int count = 0, capacity = 0;
+    long long total = 0;
+    struct dirent* dirent;
+    while ((dirent = readdir(directory)) != NULL) {
+        size_t length = strlen(dirent->d_name);
+        if (length < 3 || strcmp(dirent->d_name + length - 2, ".o") != 0) continue;
+
+        char* path = join_path(cache->directory, dirent->d_name);
+        struct stat info;
+        if (stat(path, &info) != 0) {
+            free(path);
+            continue;
+        }
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            entries = realloc(entries, capacity * sizeof(CacheEntry));
+        }
+        entries[count++] = (CacheEntry){ path, (long long)info.st_size, info.st_mtime };
+        total += info.st_size;
+    }
+    closedir(directory);
+
+    if (total > cache->limit) {
+        qsort(entries, count, sizeof(CacheEntry), compare_entries); // Oldest first
+        for (int i = 0; i < count && total > cache->limit; i++) {
+            if (unlink(entries[i].path) == 0) total -= entries[i].size;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        free(entries[i].path);
+    }
+    free(entries);
+}
+
+void jit_cache_store(JitCache* cache, const char* key, const char* data, size_t size) {
+    char* path = entry_path(cache, key);
+    // Written under a temporary name and renamed, so concurrent runs never see half a file.
+    size_t temporary_length = strlen(path) + 32;
+    char* temporary = malloc(temporary_length);
+    snprintf(temporary, temporary_length, "%s.%ld.tmp", path, (long)getpid());
+
+    FILE* file = fopen(temporary, "wb");
+    int failed = file == NULL;
+    if (file != NULL) {
+        failed = fwrite(data, 1, size, file) != size;
+        failed |= fclose(file) != 0;
+    }
+    if (failed || rename(temporary, path) != 0) {
+        fprintf(stderr, "JIT Cache: Failed to write '%s'.\n", path);
+        remove(temporary);
+    }
+
+    free(temporary);
+    free(path);
+    evict(cache);
+}
+
+void jit_cache_print_stats(JitCache* cache) {
+    fprintf(stderr, "JIT Cache: %d hits, %d misses (%s)\n", cache->hits, cache->misses, cache->directory);
+}
@@ -1,6 +1,207 @@
+#define _POSIX_C_SOURCE 200809L // strdup
 #include "jit_engine.h"
+#include "optimizer.h"
+#include "jit_cache.h"
+#include "runtime_inline.h"
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <llvm-c/Core.h>
+#include <llvm-c/Error.h>
+#include <llvm-c/ExecutionEngine.h>
+#include <llvm-c/LLJIT.h>
+#include <llvm-c/Object.h>
+#include <llvm-c/Orc.h>
+#include <llvm-c/OrcEE.h>
+#include <llvm-c/Target.h>
+#include <llvm-c/TargetMachine.h>
+
+#define IMPL_SUFFIX ".impl"
+
+typedef struct PerfSymbol {
+    char* name;
+    unsigned long long size;
+    struct PerfSymbol* next;
+} PerfSymbol;
+
+struct OmniJIT {
+    LLVMOrcLLJITRef jit;
+    LLVMOrcThreadSafeContextRef context;
+    LLVMOrcLazyCallThroughManagerRef call_through;
+    LLVMOrcIndirectStubsManagerRef stubs;
+    LLVMOrcJITDylibRef dylib;
+    int opt_level;
+    int time_passes;
+    JitCache* cache; // NULL unless jit_use_cache was called
+    char pending_key[JIT_CACHE_KEY_SIZE]; // Key of the module being compiled
+    PerfSymbol* perf_symbols; // Emitted but not yet in the perf map
+    pthread_mutex_t perf_lock;
+};
+
+static int perf_map_enabled = 0;
+static int jitdump_enabled = 0;
+
+static void report_error(const char* what, LLVMErrorRef error) {
+    char* message = LLVMGetErrorMessage(error);
+    fprintf(stderr, "JIT Error: %s: %s\n", what, message);
+    LLVMDisposeErrorMessage(message);
+}
+
+// Jumped to by a lazy stub whose function failed to compile.
+static void lazy_compile_failed() {
+    fprintf(stderr, "JIT Error: Lazy compilation of a function failed.\n");
+    exit(1);
+}
+
+// --- Lazy Optimization ---
+// The pass pipeline runs in the IR transform layer, i.e. only when a
+// module is materialized because one of its symbols was looked up. The
+// runtime's bitcode is linked in first so its helpers can be inlined.
+
+static LLVMErrorRef optimize_operation(void* ctx, LLVMModuleRef module) {
+    OmniJIT* jit = ctx;
+    if (jit->cache) {
+        // Compiling a cache miss: jit_add_module stored its key as the module ID
+        size_t length;
+        const char* key = LLVMGetModuleIdentifier(module, &length);
+        snprintf(jit->pending_key, sizeof(jit->pending_key), "%.*s", (int)length, key);
+    }
+    if (jit->opt_level > 0 && link_runtime_bitcode(module) != 0) {
+        return LLVMCreateStringError("Linking the runtime bitcode failed");
+    }
+    if (optimize_module(module, jit->opt_level, jit->time_passes) != 0) {
+        return LLVMCreateStringError("Optimization failed");
+    }
+    return LLVMErrorSuccess;
+}
+
+static LLVMErrorRef optimize_transform(void* ctx, LLVMOrcThreadSafeModuleRef* module,
+                                       LLVMOrcMaterializationResponsibilityRef responsibility) {
+    (void)responsibility;
+    return LLVMOrcThreadSafeModuleWithModuleDo(*module, optimize_operation, ctx);
+}
+
+// --- Profiling ---
+// perf can't symbolize JIT code on its own. With --perf-map every emitted
+// function is appended to /tmp/perf-<pid>.map ("<address> <size> <name>"),
+// which `perf report` reads. Objects only carry names and sizes; addresses
+// are known once they are linked, so functions are collected here and
+// written after the next lookup (or at exit).
+//
+// With --jitdump, LLVM's perf listener writes a jit-<pid>.dump that
+// `perf inject --jit` turns into symbols plus the -g line info.
+
+void jit_set_profiling(int perf_map, int jitdump) {
+    perf_map_enabled = perf_map;
+    jitdump_enabled = jitdump;
+}
+
+static int is_text_section(LLVMSectionIteratorRef section) {
+    const char* name = LLVMGetSectionName(section);
+    return name != NULL && strncmp(name, ".text", 5) == 0;
+}
+
+static void collect_perf_symbols(OmniJIT* jit, LLVMMemoryBufferRef object) {
+    char* message = NULL;
+    LLVMBinaryRef binary = LLVMCreateBinary(object, NULL, &message);
+    if (binary == NULL) {
+        LLVMDisposeMessage(message);
+        return;
+    }
+
+    LLVMSectionIteratorRef section = LLVMObjectFileCopySectionIterator(binary);
+    LLVMSymbolIteratorRef symbol = LLVMObjectFileCopySymbolIterator(binary);
+    for (; !LLVMObjectFileIsSymbolIteratorAtEnd(binary, symbol); LLVMMoveToNextSymbol(symbol)) {
+        unsigned long long size = LLVMGetSymbolSize(symbol);
+        const char* name = LLVMGetSymbolName(symbol);
+        if (size == 0 || name == NULL || name[0] == '\0') continue;
+        LLVMMoveToContainingSection(section, symbol);
+        if (LLVMObjectFileIsSectionIteratorAtEnd(binary, section) || !is_text_section(section)) continue;
+
+        PerfSymbol* entry = malloc(sizeof(PerfSymbol));
+        entry->name = strdup(name);
+        entry->size = size;
+        pthread_mutex_lock(&jit->perf_lock);
+        entry->next = jit->perf_symbols;
+        jit->perf_symbols = entry;
+        pthread_mutex_unlock(&jit->perf_lock);
+    }
+    LLVMDisposeSymbolIterator(symbol);
+    LLVMDisposeSectionIterator(section);
+    LLVMDisposeBinary(binary);
+}
+
+// Appends the collected functions to the perf map. Internal functions
+// can't be looked up; they were inlined into their callers or show up as
+// part of them.
+static void flush_perf_map(OmniJIT* jit) {
+    static pthread_mutex_t file_lock = PTHREAD_MUTEX_INITIALIZER;
+
+    // Looked up without holding perf_lock: a lookup may wait for a
+    // compilation that is about to collect its own symbols.
+    pthread_mutex_lock(&jit->perf_lock);
+    PerfSymbol* symbols = jit->perf_symbols;
+    jit->perf_symbols = NULL;
+    pthread_mutex_unlock(&jit->perf_lock);
+    if (symbols == NULL) return;
+
+    pthread_mutex_lock(&file_lock);
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/perf-%ld.map", (long)getpid());
+    FILE* map = fopen(path, "a");
+    if (map == NULL) fprintf(stderr, "JIT Error: Could not open '%s'.\n", path);
+
+    while (symbols != NULL) {
+        PerfSymbol* symbol = symbols;
+        symbols = symbol->next;
+        LLVMOrcExecutorAddress address = 0;
+        LLVMErrorRef error = LLVMOrcLLJITLookup(jit->jit, &address, symbol->name);
+        if (error) {
+            LLVMConsumeError(error);
+        } else if (map != NULL) {
+            fprintf(map, "%llx %llx %s\n", (unsigned long long)address, symbol->size, symbol->name);
+        }
+        free(symbol->name);
+        free(symbol);
+    }
+    if (map != NULL) fclose(map);
+    pthread_mutex_unlock(&file_lock);
+}
+
+static LLVMOrcObjectLayerRef create_profiled_object_layer(void* ctx, LLVMOrcExecutionSessionRef session,
+                                                          const char* triple) {
+    (void)ctx;
+    (void)triple;
+    LLVMOrcObjectLayerRef layer = LLVMOrcCreateRTDyldObjectLinkingLayerWithSectionMemoryManager(session);
+    LLVMJITEventListenerRef listener = LLVMCreatePerfJITEventListener();
+    if (listener != NULL) {
+        LLVMOrcRTDyldObjectLinkingLayerRegisterJITEventListener(layer, listener);
+    } else {
+        fprintf(stderr, "JIT Error: This LLVM was built without perf support, no jitdump is written.\n");
+    }
+    return layer;
+}
+
+// --- Object Cache ---
+// Materializing a module runs the IR transform, codegen and the object
+// transform back to back on one thread, so the object seen here belongs
+// to the module whose key optimize_operation just recorded. Objects added
+// from the cache pass through here too, with no key pending.
+
+static LLVMErrorRef object_transform(void* ctx, LLVMMemoryBufferRef* object) {
+    OmniJIT* jit = ctx;
+    if (perf_map_enabled) {
+        collect_perf_symbols(jit, *object);
+    }
+    if (jit->pending_key[0] != '\0') {
+        jit_cache_store(jit->cache, jit->pending_key, LLVMGetBufferStart(*object), LLVMGetBufferSize(*object));
+        jit->pending_key[0] = '\0';
+    }
+    return LLVMErrorSuccess;
+}
 
 void jit_init() {
     LLVMInitializeNativeTarget();
@@ -11,33 +212,196 @@ void jit_shutdown() {
     // No explicit shutdown in LLVM-C API for the JIT.
 }
 
-LLVMExecutionEngineRef jit_create_engine(LLVMModuleRef module) {
-    char *error = NULL;
-    LLVMExecutionEngineRef engine;
+OmniJIT* jit_create(int opt_level, int time_passes) {
+    OmniJIT* jit = calloc(1, sizeof(OmniJIT));
+    jit->opt_level = opt_level;
+    jit->time_passes = time_passes;
+    pthread_mutex_init(&jit->perf_lock, NULL);
+
+    LLVMOrcLLJITBuilderRef builder = LLVMOrcCreateLLJITBuilder();
+    LLVMTargetMachineRef machine = create_host_target_machine(opt_level);
+    if (machine != NULL) {
+        // Takes ownership of the TargetMachine
+        LLVMOrcLLJITBuilderSetJITTargetMachineBuilder(builder,
+            LLVMOrcJITTargetMachineBuilderCreateFromTargetMachine(machine));
+    }
+    if (jitdump_enabled) {
+        LLVMOrcLLJITBuilderSetObjectLinkingLayerCreator(builder, create_profiled_object_layer, NULL);
+    }
+
+    LLVMErrorRef error = LLVMOrcCreateLLJIT(&jit->jit, builder); // Takes ownership of the builder
+    if (error) {
+        report_error("Failed to create LLJIT", error);
+        free(jit);
+        return NULL;
+    }
+
+    jit->context = LLVMOrcCreateNewThreadSafeContext();
+    jit->dylib = LLVMOrcLLJITGetMainJITDylib(jit->jit);
 
-    if (LLVMCreateJITCompilerForModule(&engine, module, 2, &error)) {
-        fprintf(stderr, "Failed to create JIT compiler: %s\n", error);
-        LLVMDisposeMessage(error);
+    // Resolve the omni_* runtime helpers against this executable (linked with -rdynamic).
+    LLVMOrcDefinitionGeneratorRef process_symbols;
+    error = LLVMOrcCreateDynamicLibrarySearchGeneratorForProcess(&process_symbols,
+                LLVMOrcLLJITGetGlobalPrefix(jit->jit), NULL, NULL);
+    if (error) {
+        report_error("Failed to expose runtime symbols", error);
+        jit_dispose(jit);
         return NULL;
     }
+    LLVMOrcJITDylibAddGenerator(jit->dylib, process_symbols);
+
+    const char* triple = LLVMOrcLLJITGetTripleString(jit->jit);
+    jit->stubs = LLVMOrcCreateLocalIndirectStubsManager(triple);
+    error = LLVMOrcCreateLocalLazyCallThroughManager(triple, LLVMOrcLLJITGetExecutionSession(jit->jit),
+                (LLVMOrcJITTargetAddress)(uintptr_t)lazy_compile_failed, &jit->call_through);
+    if (error) {
+        report_error("Failed to create lazy call-through manager", error);
+        jit_dispose(jit);
+        return NULL;
+    }
+
+    LLVMOrcIRTransformLayerSetTransform(LLVMOrcLLJITGetIRTransformLayer(jit->jit), optimize_transform, jit);
+    LLVMOrcObjectTransformLayerSetTransform(LLVMOrcLLJITGetObjTransformLayer(jit->jit), object_transform, jit);
+    return jit;
+}
+
+void jit_use_cache(OmniJIT* jit, const char* directory) {
+    jit->cache = jit_cache_open(directory, jit->opt_level);
+}
+
+void jit_dispose(OmniJIT* jit) {
+    if (jit == NULL) return;
+    // The lazy reexports go before the session that owns their trampolines,
+    // as in LLVM's own LLLazyJIT; disposing them after it corrupts the heap.
+    if (jit->call_through) LLVMOrcDisposeLazyCallThroughManager(jit->call_through);
+    if (jit->stubs) LLVMOrcDisposeIndirectStubsManager(jit->stubs);
+    if (jit->jit) {
+        flush_perf_map(jit);
+        LLVMErrorRef error = LLVMOrcDisposeLLJIT(jit->jit);
+        if (error) report_error("Failed to dispose LLJIT", error);
+    }
+    if (jit->context) LLVMOrcDisposeThreadSafeContext(jit->context);
+    if (jit->cache && jit->time_passes) jit_cache_print_stats(jit->cache);
+    jit_cache_close(jit->cache);
+    pthread_mutex_destroy(&jit->perf_lock);
+    free(jit);
+}
 
-    return engine;
+LLVMContextRef jit_get_context(OmniJIT* jit) {
+    return LLVMOrcThreadSafeContextGetContext(jit->context);
 }
 
-int jit_run_main(LLVMExecutionEngineRef engine) {
-    uint64_t res = 0;
-    LLVMValueRef main_func = NULL;
+// A cached module is added as its object file, skipping optimization and codegen.
+static int add_cached_module(OmniJIT* jit, LLVMModuleRef module, int* failed) {
+    char key[JIT_CACHE_KEY_SIZE];
+    jit_cache_key(jit->cache, module, key);
+    LLVMMemoryBufferRef object = jit_cache_load(jit->cache, key);
+    if (object == NULL) {
+        LLVMSetModuleIdentifier(module, key, strlen(key)); // Picked up by optimize_operation
+        return 0;
+    }
+
+    LLVMDisposeModule(module);
+    LLVMErrorRef error = LLVMOrcLLJITAddObjectFile(jit->jit, jit->dylib, object); // Takes ownership
+    *failed = error != NULL;
+    if (error) report_error("Failed to add cached object", error);
+    return 1;
+}
+
+int jit_add_module(OmniJIT* jit, LLVMModuleRef module) {
+    int failed;
+    if (jit->cache && add_cached_module(jit, module, &failed)) {
+        return failed;
+    }
+    return jit_add_module_in_context(jit, module, jit->context);
+}
 
-    if (LLVMFindFunction(engine, "main", &main_func) || main_func == NULL) {
+int jit_add_module_in_context(OmniJIT* jit, LLVMModuleRef module, LLVMOrcThreadSafeContextRef context) {
+    LLVMOrcThreadSafeModuleRef tsm = LLVMOrcCreateNewThreadSafeModule(module, context);
+    LLVMErrorRef error = LLVMOrcLLJITAddLLVMIRModule(jit->jit, jit->dylib, tsm);
+    if (error) {
+        report_error("Failed to add module", error);
+        LLVMOrcDisposeThreadSafeModule(tsm);
+        return 1;
+    }
+    return 0;
+}
+
+static LLVMValueRef defined_function(LLVMModuleRef module) {
+    for (LLVMValueRef fn = LLVMGetFirstFunction(module); fn != NULL; fn = LLVMGetNextFunction(fn)) {
+        if (!LLVMIsDeclaration(fn)) return fn;
+    }
+    return NULL;
+}
+
+int jit_add_program(OmniJIT* jit, CompiledProgram* program) {
+    int function_count = program->module_count - 1;
+    LLVMOrcCSymbolAliasMapPairs aliases = malloc((function_count + 1) * sizeof(LLVMOrcCSymbolAliasMapPair));
+    int alias_count = 0;
+    int failed = 0;
+
+    for (int i = 0; i < program->module_count; i++) {
+        LLVMModuleRef module = program->modules[i];
+        program->modules[i] = NULL; // Owned by the JIT from here on
+
+        if (i > 0) {
+            // The body is defined as `<symbol>.impl`; `<symbol>` becomes a
+            // lazy stub that every other module calls through.
+            LLVMValueRef function = defined_function(module);
+            size_t length;
+            const char* symbol = LLVMGetValueName2(function, &length);
+            char* impl = malloc(length + sizeof(IMPL_SUFFIX));
+            memcpy(impl, symbol, length);
+            memcpy(impl + length, IMPL_SUFFIX, sizeof(IMPL_SUFFIX));
+
+            LLVMOrcCSymbolAliasMapPair* alias = &aliases[alias_count++];
+            alias->Name = LLVMOrcLLJITMangleAndIntern(jit->jit, symbol);
+            alias->Entry.Name = LLVMOrcLLJITMangleAndIntern(jit->jit, impl);
+            alias->Entry.Flags.GenericFlags = LLVMJITSymbolGenericFlagsExported | LLVMJITSymbolGenericFlagsCallable;
+            alias->Entry.Flags.TargetFlags = 0;
+
+            LLVMSetValueName2(function, impl, strlen(impl));
+            free(impl);
+        }
+
+        if (jit_add_module(jit, module) != 0) {
+            failed = 1;
+        }
+    }
+
+    if (alias_count > 0) {
+        LLVMOrcMaterializationUnitRef reexports =
+            LLVMOrcLazyReexports(jit->call_through, jit->stubs, jit->dylib, aliases, alias_count);
+        LLVMErrorRef error = LLVMOrcJITDylibDefine(jit->dylib, reexports);
+        if (error) {
+            report_error("Failed to define lazy reexports", error);
+            LLVMOrcDisposeMaterializationUnit(reexports);
+            failed = 1;
+        }
+    }
+    free(aliases);
+    return failed;
+}
+
+void* jit_lookup(OmniJIT* jit, const char* symbol) {
+    LLVMOrcExecutorAddress address = 0;
+    LLVMErrorRef error = LLVMOrcLLJITLookup(jit->jit, &address, symbol);
+    if (error) {
+        report_error(symbol, error);
+        return NULL;
+    }
+    if (perf_map_enabled) flush_perf_map(jit);
+    return (void*)(uintptr_t)address;
+}
+
+long long jit_run_main(OmniJIT* jit) {
+    void* address = jit_lookup(jit, "main");
+    if (address == NULL) {
         fprintf(stderr, "JIT Error: 'main' function not found in module.\n");
         return -1;
     }
-    
-    // We assume main returns an int, so we execute it and get the result.
-    LLVMGenericValueRef exec_res = LLVMRunFunction(engine, main_func, 0, NULL);
-    res = LLVMGenericValueToInt(exec_res, 0); // Second arg is is_signed
-    LLVMDisposeGenericValue(exec_res);
 
-    return (int)res;
+    // main takes no arguments and returns an i64.
+    long long (*main_func)(void) = (long long (*)(void))(uintptr_t)address;
+    return main_func();
 }
-
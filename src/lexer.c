@@ -12,7 +12,7 @@ static void read_char(Lexer* l);
 static char peek_char(Lexer* l);
 static Token new_token(TokenType type, const char* literal);
 static char* read_identifier(Lexer* l);
-static char* read_number(Lexer* l);
+static char* read_number(Lexer* l, int* is_float);
 static char* read_string(Lexer* l);
 static TokenType lookup_ident(const char* ident);
 static void handle_leading_whitespace_and_comments(Lexer* l); // Changed to void
@@ -102,6 +102,8 @@ static TokenType lookup_ident(const char* ident) {
     if (strcmp(ident, "as") == 0) return TOKEN_AS;
     if (strcmp(ident, "match") == 0) return TOKEN_MATCH;
     if (strcmp(ident, "case") == 0) return TOKEN_CASE;
+    if (strcmp(ident, "try") == 0) return TOKEN_TRY;
+    if (strcmp(ident, "except") == 0) return TOKEN_EXCEPT;
     if (strcmp(ident, "true") == 0) return TOKEN_TRUE;
     if (strcmp(ident, "false") == 0) return TOKEN_FALSE;
     if (strcmp(ident, "nil") == 0) return TOKEN_NIL;
@@ -128,12 +130,21 @@ static char* read_identifier(Lexer* l) {
     return ident;
 }
 
-static char* read_number(Lexer* l) {
+static char* read_number(Lexer* l, int* is_float) {
 
     size_t start_pos = l->position;
+    *is_float = 0;
     while (isdigit(l->ch)) {
         read_char(l);
     }
+    // A fractional part needs a digit after the '.', so `1..5` stays a range.
+    if (l->ch == '.' && isdigit(peek_char(l))) {
+        *is_float = 1;
+        read_char(l);
+        while (isdigit(l->ch)) {
+            read_char(l);
+        }
+    }
     size_t length = l->position - start_pos;
     char* num = malloc(length + 1);
     if (num == NULL) {
@@ -269,9 +280,7 @@ static void handle_leading_whitespace_and_comments(Lexer* l) {
 }
 
 
-// --- Main Public API ---
-
-Token get_next_token(Lexer* l) {
+static Token scan_token(Lexer* l) {
     Token tok;
 
     while (l->at_bol || l->ch == ' ' || l->ch == '\t' || l->ch == '\n' || l->ch == '#') {
@@ -329,7 +338,7 @@ Token get_next_token(Lexer* l) {
                 // Not implemented: .. range operator, for now illegal
                 tok = new_token(TOKEN_ILLEGAL, "..");
             } else {
-                tok = new_token(TOKEN_ILLEGAL, ".");
+                tok = new_token(TOKEN_DOT, ".");
             }
             break;
 
@@ -359,8 +368,9 @@ Token get_next_token(Lexer* l) {
                 tok.type = lookup_ident(tok.literal);
                 return tok; // Special return
             } else if (isdigit(l->ch)) {
-                tok.literal = read_number(l);
-                tok.type = TOKEN_INT;
+                int is_float;
+                tok.literal = read_number(l, &is_float);
+                tok.type = is_float ? TOKEN_FLOAT : TOKEN_INT;
                 return tok; // Special return
             } else {
                 tok = new_token(TOKEN_ILLEGAL, "");
@@ -371,3 +381,11 @@ Token get_next_token(Lexer* l) {
     read_char(l); // Advance for simple tokens that haven't already advanced.
     return tok;
 }
+
+// --- Main Public API ---
+
+Token get_next_token(Lexer* l) {
+    Token tok = scan_token(l);
+    tok.line = l->line_num; // Tokens never span lines, except the NL token itself
+    return tok;
+}
@@ -1,3 +1,4 @@
+#define _POSIX_C_SOURCE 200809L // strdup
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -10,6 +11,14 @@
 #include "object.h"
 #include "compiler.h"
 #include "jit_engine.h"
+#include "optimizer.h"
+#include "tier.h"
+#include "resolver.h"
+#include "type_infer.h"
+#include "aot.h"
+#include "ir.h"
+#include "inliner.h"
+#include "partial_eval.h"
 
 // Function to read the entire content of a file into a string
 char *read_file(const char *filepath) {
@@ -43,23 +52,120 @@ char *read_file(const char *filepath) {
     return buffer;
 }
 
-int main(int argc, char **argv) {
-    if (argc < 2) {
-        fprintf(stderr, "Fatal: No input files specified. Usage: omnicc [-jit] <file.ok>\n");
-        return 1;
+// `<input without .ok><extension>`, the default output of --emit-obj/--emit-exe.
+static char* output_path_for(const char* input, const char* extension) {
+    size_t length = strlen(input);
+    if (length > 3 && strcmp(input + length - 3, ".ok") == 0) length -= 3;
+    char* path = malloc(length + strlen(extension) + 1);
+    memcpy(path, input, length);
+    strcpy(path + length, extension);
+    return path;
+}
+
+// The runtime library next to omnicc (`<prefix>/bin/omnicc` -> `<prefix>/lib/`),
+// unless OMNI_RUNTIME_LIB points elsewhere.
+static char* runtime_lib_path(const char* argv0) {
+    const char* override = getenv("OMNI_RUNTIME_LIB");
+    if (override != NULL) return strdup(override);
+
+    const char* slash = strrchr(argv0, '/');
+    size_t dir_length = slash ? (size_t)(slash - argv0) : 1;
+    char* path = malloc(dir_length + strlen("/../lib/" AOT_RUNTIME_LIB) + 1);
+    memcpy(path, slash ? argv0 : ".", dir_length);
+    strcpy(path + dir_length, "/../lib/" AOT_RUNTIME_LIB);
+    return path;
+}
+
+// Compiles the program ahead of time to an object file or, with `link` set, an executable.
+static int emit_native(AST_Program* program, const char* source_path, const char* output_path, int link,
+                       int opt_level, int time_passes, const char* argv0) {
+    char* path = output_path ? strdup(output_path) : output_path_for(source_path, link ? "" : ".o");
+    char* object_path = link ? output_path_for(path, ".o") : strdup(path);
+
+    int failed = aot_compile_object((AST_Node*)program, object_path, opt_level, time_passes);
+    if (!failed && link) {
+        char* runtime_lib = runtime_lib_path(argv0);
+        failed = aot_link_executable(object_path, runtime_lib, path);
+        free(runtime_lib);
+        remove(object_path);
     }
-    
+    if (!failed) printf("AOT: Wrote %s\n", path);
+
+    free(object_path);
+    free(path);
+    return failed;
+}
+
+int main(int argc, char **argv) {
+    const char* usage = "Usage: omnicc [-jit|-tier|--emit-obj|--emit-exe] [-ir] [--dump-ir] [--no-inline] [--no-partial-eval] [-o <file>] [-O0|-O1|-O2|-O3] "
+                        "[--time-passes] [--type-report] [--no-jit-cache] [-g] [--perf-map] [--jitdump] <file.ok>";
     int use_jit = 0;
+    int emit = 0; // 1: object file, 2: executable
+    char* output_path = NULL;
+    int use_tiering = 0;
+    int use_ir = 0;
+    int dump_ir = 0;
+    int inlining = 1;
+    int partial_eval = 1;
+    int opt_level = OPT_LEVEL_DEFAULT;
+    int time_passes = 0;
+    int type_report = 0;
+    int jit_cache = 1;
+    int debug_info = 0;
+    int perf_map = 0;
+    int jitdump = 0;
     char* source_file_path = NULL;
 
-    if (argc > 2 && strcmp(argv[1], "-jit") == 0) {
-        use_jit = 1;
-        source_file_path = argv[2];
-    } else {
-        source_file_path = argv[1];
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-jit") == 0) {
+            use_jit = 1;
+        } else if (strcmp(argv[i], "-tier") == 0) {
+            use_tiering = 1;
+        } else if (strcmp(argv[i], "-ir") == 0) {
+            use_ir = 1;
+        } else if (strcmp(argv[i], "--dump-ir") == 0) {
+            dump_ir = 1;
+        } else if (strcmp(argv[i], "--no-inline") == 0) {
+            inlining = 0;
+        } else if (strcmp(argv[i], "--no-partial-eval") == 0) {
+            partial_eval = 0;
+        } else if (strncmp(argv[i], "-O", 2) == 0 && argv[i][2] >= '0' && argv[i][2] <= '3' && argv[i][3] == '\0') {
+            opt_level = argv[i][2] - '0';
+        } else if (strcmp(argv[i], "--time-passes") == 0) {
+            time_passes = 1;
+        } else if (strcmp(argv[i], "--emit-obj") == 0) {
+            emit = 1;
+        } else if (strcmp(argv[i], "--emit-exe") == 0) {
+            emit = 2;
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output_path = argv[++i];
+        } else if (strcmp(argv[i], "--type-report") == 0) {
+            type_report = 1;
+        } else if (strcmp(argv[i], "--no-jit-cache") == 0) {
+            jit_cache = 0;
+        } else if (strcmp(argv[i], "-g") == 0) {
+            debug_info = 1;
+        } else if (strcmp(argv[i], "--perf-map") == 0) {
+            perf_map = 1;
+        } else if (strcmp(argv[i], "--jitdump") == 0) {
+            jitdump = 1;
+            debug_info = 1; // A jitdump without line info only names functions
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "Fatal: Unknown option '%s'. %s\n", argv[i], usage);
+            return 1;
+        } else {
+            source_file_path = argv[i];
+        }
     }
-    
+
+    if (source_file_path == NULL) {
+        fprintf(stderr, "Fatal: No input files specified. %s\n", usage);
+        return 1;
+    }
+
     printf("Processing: %s\n", source_file_path);
+    if (debug_info) compiler_set_debug_source(source_file_path);
+    jit_set_profiling(perf_map, jitdump);
 
     char *source_code = read_file(source_file_path);
     if (source_code == NULL) {
@@ -79,34 +185,96 @@ int main(int argc, char **argv) {
         }
         printf("Processing failed.\n");
     } else {
-        if (use_jit) {
+        // Calls that are constant are gone before the inliner looks at the rest
+        if (partial_eval) {
+            int folded = partial_evaluate(program);
+            if (time_passes) fprintf(stderr, "Partial evaluation: %d calls folded\n", folded);
+        }
+        if (inlining) inline_program(program);
+        if (type_report) {
+            TypeReport report;
+            resolve_program(program);
+            infer_types(program, &report);
+            print_type_report(&report);
+        }
+        // The experimental SSA IR (ir.h), only with -ir: run on its own VM, or
+        // lowered to LLVM with -jit
+        IRProgram* ir = NULL;
+        if ((use_ir || dump_ir) && !emit) {
+            ir = ir_lower_program(program);
+            if (ir != NULL) {
+                ir_optimize(ir);
+                if (dump_ir) ir_print_program(ir, stdout);
+            } else if (use_ir) {
+                printf("Falling back to the %s.\n", use_jit ? "AST compiler" : "interpreter");
+            }
+        }
+        int interpret_program = 0;
+        if (emit) {
+            printf("Parsing complete. Compiling ahead of time...\n");
+            if (emit_native(program, source_file_path, output_path, emit == 2, opt_level, time_passes, argv[0])) {
+                printf("AOT compilation failed.\n");
+                free(source_code);
+                return 1;
+            }
+        } else if (use_jit) {
             printf("Parsing complete. JIT Compiling...\n");
             
             jit_init();
 
-            LLVMModuleRef module = compile_to_llvm_ir((AST_Node*)program);
+            OmniJIT* jit = jit_create(opt_level, time_passes);
+            if (jit && jit_cache) {
+                jit_use_cache(jit, NULL); // Warm starts skip optimization and codegen
+            }
+            CompiledProgram* compiled = NULL;
+            if (jit && ir && use_ir) {
+                compiled = ir_compile_to_llvm(ir, jit_get_context(jit));
+            } else if (jit) {
+                compiled = compile_to_llvm_ir((AST_Node*)program, jit_get_context(jit));
+            }
 
-            if (module) {
-                LLVMExecutionEngineRef engine = jit_create_engine(module);
-                if (engine) {
-                    printf("JIT compilation complete. Running...\n");
-                    int result = jit_run_main(engine);
-                    printf("JIT Result: %d\n", result);
-                    LLVMDisposeExecutionEngine(engine);
-                }
+            if (compiled && jit_add_program(jit, compiled) == 0) {
+                // Functions are compiled lazily, on their first call
+                printf("JIT compilation complete. Running...\n");
+                long long result = jit_run_main(jit);
+                printf("JIT Result: %lld\n", result);
+            } else if (jit && compiled == NULL) {
+                // Uses something the compiler can't lower yet, such as
+                // closures or classes: the errors above say what
+                printf("Falling back to the interpreter.\n");
+                interpret_program = 1;
             } else {
                 printf("JIT compilation failed.\n");
             }
+            compiled_program_dispose(compiled);
+            jit_dispose(jit);
             
             jit_shutdown();
 
+        } else if (ir && use_ir) {
+            printf("Parsing complete. Running on the IR VM...\n");
+            IRBytecode* code = ir_compile_bytecode(ir);
+            OmniValue result = ir_execute(code);
+            printf("IR Result: ");
+            omni_print(result);
+            ir_bytecode_free(code);
         } else {
+            interpret_program = 1;
+        }
+        if (interpret_program) {
             printf("Parsing complete. Interpreting...\n");
+            if (use_tiering) {
+                tier_init(opt_level, time_passes); // Hot functions get promoted to the JIT
+            }
             Object* result = interpret(program);
             printf("Result: ");
             print_object(result);
             printf("\n");
+            if (use_tiering) {
+                tier_shutdown();
+            }
         }
+        ir_program_free(ir);
     }
 
     // TODO: Need a function to free the entire AST, parser errors, etc.
@@ -0,0 +1,73 @@
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unwind.h>
+
+#include "omni_error.h"
+#include "intern.h"
+
+static OmniHandler* handlers = NULL; // Innermost first
+static const char* message = "";
+
+void omni_try_begin(OmniHandler* handler) {
+    handler->previous = handlers;
+    handlers = handler;
+}
+
+void omni_try_end(OmniHandler* handler) {
+    handlers = handler->previous;
+}
+
+const char* omni_error_message(void) {
+    return message;
+}
+
+OmniValue omni_caught(void) {
+    return omni_new_string(message);
+}
+
+// Called for every frame before its landing pads run. The handler's frame
+// is the first one whose canonical frame address (the stack pointer in its
+// caller) lies above the handler, as the stack grows down. A frame without
+// unwind information ends the walk early; the handler is still intact
+// there, only the landing pads beyond that frame are skipped.
+static _Unwind_Reason_Code stop_at_handler(int version, _Unwind_Action actions, _Unwind_Exception_Class class,
+                                           struct _Unwind_Exception* exception, struct _Unwind_Context* context,
+                                           void* argument) {
+    (void)version;
+    (void)class;
+    (void)exception;
+    (void)argument;
+
+    OmniHandler* handler = handlers;
+    if (handler != NULL && ((actions & _UA_END_OF_STACK) || _Unwind_GetCFA(context) > (uintptr_t)handler)) {
+        handlers = handler->previous;
+        longjmp(handler->target, 1);
+    }
+    if (actions & _UA_END_OF_STACK) {
+        fprintf(stderr, "Runtime Error: %s\n", message);
+        exit(1);
+    }
+    return _URC_NO_REASON;
+}
+
+void omni_raise(const char* format, ...) {
+    static struct _Unwind_Exception exception;
+
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    message = intern(buffer);
+
+    memset(&exception, 0, sizeof(exception));
+    memcpy(&exception.exception_class, "OMNIOMNI", sizeof(exception.exception_class));
+    _Unwind_ForcedUnwind(&exception, stop_at_handler, NULL);
+
+    // The unwinder couldn't even start
+    fprintf(stderr, "Runtime Error: %s\n", message);
+    exit(1);
+}
@@ -0,0 +1,8 @@
+// Entry point of ahead-of-time compiled programs (see aot.h). Part of the
+// runtime library, not of omnicc.
+long long omni_main();
+
+int main() {
+    omni_main();
+    return 0;
+}
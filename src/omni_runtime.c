@@ -2,17 +2,9 @@
 #include <stdlib.h>
 #include <string.h>
 
-// Custom _strdup for C99 compatibility
-static char* _strdup(const char* s) {
-    size_t size = strlen(s) + 1;
-    char* p = malloc(size);
-    if (p) {
-        memcpy(p, s, size);
-    }
-    return p;
-}
-
 #include "omni_runtime.h"
+#include "omni_error.h"
+#include "intern.h"
 
 // --- Object Creation Functions ---
 OmniValue omni_new_integer(long long val) {
@@ -22,6 +14,13 @@ OmniValue omni_new_integer(long long val) {
     return obj;
 }
 
+OmniValue omni_new_float(double val) {
+    OmniValue obj;
+    obj.type = OMNI_FLOAT;
+    obj.value.floating = val;
+    return obj;
+}
+
 OmniValue omni_new_boolean(int val) {
     OmniValue obj;
     obj.type = OMNI_BOOLEAN;
@@ -39,7 +38,7 @@ OmniValue omni_new_nil() {
 OmniValue omni_new_string(const char* val) {
     OmniValue obj;
     obj.type = OMNI_STRING;
-    obj.value.string = _strdup(val); // Duplicate the string for ownership
+    obj.value.string = intern(val); // Canonical copy, compared by pointer
     return obj;
 }
 
@@ -49,6 +48,9 @@ void omni_print(OmniValue val) {
         case OMNI_INTEGER:
             printf("%lld\n", val.value.integer);
             break;
+        case OMNI_FLOAT:
+            printf("%g\n", val.value.floating);
+            break;
         case OMNI_BOOLEAN:
             printf("%s\n", val.value.boolean ? "true" : "false");
             break;
@@ -64,104 +66,210 @@ void omni_print(OmniValue val) {
     }
 }
 
-// --- Binary Operations (Example: Integer Addition) ---
-OmniValue omni_add(OmniValue left, OmniValue right) {
-    if (left.type == OMNI_INTEGER && right.type == OMNI_INTEGER) {
-        return omni_new_integer(left.value.integer + right.value.integer);
-    } else if (left.type == OMNI_STRING && right.type == OMNI_STRING) {
-        // String concatenation
-        size_t len = strlen(left.value.string) + strlen(right.value.string) + 1;
-        char* new_str = malloc(len);
-        if (new_str == NULL) { /* Handle error */ exit(1); }
-        strcpy(new_str, left.value.string);
-        strcat(new_str, right.value.string);
-        return omni_new_string(new_str);
+// Prints `count` values on one line, separated by spaces (the `print` builtin).
+void omni_print_values(const OmniValue* values, int count) {
+    for (int i = 0; i < count; i++) {
+        if (i > 0) printf(" ");
+        switch (values[i].type) {
+            case OMNI_INTEGER: printf("%lld", values[i].value.integer); break;
+            case OMNI_FLOAT: printf("%g", values[i].value.floating); break;
+            case OMNI_BOOLEAN: printf("%s", values[i].value.boolean ? "true" : "false"); break;
+            case OMNI_NIL: printf("nil"); break;
+            case OMNI_STRING: printf("%s", values[i].value.string); break;
+            case OMNI_OBJECT: printf("<object>"); break;
+            default: printf("<unknown>"); break;
+        }
     }
-    // TODO: Handle type errors and other type combinations
-    fprintf(stderr, "Runtime Error: Unsupported types for addition.\n");
-    exit(1);
+    printf("\n");
 }
 
-OmniValue omni_subtract(OmniValue left, OmniValue right) {
-    if (left.type == OMNI_INTEGER && right.type == OMNI_INTEGER) {
-        return omni_new_integer(left.value.integer - right.value.integer);
+// --- Operation Kernels ---
+
+// How an operator treats a pair of operand types.
+typedef enum {
+    PAIR_UNSUPPORTED,
+    PAIR_INTEGERS,
+    PAIR_NUMBERS, // Mixed int/float, promoted to double
+    PAIR_STRINGS
+} OperandPair;
+
+#define I PAIR_INTEGERS
+#define N PAIR_NUMBERS
+#define S PAIR_STRINGS
+#define _ PAIR_UNSUPPORTED
+static const unsigned char operand_pairs[OMNI_TYPE_COUNT][OMNI_TYPE_COUNT] = {
+    //              INTEGER FLOAT BOOLEAN NIL STRING OBJECT
+    /* INTEGER */ { I,      N,    _,      _,  _,     _ },
+    /* FLOAT   */ { N,      N,    _,      _,  _,     _ },
+    /* BOOLEAN */ { _,      _,    _,      _,  _,     _ },
+    /* NIL     */ { _,      _,    _,      _,  _,     _ },
+    /* STRING  */ { _,      _,    _,      _,  S,     _ },
+    /* OBJECT  */ { _,      _,    _,      _,  _,     _ },
+};
+#undef I
+#undef N
+#undef S
+#undef _
+
+const char* const omni_binary_op_names[OMNI_OP_COUNT] = {
+    "addition", "subtraction", "multiplication", "division",
+    "equality comparison", "inequality comparison", "less than comparison", "greater than comparison",
+    "less than or equal comparison", "greater than or equal comparison",
+};
+
+static const char* const op_symbols[OMNI_OP_COUNT] = { "+", "-", "*", "/", "==", "!=", "<", ">", "<=", ">=" };
+
+int omni_binary_op_named(const char* symbol) {
+    for (int op = 0; op < OMNI_OP_COUNT; op++) {
+        if (strcmp(symbol, op_symbols[op]) == 0) return op;
     }
-    fprintf(stderr, "Runtime Error: Unsupported types for subtraction.\n");
-    exit(1);
+    return -1;
 }
 
-OmniValue omni_multiply(OmniValue left, OmniValue right) {
-    if (left.type == OMNI_INTEGER && right.type == OMNI_INTEGER) {
-        return omni_new_integer(left.value.integer * right.value.integer);
-    }
-    fprintf(stderr, "Runtime Error: Unsupported types for multiplication.\n");
-    exit(1);
+static OperandPair operand_pair(OmniValue left, OmniValue right) {
+    if ((unsigned)left.type >= OMNI_TYPE_COUNT || (unsigned)right.type >= OMNI_TYPE_COUNT) return PAIR_UNSUPPORTED;
+    return (OperandPair)operand_pairs[left.type][right.type];
 }
 
-OmniValue omni_divide(OmniValue left, OmniValue right) {
-    if (left.type == OMNI_INTEGER && right.type == OMNI_INTEGER) {
-        if (right.value.integer == 0) {
-            fprintf(stderr, "Runtime Error: Division by zero.\n");
-            exit(1);
-        }
-        return omni_new_integer(left.value.integer / right.value.integer);
-    }
-    fprintf(stderr, "Runtime Error: Unsupported types for division.\n");
-    exit(1);
+static double as_double(OmniValue val) {
+    return val.type == OMNI_FLOAT ? val.value.floating : (double)val.value.integer;
 }
 
-// --- Comparison Operations ---
-// Helper for general equality check
-static int omni_values_equal(OmniValue left, OmniValue right) {
+// Values of any types can be compared for equality; numbers by value.
+static int values_equal(OmniValue left, OmniValue right) {
+    switch (operand_pair(left, right)) {
+        case PAIR_INTEGERS: return left.value.integer == right.value.integer;
+        case PAIR_NUMBERS: return as_double(left) == as_double(right);
+        default: break;
+    }
     if (left.type != right.type) return 0;
-
     switch (left.type) {
-        case OMNI_INTEGER: return left.value.integer == right.value.integer;
         case OMNI_BOOLEAN: return left.value.boolean == right.value.boolean;
         case OMNI_NIL: return 1; // nil == nil
-        case OMNI_STRING: return strcmp(left.value.string, right.value.string) == 0;
-        default: return 0; // Unsupported types for direct comparison
+        case OMNI_STRING: return left.value.string == right.value.string; // Interned
+        case OMNI_OBJECT: return left.value.object == right.value.object;
+        default: return 0;
     }
 }
 
-OmniValue omni_equal(OmniValue left, OmniValue right) {
-    return omni_new_boolean(omni_values_equal(left, right));
+// The result is interned weakly: equal strings still share one entry, and
+// the entry goes away once whoever owns the value releases it (intern.h).
+static OmniValue concatenate(const char* left, const char* right) {
+    size_t left_len = intern_length(left);
+    size_t right_len = intern_length(right);
+    char stack_buffer[256];
+    char* buffer = left_len + right_len <= sizeof(stack_buffer) ? stack_buffer : malloc(left_len + right_len);
+    if (buffer == NULL) { /* Handle error */ exit(1); }
+    memcpy(buffer, left, left_len);
+    memcpy(buffer + left_len, right, right_len);
+    OmniValue result;
+    result.type = OMNI_STRING;
+    result.value.string = intern_weak_n(buffer, left_len + right_len);
+    if (buffer != stack_buffer) free(buffer);
+    return result;
 }
 
-OmniValue omni_not_equal(OmniValue left, OmniValue right) {
-    return omni_new_boolean(!omni_values_equal(left, right));
+OmniStatus omni_binary(OmniBinaryOp op, OmniValue left, OmniValue right, OmniValue* result) {
+    if (op == OMNI_OP_EQUAL || op == OMNI_OP_NOT_EQUAL) {
+        *result = omni_new_boolean(values_equal(left, right) == (op == OMNI_OP_EQUAL));
+        return OMNI_OK;
+    }
+    switch (operand_pair(left, right)) {
+        case PAIR_INTEGERS: {
+            long long l = left.value.integer, r = right.value.integer;
+            unsigned long long ul = (unsigned long long)l, ur = (unsigned long long)r;
+            switch (op) {
+                case OMNI_OP_ADD: *result = omni_new_integer((long long)(ul + ur)); break;
+                case OMNI_OP_SUBTRACT: *result = omni_new_integer((long long)(ul - ur)); break;
+                case OMNI_OP_MULTIPLY: *result = omni_new_integer((long long)(ul * ur)); break;
+                case OMNI_OP_DIVIDE:
+                    if (r == 0) return OMNI_DIVISION_BY_ZERO;
+                    *result = omni_new_integer(r == -1 ? (long long)(0ULL - ul) : l / r); // LLONG_MIN / -1 wraps
+                    break;
+                case OMNI_OP_LESS: *result = omni_new_boolean(l < r); break;
+                case OMNI_OP_GREATER: *result = omni_new_boolean(l > r); break;
+                case OMNI_OP_LESS_EQUAL: *result = omni_new_boolean(l <= r); break;
+                default: *result = omni_new_boolean(l >= r); break;
+            }
+            return OMNI_OK;
+        }
+        case PAIR_NUMBERS: {
+            double l = as_double(left), r = as_double(right);
+            switch (op) {
+                case OMNI_OP_ADD: *result = omni_new_float(l + r); break;
+                case OMNI_OP_SUBTRACT: *result = omni_new_float(l - r); break;
+                case OMNI_OP_MULTIPLY: *result = omni_new_float(l * r); break;
+                case OMNI_OP_DIVIDE:
+                    if (r == 0.0) return OMNI_DIVISION_BY_ZERO;
+                    *result = omni_new_float(l / r);
+                    break;
+                case OMNI_OP_LESS: *result = omni_new_boolean(l < r); break;
+                case OMNI_OP_GREATER: *result = omni_new_boolean(l > r); break;
+                case OMNI_OP_LESS_EQUAL: *result = omni_new_boolean(l <= r); break;
+                default: *result = omni_new_boolean(l >= r); break;
+            }
+            return OMNI_OK;
+        }
+        case PAIR_STRINGS:
+            if (op != OMNI_OP_ADD) return OMNI_UNSUPPORTED_TYPES;
+            *result = concatenate(left.value.string, right.value.string);
+            return OMNI_OK;
+        default:
+            return OMNI_UNSUPPORTED_TYPES;
+    }
 }
 
-OmniValue omni_less_than(OmniValue left, OmniValue right) {
-    if (left.type == OMNI_INTEGER && right.type == OMNI_INTEGER) {
-        return omni_new_boolean(left.value.integer < right.value.integer);
+OmniStatus omni_unary_minus(OmniValue value, OmniValue* result) {
+    if (value.type == OMNI_INTEGER) {
+        *result = omni_new_integer((long long)(0ULL - (unsigned long long)value.value.integer));
+    } else if (value.type == OMNI_FLOAT) {
+        *result = omni_new_float(-value.value.floating);
+    } else {
+        return OMNI_UNSUPPORTED_TYPES;
     }
-    fprintf(stderr, "Runtime Error: Unsupported types for less than comparison.\n");
-    exit(1);
+    return OMNI_OK;
 }
 
-OmniValue omni_greater_than(OmniValue left, OmniValue right) {
-    if (left.type == OMNI_INTEGER && right.type == OMNI_INTEGER) {
-        return omni_new_boolean(left.value.integer > right.value.integer);
+void omni_fail(OmniStatus status, const char* operation) {
+    if (status == OMNI_DIVISION_BY_ZERO) {
+        omni_raise("Division by zero.");
     }
-    fprintf(stderr, "Runtime Error: Unsupported types for greater than comparison.\n");
-    exit(1);
+    omni_raise("Unsupported types for %s.", operation);
 }
 
-OmniValue omni_less_than_equal(OmniValue left, OmniValue right) {
-    if (left.type == OMNI_INTEGER && right.type == OMNI_INTEGER) {
-        return omni_new_boolean(left.value.integer <= right.value.integer);
-    }
-    fprintf(stderr, "Runtime Error: Unsupported types for less than or equal comparison.\n");
-    exit(1);
+void omni_undefined(const char* name) {
+    omni_raise("Identifier '%s' not found.", name);
+}
+
+static OmniValue checked_binary(OmniBinaryOp op, OmniValue left, OmniValue right) {
+    OmniValue result;
+    OmniStatus status = omni_binary(op, left, right, &result);
+    if (status != OMNI_OK) omni_fail(status, omni_binary_op_names[op]);
+    return result;
+}
+
+OmniValue omni_add(OmniValue left, OmniValue right) { return checked_binary(OMNI_OP_ADD, left, right); }
+OmniValue omni_subtract(OmniValue left, OmniValue right) { return checked_binary(OMNI_OP_SUBTRACT, left, right); }
+OmniValue omni_multiply(OmniValue left, OmniValue right) { return checked_binary(OMNI_OP_MULTIPLY, left, right); }
+OmniValue omni_divide(OmniValue left, OmniValue right) { return checked_binary(OMNI_OP_DIVIDE, left, right); }
+
+OmniValue omni_negate(OmniValue val) {
+    OmniValue result;
+    OmniStatus status = omni_unary_minus(val, &result);
+    if (status != OMNI_OK) omni_fail(status, "negation");
+    return result;
 }
 
+// --- Comparison Operations ---
+OmniValue omni_equal(OmniValue left, OmniValue right) { return checked_binary(OMNI_OP_EQUAL, left, right); }
+OmniValue omni_not_equal(OmniValue left, OmniValue right) { return checked_binary(OMNI_OP_NOT_EQUAL, left, right); }
+OmniValue omni_less_than(OmniValue left, OmniValue right) { return checked_binary(OMNI_OP_LESS, left, right); }
+OmniValue omni_greater_than(OmniValue left, OmniValue right) { return checked_binary(OMNI_OP_GREATER, left, right); }
+OmniValue omni_less_than_equal(OmniValue left, OmniValue right) {
+    return checked_binary(OMNI_OP_LESS_EQUAL, left, right);
+}
 OmniValue omni_greater_than_equal(OmniValue left, OmniValue right) {
-    if (left.type == OMNI_INTEGER && right.type == OMNI_INTEGER) {
-        return omni_new_boolean(left.value.integer >= right.value.integer);
-    }
-    fprintf(stderr, "Runtime Error: Unsupported types for greater than or equal comparison.\n");
-    exit(1);
+    return checked_binary(OMNI_OP_GREATER_EQUAL, left, right);
 }
 
 // --- Truthiness ---
@@ -175,3 +283,14 @@ int omni_is_truthy(OmniValue val) {
     // For now, all other types (integers, strings) are truthy.
     return 1;
 }
+
+// The exit value of compiled programs: integers as is, floats truncated,
+// booleans as 0/1 and everything else as 0.
+long long omni_as_integer(OmniValue val) {
+    switch (val.type) {
+        case OMNI_INTEGER: return val.value.integer;
+        case OMNI_FLOAT: return (long long)val.value.floating;
+        case OMNI_BOOLEAN: return val.value.boolean ? 1 : 0;
+        default: return 0;
+    }
+}
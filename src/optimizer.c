@@ -0,0 +1,95 @@
+#include "optimizer.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <llvm-c/Core.h>
+#include <llvm-c/Error.h>
+#include <llvm-c/Support.h>
+#include <llvm-c/Target.h>
+#include <llvm-c/TargetMachine.h>
+#include <llvm-c/Transforms/PassBuilder.h>
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// LLVM options are global and may only be parsed once per process, even
+// with modules being optimized on several compiler threads.
+static void parse_pass_timing_option() {
+    const char* args[] = { "omnicc", "-time-passes" };
+    LLVMParseCommandLineOptions(2, args, NULL);
+}
+
+static void enable_pass_timing() {
+    static pthread_once_t once = PTHREAD_ONCE_INIT;
+    pthread_once(&once, parse_pass_timing_option);
+}
+
+// The pass cost models (unrolling, vectorization) depend on the target.
+static LLVMTargetMachineRef create_target_machine(int opt_level, LLVMRelocMode reloc, LLVMCodeModel code_model) {
+    char* triple = LLVMGetDefaultTargetTriple();
+    char* cpu = LLVMGetHostCPUName();
+    char* features = LLVMGetHostCPUFeatures();
+    char* error = NULL;
+    LLVMTargetRef target;
+    LLVMTargetMachineRef machine = NULL;
+
+    if (LLVMGetTargetFromTriple(triple, &target, &error) == 0) {
+        machine = LLVMCreateTargetMachine(target, triple, cpu, features, (LLVMCodeGenOptLevel)opt_level,
+                                          reloc, code_model);
+    } else {
+        fprintf(stderr, "Optimizer: No target for '%s': %s\n", triple, error);
+        LLVMDisposeMessage(error);
+    }
+
+    LLVMDisposeMessage(triple);
+    LLVMDisposeMessage(cpu);
+    LLVMDisposeMessage(features);
+    return machine;
+}
+
+LLVMTargetMachineRef create_host_target_machine(int opt_level) {
+    return create_target_machine(opt_level, LLVMRelocDefault, LLVMCodeModelJITDefault);
+}
+
+LLVMTargetMachineRef create_object_target_machine(int opt_level) {
+    return create_target_machine(opt_level, LLVMRelocPIC, LLVMCodeModelDefault); // Linkable into a PIE
+}
+
+int optimize_module(LLVMModuleRef module, int opt_level, int time_passes) {
+    if (opt_level < 0) opt_level = 0;
+    if (opt_level > 3) opt_level = 3;
+    if (time_passes) enable_pass_timing();
+
+    double start = now_ms();
+
+    char pipeline[32];
+    snprintf(pipeline, sizeof(pipeline), "default<O%d>", opt_level);
+
+    LLVMTargetMachineRef machine = create_host_target_machine(opt_level);
+    LLVMPassBuilderOptionsRef options = LLVMCreatePassBuilderOptions();
+    LLVMPassBuilderOptionsSetLoopVectorization(options, opt_level >= 2);
+    LLVMPassBuilderOptionsSetSLPVectorization(options, opt_level >= 2);
+    LLVMPassBuilderOptionsSetLoopUnrolling(options, opt_level >= 2);
+    LLVMPassBuilderOptionsSetLoopInterleaving(options, opt_level >= 2);
+
+    LLVMErrorRef error = LLVMRunPasses(module, pipeline, machine, options);
+
+    LLVMDisposePassBuilderOptions(options);
+    if (machine) LLVMDisposeTargetMachine(machine);
+
+    if (error) {
+        char* message = LLVMGetErrorMessage(error);
+        fprintf(stderr, "Optimizer: Pass pipeline '%s' failed: %s\n", pipeline, message);
+        LLVMDisposeErrorMessage(message);
+        return 1;
+    }
+
+    if (time_passes) {
+        fprintf(stderr, "Optimizer: -O%d pipeline took %.3f ms\n", opt_level, now_ms() - start);
+    }
+    return 0;
+}
@@ -5,6 +5,8 @@
 #include "parser.h"
 #include "ast.h"
 #include "lexer.h"
+#include "intern.h"
+#include "omni_runtime.h"
 
 // --- Precedence Enum for Pratt Parser ---
 typedef enum {
@@ -31,6 +33,7 @@ static AST_Expression* parse_expression(Parser* p, Precedence precedence);
 // Expression parsing prototypes
 static AST_Expression* parse_identifier(Parser* p);
 static AST_Expression* parse_integer_literal(Parser* p);
+static AST_Expression* parse_float_literal(Parser* p);
 static AST_Expression* parse_prefix_expression(Parser* p);
 static AST_Expression* parse_infix_expression(Parser* p, AST_Expression* left);
 static AST_Statement* parse_expression_statement(Parser* p);
@@ -40,6 +43,8 @@ static AST_Expression* parse_string_literal(Parser* p);
 static AST_Expression* parse_grouped_expression(Parser* p);
 static AST_Expression* parse_empty_block_expression(Parser* p);
 static AST_Expression* parse_call_expression(Parser* p, AST_Expression* function);
+static AST_Expression* parse_member_access(Parser* p, AST_Expression* object);
+static AST_Statement* parse_assignment(Parser* p, Token token, AST_Expression* target);
 static AST_Expression** parse_call_arguments(Parser* p);
 static AST_Statement* parse_if_statement(Parser* p);
 static AST_Statement* parse_fn_definition(Parser* p);
@@ -50,6 +55,7 @@ static AST_Statement* parse_for_statement(Parser* p);
 static AST_Statement* parse_class_definition(Parser* p);
 static AST_Statement* parse_match_statement(Parser* p);
 static AST_Statement_MatchCase* parse_match_case(Parser* p);
+static AST_Statement* parse_try_statement(Parser* p);
 static AST_Statement* parse_return_statement(Parser* p);
 static AST_Expression* parse_semicolon_operator(Parser* p, AST_Expression* left);
 static AST_Expression* parse_single_token_expression(Parser* p); // New prototype
@@ -121,8 +127,19 @@ static AST_Statement* parse_set_statement(Parser* p) {
     }
     stmt->name = name;
 
+    if (peek_token_is(p, TOKEN_DOT)) { // `set obj.property = value`
+        Token set_token = stmt->base.token;
+        free(stmt);
+        AST_Expression* target = (AST_Expression*)name;
+        while (peek_token_is(p, TOKEN_DOT)) {
+            parser_next_token(p);
+            target = parse_member_access(p, target);
+            if (target == NULL) return NULL;
+        }
+        return parse_assignment(p, set_token, target);
+    }
+
     if (!expect_peek(p, TOKEN_ASSIGN)) {
-        free(name->value);
         free(name);
         free(stmt);
         return NULL;
@@ -142,6 +159,7 @@ static AST_Statement* parse_if_statement(Parser* p) {
     AST_Statement_If* stmt = malloc(sizeof(AST_Statement_If));
     stmt->base.type = IF_STATEMENT;
     stmt->base.token = p->currentToken; // 'if' or 'elif' token
+    stmt->profile = (BranchProfile){0};
 
     parser_next_token(p); // consume 'if' or 'elif'
     stmt->condition = parse_expression(p, PREC_LOWEST);
@@ -241,6 +259,8 @@ static AST_Statement* parse_fn_definition(Parser* p) {
         while(stmt->parameters[count] != NULL) count++;
     }
     stmt->parameter_count = count;
+    stmt->captures = NULL;
+    stmt->capture_count = 0;
 
     if (!expect_peek(p, TOKEN_COLON)) {
         parser_add_error(p, "Expected ':' after function signature");
@@ -267,6 +287,8 @@ static AST_Expression* parse_fn_expression(Parser* p) {
         while(expr->parameters[count] != NULL) count++;
     }
     expr->parameter_count = count;
+    expr->captures = NULL;
+    expr->capture_count = 0;
 
     if (!expect_peek(p, TOKEN_COLON)) {
         parser_add_error(p, "Expected ':' after function signature");
@@ -286,12 +308,14 @@ static AST_Statement* parse_while_statement(Parser* p) {
     parser_next_token(p); // consume 'while'
     stmt->condition = parse_expression(p, PREC_LOWEST);
 
-    if (!current_token_is(p, TOKEN_COLON)) {
-        parser_add_error(p, "Expected ':' after while condition");
+    if (!expect_peek(p, TOKEN_COLON)) {
         // TODO: free memory
         return NULL;
     }
     stmt->body = parse_block_statement(p);
+    stmt->profile = (BranchProfile){0};
+    stmt->backedge_count = 0;
+    stmt->osr = NULL;
 
     return (AST_Statement*)stmt;
 }
@@ -325,6 +349,14 @@ static AST_Statement* parse_class_definition(Parser* p) {
 
     if (!expect_peek(p, TOKEN_IDENT)) { return NULL; }
     stmt->name = (AST_Expression_Identifier*)parse_identifier(p);
+    stmt->superclass = NULL;
+
+    if (peek_token_is(p, TOKEN_LPAREN)) { // `class Dog(Animal):`
+        parser_next_token(p);
+        if (!expect_peek(p, TOKEN_IDENT)) { return NULL; }
+        stmt->superclass = (AST_Expression_Identifier*)parse_identifier(p);
+        if (!expect_peek(p, TOKEN_RPAREN)) { return NULL; }
+    }
 
     if (!expect_peek(p, TOKEN_COLON)) { return NULL; }
 
@@ -389,6 +421,41 @@ static AST_Statement* parse_match_statement(Parser* p) {
     return (AST_Statement*)stmt;
 }
 
+static AST_Statement* parse_try_statement(Parser* p) {
+    AST_Statement_Try* stmt = malloc(sizeof(AST_Statement_Try));
+    stmt->base.type = TRY_STATEMENT;
+    stmt->base.token = p->currentToken; // The 'try' token
+    stmt->name = NULL;
+
+    if (!expect_peek(p, TOKEN_COLON)) { return NULL; }
+    stmt->body = parse_block_statement(p);
+
+    while (peek_token_is(p, TOKEN_NL)) {
+        parser_next_token(p);
+    }
+    if (!expect_peek(p, TOKEN_EXCEPT)) {
+        parser_add_error(p, "Expected 'except' after try block");
+        return NULL;
+    }
+    // `except:` or `except Exception [as <name>]:`; errors have no classes yet
+    if (peek_token_is(p, TOKEN_IDENT)) {
+        parser_next_token(p);
+        if (strcmp(p->currentToken.literal, "Exception") != 0) {
+            parser_add_error(p, "Only 'Exception' can be caught for now");
+            return NULL;
+        }
+        if (peek_token_is(p, TOKEN_AS)) {
+            parser_next_token(p); // consume 'as'
+            if (!expect_peek(p, TOKEN_IDENT)) { return NULL; }
+            stmt->name = (AST_Expression_Identifier*)parse_identifier(p);
+        }
+    }
+    if (!expect_peek(p, TOKEN_COLON)) { return NULL; }
+    stmt->handler = parse_block_statement(p);
+
+    return (AST_Statement*)stmt;
+}
+
 static AST_Statement* parse_return_statement(Parser* p) {
     AST_Statement_Return* stmt = malloc(sizeof(AST_Statement_Return));
     stmt->base.type = RETURN_STATEMENT;
@@ -435,9 +502,10 @@ static AST_Statement_Block* parse_block_statement(Parser* p) {
             block->statements = realloc(block->statements, block->statement_count * sizeof(AST_Statement*));
             block->statements[block->statement_count - 1] = stmt;
         }
+        parser_next_token(p); // Move past the last token of the statement
     }
     
-    if (!expect_peek(p, TOKEN_DEDENT)) { // Expect and consume DEDENT
+    if (!current_token_is(p, TOKEN_DEDENT)) { // The block ends on its DEDENT
         parser_add_error(p, "Expected dedent to end block");
         free(block);
         return NULL;
@@ -462,6 +530,7 @@ static const Precedence precedences[] = {
     [TOKEN_STAR] = PREC_PRODUCT,
     [TOKEN_LPAREN] = PREC_CALL,
     [TOKEN_LBRACKET] = PREC_INDEX,
+    [TOKEN_DOT] = PREC_INDEX,
     [TOKEN_SEMICOLON] = PREC_LOWEST // New: Semicolon as a statement separator
 };
 
@@ -477,8 +546,12 @@ static AST_Expression* parse_identifier(Parser* p) {
     AST_Expression_Identifier* ident = malloc(sizeof(AST_Expression_Identifier));
     ident->base.type = IDENTIFIER;
     ident->base.token = p->currentToken;
-    ident->value = malloc(strlen(p->currentToken.literal) + 1);
-    strcpy(ident->value, p->currentToken.literal);
+    ident->value = intern(p->currentToken.literal);
+    ident->scope = SCOPE_UNRESOLVED;
+    ident->index = -1;
+    ident->outer = SCOPE_UNRESOLVED;
+    ident->outer_index = -1;
+    ident->base.static_type = STATIC_DYNAMIC; // Assignment targets are never inferred
     return (AST_Expression*)ident;
 }
 
@@ -490,6 +563,14 @@ static AST_Expression* parse_integer_literal(Parser* p) {
     return (AST_Expression*)lit;
 }
 
+static AST_Expression* parse_float_literal(Parser* p) {
+    AST_Expression_FloatLiteral* lit = malloc(sizeof(AST_Expression_FloatLiteral));
+    lit->base.type = FLOAT_LITERAL;
+    lit->base.token = p->currentToken;
+    lit->value = strtod(p->currentToken.literal, NULL);
+    return (AST_Expression*)lit;
+}
+
 static AST_Expression* parse_boolean(Parser* p) {
     AST_Expression_Boolean* bool_expr = malloc(sizeof(AST_Expression_Boolean));
     bool_expr->base.type = BOOLEAN_LITERAL;
@@ -509,8 +590,7 @@ static AST_Expression* parse_string_literal(Parser* p) {
     AST_Expression_StringLiteral* str_expr = malloc(sizeof(AST_Expression_StringLiteral));
     str_expr->base.type = STRING_LITERAL;
     str_expr->base.token = p->currentToken;
-    str_expr->value = malloc(strlen(p->currentToken.literal) + 1);
-    strcpy(str_expr->value, p->currentToken.literal);
+    str_expr->value = intern(p->currentToken.literal);
     return (AST_Expression*)str_expr;
 }
 
@@ -618,11 +698,28 @@ static AST_Expression* parse_call_expression(Parser* p, AST_Expression* function
         }
     }
     call_expr->argument_count = count;
+    call_expr->method_cache.count = 0;
+    call_expr->method_cache.epoch = 0;
+    call_expr->profile = (CallProfile){0};
 
     return (AST_Expression*)call_expr;
 }
 
 
+static AST_Expression* parse_member_access(Parser* p, AST_Expression* object) {
+    if (!expect_peek(p, TOKEN_IDENT)) {
+        return NULL;
+    }
+    AST_Expression_MemberAccess* expr = malloc(sizeof(AST_Expression_MemberAccess));
+    expr->base.type = MEMBER_ACCESS_EXPRESSION;
+    expr->base.token = p->currentToken; // The property name
+    expr->object = object;
+    expr->property = intern(p->currentToken.literal);
+    inline_cache_init(&expr->cache);
+    return (AST_Expression*)expr;
+}
+
+
 static AST_Expression* parse_prefix_expression(Parser* p) {
     AST_Expression_Prefix* expr = malloc(sizeof(AST_Expression_Prefix));
     expr->base.type = PREFIX_EXPRESSION;
@@ -641,6 +738,7 @@ static AST_Expression* parse_infix_expression(Parser* p, AST_Expression* left) {
     expr->base.token = p->currentToken;
     expr->operator = malloc(strlen(p->currentToken.literal) + 1);
     strcpy(expr->operator, p->currentToken.literal);
+    expr->op = omni_binary_op_named(expr->operator);
     expr->left = left;
 
     Precedence prec = get_precedence(p->currentToken.type);
@@ -670,11 +768,50 @@ static AST_Expression* parse_expression(Parser* p, Precedence precedence) {
     return left_expr;
 }
 
+// `<target> = <value>`, where the current token ends the target.
+static AST_Statement* parse_assignment(Parser* p, Token token, AST_Expression* target) {
+    if (!expect_peek(p, TOKEN_ASSIGN)) {
+        return NULL;
+    }
+    parser_next_token(p);
+    AST_Expression* value = parse_expression(p, PREC_LOWEST);
+    if (value == NULL) {
+        return NULL;
+    }
+
+    if (target->type == IDENTIFIER) {
+        AST_Statement_Set* stmt = malloc(sizeof(AST_Statement_Set));
+        stmt->base.type = ASSIGN_STATEMENT;
+        stmt->base.token = token;
+        stmt->name = (AST_Expression_Identifier*)target;
+        stmt->value = value;
+        return (AST_Statement*)stmt;
+    } else if (target->type == MEMBER_ACCESS_EXPRESSION) {
+        AST_Statement_MemberSet* stmt = malloc(sizeof(AST_Statement_MemberSet));
+        stmt->base.type = MEMBER_SET_STATEMENT;
+        stmt->base.token = token;
+        stmt->target = (AST_Expression_MemberAccess*)target;
+        stmt->value = value;
+        return (AST_Statement*)stmt;
+    }
+
+    parser_add_error(p, "Invalid assignment target");
+    return NULL;
+}
+
 static AST_Statement* parse_expression_statement(Parser* p) {
+    Token token = p->currentToken;
+    AST_Expression* expression = parse_expression(p, PREC_LOWEST);
+
+    // Re-assignment without `set`: `x = x + 1`, `self.name = name`
+    if (expression != NULL && peek_token_is(p, TOKEN_ASSIGN)) {
+        return parse_assignment(p, token, expression);
+    }
+
     AST_Statement_Expression* stmt = malloc(sizeof(AST_Statement_Expression));
     stmt->base.type = EXPRESSION_STATEMENT;
-    stmt->base.token = p->currentToken;
-    stmt->expression = parse_expression(p, PREC_LOWEST);
+    stmt->base.token = token;
+    stmt->expression = expression;
     return (AST_Statement*)stmt;
 }
 
@@ -698,6 +835,8 @@ static AST_Statement* parse_statement(Parser* p) {
             return parse_class_definition(p);
         case TOKEN_MATCH:
             return parse_match_statement(p);
+        case TOKEN_TRY:
+            return parse_try_statement(p);
         case TOKEN_RETURN:
             return parse_return_statement(p);
         default:
@@ -727,6 +866,7 @@ Parser* new_parser(Lexer* l) {
     // Register prefix functions
     p->prefix_parse_fns[TOKEN_IDENT] = parse_identifier;
     p->prefix_parse_fns[TOKEN_INT] = parse_integer_literal;
+    p->prefix_parse_fns[TOKEN_FLOAT] = parse_float_literal;
     p->prefix_parse_fns[TOKEN_MINUS] = parse_prefix_expression;
     p->prefix_parse_fns[TOKEN_BANG] = parse_prefix_expression;
     p->prefix_parse_fns[TOKEN_TRUE] = parse_boolean;
@@ -755,6 +895,7 @@ Parser* new_parser(Lexer* l) {
     p->infix_parse_fns[TOKEN_LTE] = parse_infix_expression;
     p->infix_parse_fns[TOKEN_GTE] = parse_infix_expression;
     p->infix_parse_fns[TOKEN_LPAREN] = parse_call_expression;
+    p->infix_parse_fns[TOKEN_DOT] = parse_member_access;
     p->infix_parse_fns[TOKEN_SEMICOLON] = parse_semicolon_operator; // New: Semicolon as an infix operator (for now)
 
     parser_next_token(p);
@@ -779,6 +920,8 @@ AST_Program* parse_program(Parser* p) {
     }
     program->statements = NULL;
     program->statement_count = 0;
+    program->assigned_globals = NULL;
+    program->assigned_global_count = 0;
 
     while (!current_token_is(p, TOKEN_EOF)) {
         // Consume all newlines between statements
@@ -0,0 +1,585 @@
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "partial_eval.h"
+#include "resolver.h"
+#include "intern.h"
+#include "omni_runtime.h"
+
+typedef struct {
+    const char* name; // Interned
+    AST_Expression_Identifier** parameters;
+    int parameter_count;
+    AST_Statement_Block* body;
+    int defined_at; // Index of the defining top-level statement
+    int pure;
+} PureFunction;
+
+// A global a pure function reads through a local it hasn't assigned yet
+// (see resolver.h): one top-level `set` of a literal that nothing
+// reassigns, or a name nothing defines, so the read fails.
+typedef struct {
+    const char* name; // Interned
+    AST_Expression* value; // The literal; NULL if nothing defines the global
+    int defined_at;
+    int constant; // Either of the above; otherwise reads of it are impure
+} OuterGlobal;
+
+// The locals of a function call being evaluated.
+typedef struct {
+    const char** names; // Interned
+    OmniValue* values;
+    int count;
+    int capacity;
+} Frame;
+
+typedef enum {
+    EVAL_FAILED, // The program would fail or do something the sandbox can't
+    EVAL_EMPTY,  // No value, like an empty block
+    EVAL_VALUE,
+    EVAL_RETURN
+} EvalStatus;
+
+typedef struct {
+    AST_Program* program;
+    PureFunction* functions;
+    int function_count;
+    OuterGlobal* globals;
+    int global_count;
+
+    // Sandbox
+    int visible_before; // Functions defined at or after this top-level statement don't exist yet
+    long steps;
+    long total_steps;
+    int depth;
+
+    // Walk
+    int statement_index;
+    int function_depth;
+    int folded;
+} Evaluator;
+
+static PureFunction* find_function(Evaluator* ev, const char* name) {
+    for (int i = 0; i < ev->function_count; i++) {
+        if (ev->functions[i].name == name) return &ev->functions[i];
+    }
+    return NULL;
+}
+
+static int is_literal(AST_Expression* expr) {
+    switch (expr->type) {
+        case INTEGER_LITERAL: case FLOAT_LITERAL: case STRING_LITERAL: case BOOLEAN_LITERAL: case NIL_LITERAL:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static OuterGlobal* find_global(Evaluator* ev, const char* name) {
+    for (int i = 0; i < ev->global_count; i++) {
+        if (ev->globals[i].name == name) return &ev->globals[i];
+    }
+
+    OuterGlobal global = { name, NULL, -1, 0 };
+    int bindings = 0;
+    for (int i = 0; i < ev->program->statement_count; i++) {
+        AST_Statement* stmt = ev->program->statements[i];
+        if (!statement_binds(stmt, name)) continue;
+        bindings++;
+        if (stmt->type == SET_STATEMENT && is_literal(((AST_Statement_Set*)stmt)->value)) {
+            global.value = ((AST_Statement_Set*)stmt)->value;
+            global.defined_at = i;
+        }
+    }
+    global.constant = !function_assigns_global(ev->program, name) &&
+                      (bindings == 0 || (bindings == 1 && global.value != NULL));
+
+    ev->globals = realloc(ev->globals, (ev->global_count + 1) * sizeof(OuterGlobal));
+    ev->globals[ev->global_count] = global;
+    return &ev->globals[ev->global_count++];
+}
+
+// --- Purity ---
+
+static int expression_is_pure(Evaluator* ev, AST_Expression* expr) {
+    if (expr == NULL) return 0;
+    switch (expr->type) {
+        case INTEGER_LITERAL: case FLOAT_LITERAL: case STRING_LITERAL: case BOOLEAN_LITERAL: case NIL_LITERAL:
+            return 1;
+        case IDENTIFIER: {
+            AST_Expression_Identifier* ident = (AST_Expression_Identifier*)expr;
+            if (ident->scope != SCOPE_LOCAL) return 0;
+            return ident->outer == SCOPE_UNRESOLVED ||
+                   (ident->outer == SCOPE_GLOBAL && find_global(ev, ident->value)->constant);
+        }
+        case INFIX_EXPRESSION:
+            return expression_is_pure(ev, ((AST_Expression_Infix*)expr)->left) &&
+                   expression_is_pure(ev, ((AST_Expression_Infix*)expr)->right);
+        case PREFIX_EXPRESSION:
+            return expression_is_pure(ev, ((AST_Expression_Prefix*)expr)->right);
+        case CALL_EXPRESSION: {
+            AST_Expression_Call* call = (AST_Expression_Call*)expr;
+            if (call->function->type != IDENTIFIER) return 0;
+            AST_Expression_Identifier* callee = (AST_Expression_Identifier*)call->function;
+            PureFunction* function = find_function(ev, callee->value);
+            if (callee->scope != SCOPE_GLOBAL || function == NULL || !function->pure) return 0;
+            for (int i = 0; i < call->argument_count; i++) {
+                if (!expression_is_pure(ev, call->arguments[i])) return 0;
+            }
+            return 1;
+        }
+        default:
+            return 0;
+    }
+}
+
+static int statement_is_pure(Evaluator* ev, AST_Statement* stmt) {
+    if (stmt == NULL) return 0;
+    switch (stmt->type) {
+        case SET_STATEMENT:
+            return expression_is_pure(ev, ((AST_Statement_Set*)stmt)->value);
+        case ASSIGN_STATEMENT:
+            return ((AST_Statement_Set*)stmt)->name->scope == SCOPE_LOCAL &&
+                   expression_is_pure(ev, ((AST_Statement_Set*)stmt)->value);
+        case RETURN_STATEMENT:
+            return expression_is_pure(ev, ((AST_Statement_Return*)stmt)->return_value);
+        case EXPRESSION_STATEMENT:
+            return expression_is_pure(ev, ((AST_Statement_Expression*)stmt)->expression);
+        case BLOCK_STATEMENT: {
+            AST_Statement_Block* block = (AST_Statement_Block*)stmt;
+            for (int i = 0; i < block->statement_count; i++) {
+                if (!statement_is_pure(ev, block->statements[i])) return 0;
+            }
+            return 1;
+        }
+        case IF_STATEMENT: {
+            AST_Statement_If* if_stmt = (AST_Statement_If*)stmt;
+            return expression_is_pure(ev, if_stmt->condition) &&
+                   statement_is_pure(ev, (AST_Statement*)if_stmt->consequence) &&
+                   (if_stmt->alternative == NULL || statement_is_pure(ev, if_stmt->alternative));
+        }
+        case WHILE_STATEMENT: {
+            AST_Statement_While* while_stmt = (AST_Statement_While*)stmt;
+            return expression_is_pure(ev, while_stmt->condition) &&
+                   statement_is_pure(ev, (AST_Statement*)while_stmt->body);
+        }
+        default:
+            return 0; // Nested functions, classes, member stores, `for`, `match` and `try`
+    }
+}
+
+static void add_function(Evaluator* ev, AST_Program* program, int index, const char* name,
+                         AST_Expression_Identifier** parameters, int parameter_count, AST_Statement_Block* body) {
+    if (body == NULL) return;
+    int bindings = 0;
+    for (int i = 0; i < program->statement_count; i++) {
+        bindings += statement_binds(program->statements[i], name);
+    }
+    if (bindings != 1 || function_assigns_global(program, name)) return; // Which definition a call reaches depends on when it runs
+
+    ev->functions = realloc(ev->functions, (ev->function_count + 1) * sizeof(PureFunction));
+    ev->functions[ev->function_count++] = (PureFunction){ name, parameters, parameter_count, body, index, 1 };
+}
+
+// Starts from every top-level function and drops the impure ones until
+// none is left, so recursive functions can be pure.
+static void find_pure_functions(Evaluator* ev, AST_Program* program) {
+    for (int i = 0; i < program->statement_count; i++) {
+        AST_Statement* stmt = program->statements[i];
+        if (stmt == NULL) continue;
+        if (stmt->type == FN_DEFINITION) {
+            AST_Statement_FnDef* fn = (AST_Statement_FnDef*)stmt;
+            add_function(ev, program, i, fn->name->value, fn->parameters, fn->parameter_count, fn->body);
+        } else if (stmt->type == SET_STATEMENT && ((AST_Statement_Set*)stmt)->value != NULL &&
+                   ((AST_Statement_Set*)stmt)->value->type == FN_LITERAL) {
+            AST_Statement_Set* set = (AST_Statement_Set*)stmt;
+            AST_Expression_FnLiteral* fn = (AST_Expression_FnLiteral*)set->value;
+            add_function(ev, program, i, set->name->value, fn->parameters, fn->parameter_count, fn->body);
+        }
+    }
+
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int i = 0; i < ev->function_count; i++) {
+            PureFunction* function = &ev->functions[i];
+            if (function->pure && !statement_is_pure(ev, (AST_Statement*)function->body)) {
+                function->pure = 0;
+                changed = 1;
+            }
+        }
+    }
+}
+
+// --- Sandbox ---
+// Mirrors eval() in interpreter.c; where the interpreter would report an
+// error, crash or produce no value, evaluation fails instead.
+
+static int frame_get(Frame* frame, const char* name, OmniValue* out) {
+    for (int i = 0; frame != NULL && i < frame->count; i++) {
+        if (frame->names[i] == name) {
+            *out = frame->values[i];
+            return 1;
+        }
+    }
+    return 0; // Top-level code in the sandbox has no variables
+}
+
+static void frame_set(Frame* frame, const char* name, OmniValue value) {
+    for (int i = 0; i < frame->count; i++) {
+        if (frame->names[i] == name) {
+            frame->values[i] = value;
+            return;
+        }
+    }
+    if (frame->count >= frame->capacity) {
+        frame->capacity = frame->capacity ? frame->capacity * 2 : 8;
+        frame->names = realloc(frame->names, frame->capacity * sizeof(const char*));
+        frame->values = realloc(frame->values, frame->capacity * sizeof(OmniValue));
+    }
+    frame->names[frame->count] = name;
+    frame->values[frame->count++] = value;
+}
+
+// The same kernels the interpreter and compiled code run, so a folded
+// result is the one the program would have computed. An error leaves the
+// call in place.
+static int eval_infix(int op, OmniValue left, OmniValue right, OmniValue* out) {
+    return op >= 0 && omni_binary(op, left, right, out) == OMNI_OK;
+}
+
+static int eval_prefix(const char* operator, OmniValue right, OmniValue* out) {
+    if (strcmp(operator, "!") == 0) {
+        *out = omni_new_boolean(!omni_is_truthy(right));
+        return 1;
+    }
+    if (strcmp(operator, "-") == 0) {
+        return omni_unary_minus(right, out) == OMNI_OK;
+    }
+    *out = omni_new_nil();
+    return 1;
+}
+
+static EvalStatus eval_statement(Evaluator* ev, Frame* frame, AST_Statement* stmt, OmniValue* out);
+
+static int eval_expression(Evaluator* ev, Frame* frame, AST_Expression* expr, OmniValue* out) {
+    if (++ev->steps > PARTIAL_EVAL_STEP_BUDGET) return 0;
+    switch (expr->type) {
+        case INTEGER_LITERAL:
+            *out = omni_new_integer(((AST_Expression_IntegerLiteral*)expr)->value);
+            return 1;
+        case FLOAT_LITERAL:
+            *out = omni_new_float(((AST_Expression_FloatLiteral*)expr)->value);
+            return 1;
+        case BOOLEAN_LITERAL:
+            *out = omni_new_boolean(((AST_Expression_Boolean*)expr)->value);
+            return 1;
+        case NIL_LITERAL:
+            *out = omni_new_nil();
+            return 1;
+        case STRING_LITERAL:
+            *out = omni_new_string(((AST_Expression_StringLiteral*)expr)->value);
+            return 1;
+        case IDENTIFIER: {
+            AST_Expression_Identifier* ident = (AST_Expression_Identifier*)expr;
+            if (frame_get(frame, ident->value, out)) return 1;
+            if (ident->outer != SCOPE_GLOBAL) return 0;
+            OuterGlobal* global = find_global(ev, ident->value); // Not assigned yet
+            return global->value != NULL && global->defined_at < ev->visible_before &&
+                   eval_expression(ev, NULL, global->value, out);
+        }
+        case INFIX_EXPRESSION: {
+            AST_Expression_Infix* infix = (AST_Expression_Infix*)expr;
+            OmniValue left, right;
+            return eval_expression(ev, frame, infix->left, &left) &&
+                   eval_expression(ev, frame, infix->right, &right) &&
+                   eval_infix(infix->op, left, right, out);
+        }
+        case PREFIX_EXPRESSION: {
+            AST_Expression_Prefix* prefix = (AST_Expression_Prefix*)expr;
+            OmniValue right;
+            return eval_expression(ev, frame, prefix->right, &right) &&
+                   eval_prefix(prefix->operator, right, out);
+        }
+        case CALL_EXPRESSION: {
+            AST_Expression_Call* call = (AST_Expression_Call*)expr;
+            if (call->function->type != IDENTIFIER) return 0;
+            AST_Expression_Identifier* callee = (AST_Expression_Identifier*)call->function;
+            PureFunction* function = find_function(ev, callee->value);
+            if (callee->scope != SCOPE_GLOBAL || function == NULL || !function->pure) return 0;
+            if (function->defined_at >= ev->visible_before) return 0;
+            if (call->argument_count != function->parameter_count) return 0;
+            if (ev->depth >= PARTIAL_EVAL_MAX_DEPTH) return 0;
+
+            Frame callee_frame = {0};
+            int ok = 1;
+            for (int i = 0; ok && i < call->argument_count; i++) {
+                OmniValue argument;
+                ok = eval_expression(ev, frame, call->arguments[i], &argument);
+                if (ok) frame_set(&callee_frame, function->parameters[i]->value, argument);
+            }
+            if (ok) {
+                ev->depth++;
+                EvalStatus status = eval_statement(ev, &callee_frame, (AST_Statement*)function->body, out);
+                ev->depth--;
+                ok = status == EVAL_VALUE || status == EVAL_RETURN; // No value is an error later on
+            }
+            free(callee_frame.names);
+            free(callee_frame.values);
+            return ok;
+        }
+        default:
+            return 0;
+    }
+}
+
+static EvalStatus eval_statement(Evaluator* ev, Frame* frame, AST_Statement* stmt, OmniValue* out) {
+    if (++ev->steps > PARTIAL_EVAL_STEP_BUDGET) return EVAL_FAILED;
+    switch (stmt->type) {
+        case SET_STATEMENT:
+        case ASSIGN_STATEMENT: { // Pure functions only assign their own locals
+            AST_Statement_Set* set = (AST_Statement_Set*)stmt;
+            if (!eval_expression(ev, frame, set->value, out)) return EVAL_FAILED;
+            frame_set(frame, set->name->value, *out);
+            return EVAL_VALUE;
+        }
+        case EXPRESSION_STATEMENT:
+            return eval_expression(ev, frame, ((AST_Statement_Expression*)stmt)->expression, out)
+                   ? EVAL_VALUE : EVAL_FAILED;
+        case RETURN_STATEMENT:
+            return eval_expression(ev, frame, ((AST_Statement_Return*)stmt)->return_value, out)
+                   ? EVAL_RETURN : EVAL_FAILED;
+        case BLOCK_STATEMENT: {
+            AST_Statement_Block* block = (AST_Statement_Block*)stmt;
+            EvalStatus status = EVAL_EMPTY;
+            for (int i = 0; i < block->statement_count; i++) {
+                status = eval_statement(ev, frame, block->statements[i], out);
+                if (status == EVAL_FAILED || status == EVAL_RETURN) return status;
+            }
+            return status;
+        }
+        case IF_STATEMENT: {
+            AST_Statement_If* if_stmt = (AST_Statement_If*)stmt;
+            OmniValue condition;
+            if (!eval_expression(ev, frame, if_stmt->condition, &condition)) return EVAL_FAILED;
+            if (omni_is_truthy(condition)) return eval_statement(ev, frame, (AST_Statement*)if_stmt->consequence, out);
+            if (if_stmt->alternative != NULL) return eval_statement(ev, frame, if_stmt->alternative, out);
+            *out = omni_new_nil();
+            return EVAL_VALUE;
+        }
+        case WHILE_STATEMENT: {
+            AST_Statement_While* while_stmt = (AST_Statement_While*)stmt;
+            for (;;) {
+                OmniValue condition;
+                if (!eval_expression(ev, frame, while_stmt->condition, &condition)) return EVAL_FAILED;
+                if (!omni_is_truthy(condition)) break;
+                EvalStatus status = eval_statement(ev, frame, (AST_Statement*)while_stmt->body, out);
+                if (status == EVAL_FAILED || status == EVAL_RETURN) return status;
+            }
+            *out = omni_new_nil();
+            return EVAL_VALUE;
+        }
+        default:
+            return EVAL_FAILED;
+    }
+}
+
+// --- Folding ---
+
+static AST_Expression* new_literal(OmniValue value, AST_Expression* call) {
+    AST_Expression* literal;
+    switch (value.type) {
+        case OMNI_INTEGER: {
+            AST_Expression_IntegerLiteral* integer = malloc(sizeof(AST_Expression_IntegerLiteral));
+            integer->base.type = INTEGER_LITERAL;
+            integer->value = value.value.integer;
+            literal = (AST_Expression*)integer;
+            break;
+        }
+        case OMNI_FLOAT: {
+            AST_Expression_FloatLiteral* floating = malloc(sizeof(AST_Expression_FloatLiteral));
+            floating->base.type = FLOAT_LITERAL;
+            floating->value = value.value.floating;
+            literal = (AST_Expression*)floating;
+            break;
+        }
+        case OMNI_BOOLEAN: {
+            AST_Expression_Boolean* boolean = malloc(sizeof(AST_Expression_Boolean));
+            boolean->base.type = BOOLEAN_LITERAL;
+            boolean->value = value.value.boolean;
+            literal = (AST_Expression*)boolean;
+            break;
+        }
+        case OMNI_STRING: {
+            AST_Expression_StringLiteral* string = malloc(sizeof(AST_Expression_StringLiteral));
+            string->base.type = STRING_LITERAL;
+            string->value = intern(value.value.string); // Literals in the AST are interned
+            literal = (AST_Expression*)string;
+            break;
+        }
+        default:
+            literal = malloc(sizeof(AST_Expression_NilLiteral));
+            literal->type = NIL_LITERAL;
+            break;
+    }
+    literal->token = call->token; // Keeps the line for debug info
+    literal->static_type = STATIC_DYNAMIC;
+    return literal;
+}
+
+static void try_fold(Evaluator* ev, AST_Expression** slot) {
+    AST_Expression_Call* call = (AST_Expression_Call*)*slot;
+    if (call->function->type != IDENTIFIER) return;
+    PureFunction* function = find_function(ev, ((AST_Expression_Identifier*)call->function)->value);
+    if (function == NULL || !function->pure || ev->total_steps >= PARTIAL_EVAL_TOTAL_BUDGET) return;
+
+    // Top-level code runs in order; function bodies may run at any point after it
+    ev->visible_before = ev->function_depth > 0 ? INT_MAX : ev->statement_index;
+    ev->steps = 0;
+    ev->depth = 0;
+    OmniValue result;
+    int ok = eval_expression(ev, NULL, *slot, &result);
+    ev->total_steps += ev->steps;
+    if (!ok) return;
+    *slot = new_literal(result, *slot);
+    ev->folded++;
+}
+
+static void visit_statement(Evaluator* ev, AST_Statement* stmt);
+
+static void visit_expression(Evaluator* ev, AST_Expression** slot) {
+    AST_Expression* expr = *slot;
+    if (expr == NULL) return;
+    switch (expr->type) {
+        case INFIX_EXPRESSION:
+            visit_expression(ev, &((AST_Expression_Infix*)expr)->left);
+            visit_expression(ev, &((AST_Expression_Infix*)expr)->right);
+            break;
+        case PREFIX_EXPRESSION:
+            visit_expression(ev, &((AST_Expression_Prefix*)expr)->right);
+            break;
+        case ARRAY_LITERAL: {
+            AST_Expression_ArrayLiteral* array = (AST_Expression_ArrayLiteral*)expr;
+            for (int i = 0; i < array->element_count; i++) visit_expression(ev, &array->elements[i]);
+            break;
+        }
+        case MAP_LITERAL: {
+            AST_Expression_MapLiteral* map = (AST_Expression_MapLiteral*)expr;
+            for (int i = 0; i < map->entry_count; i++) {
+                visit_expression(ev, &map->entries[i]->key);
+                visit_expression(ev, &map->entries[i]->value);
+            }
+            break;
+        }
+        case MEMBER_ACCESS_EXPRESSION:
+            visit_expression(ev, &((AST_Expression_MemberAccess*)expr)->object);
+            break;
+        case CALL_EXPRESSION: {
+            AST_Expression_Call* call = (AST_Expression_Call*)expr;
+            visit_expression(ev, &call->function);
+            for (int i = 0; i < call->argument_count; i++) visit_expression(ev, &call->arguments[i]);
+            try_fold(ev, slot); // After the arguments, which may have become constants
+            break;
+        }
+        case FN_LITERAL:
+            ev->function_depth++;
+            visit_statement(ev, (AST_Statement*)((AST_Expression_FnLiteral*)expr)->body);
+            ev->function_depth--;
+            break;
+        default:
+            break;
+    }
+}
+
+static void visit_statement(Evaluator* ev, AST_Statement* stmt) {
+    if (stmt == NULL) return;
+    switch (stmt->type) {
+        case SET_STATEMENT:
+        case ASSIGN_STATEMENT:
+            visit_expression(ev, &((AST_Statement_Set*)stmt)->value);
+            break;
+        case MEMBER_SET_STATEMENT: {
+            AST_Statement_MemberSet* set = (AST_Statement_MemberSet*)stmt;
+            visit_expression(ev, &set->target->object);
+            visit_expression(ev, &set->value);
+            break;
+        }
+        case RETURN_STATEMENT:
+            visit_expression(ev, &((AST_Statement_Return*)stmt)->return_value);
+            break;
+        case EXPRESSION_STATEMENT:
+            visit_expression(ev, &((AST_Statement_Expression*)stmt)->expression);
+            break;
+        case BLOCK_STATEMENT: {
+            AST_Statement_Block* block = (AST_Statement_Block*)stmt;
+            for (int i = 0; i < block->statement_count; i++) visit_statement(ev, block->statements[i]);
+            break;
+        }
+        case FN_DEFINITION:
+            ev->function_depth++;
+            visit_statement(ev, (AST_Statement*)((AST_Statement_FnDef*)stmt)->body);
+            ev->function_depth--;
+            break;
+        case CLASS_DEFINITION: {
+            AST_Statement_ClassDef* class_def = (AST_Statement_ClassDef*)stmt;
+            for (int i = 0; class_def->body != NULL && i < class_def->body->statement_count; i++) {
+                visit_statement(ev, class_def->body->statements[i]); // Attributes run with the class definition
+            }
+            break;
+        }
+        case IF_STATEMENT: {
+            AST_Statement_If* if_stmt = (AST_Statement_If*)stmt;
+            visit_expression(ev, &if_stmt->condition);
+            visit_statement(ev, (AST_Statement*)if_stmt->consequence);
+            visit_statement(ev, if_stmt->alternative);
+            break;
+        }
+        case WHILE_STATEMENT: {
+            AST_Statement_While* while_stmt = (AST_Statement_While*)stmt;
+            visit_expression(ev, &while_stmt->condition);
+            visit_statement(ev, (AST_Statement*)while_stmt->body);
+            break;
+        }
+        case FOR_STATEMENT: {
+            AST_Statement_For* for_stmt = (AST_Statement_For*)stmt;
+            visit_expression(ev, &for_stmt->iterable);
+            visit_statement(ev, (AST_Statement*)for_stmt->body);
+            break;
+        }
+        case MATCH_STATEMENT: {
+            AST_Statement_Match* match = (AST_Statement_Match*)stmt;
+            visit_expression(ev, &match->value);
+            for (int i = 0; i < match->case_count; i++) {
+                if (match->cases[i] == NULL) continue;
+                visit_expression(ev, &match->cases[i]->pattern);
+                visit_statement(ev, (AST_Statement*)match->cases[i]->consequence);
+            }
+            break;
+        }
+        case TRY_STATEMENT: {
+            AST_Statement_Try* try_stmt = (AST_Statement_Try*)stmt;
+            visit_statement(ev, (AST_Statement*)try_stmt->body);
+            visit_statement(ev, (AST_Statement*)try_stmt->handler);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+int partial_evaluate(AST_Program* program) {
+    if (program == NULL) return 0;
+    resolve_program(program);
+
+    Evaluator ev = {0};
+    ev.program = program;
+    find_pure_functions(&ev, program);
+    for (int i = 0; i < program->statement_count; i++) {
+        ev.statement_index = i;
+        visit_statement(&ev, program->statements[i]);
+    }
+    free(ev.functions);
+    free(ev.globals);
+    return ev.folded;
+}
@@ -0,0 +1,482 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "resolver.h"
+
+// The names a function declares and the variables it captures. Top-level
+// code has no FunctionScope: everything it touches is global.
+typedef struct FunctionScope {
+    struct FunctionScope* enclosing;
+
+    const char** locals; // Interned; parameters first
+    int parameter_count;
+    int local_count;
+    int local_capacity;
+
+    AST_Capture* captures;
+    int capture_count;
+    int capture_capacity;
+
+    // Locals every path to the statement being resolved has assigned
+    const char** assigned; // Interned
+    int assigned_count;
+    int assigned_capacity;
+
+    int locals_escape; // A function nested in this one captures one of its locals
+} FunctionScope;
+
+static void resolve_node(AST_Node* node, FunctionScope* scope);
+
+static AST_Program* resolving; // The program being resolved
+
+// --- Scope Bookkeeping ---
+
+static int scope_declares(FunctionScope* scope, const char* name) {
+    for (int i = 0; i < scope->local_count; i++) {
+        if (scope->locals[i] == name) return 1;
+    }
+    return 0;
+}
+
+static int scope_is_assigned(FunctionScope* scope, const char* name) {
+    for (int i = 0; i < scope->assigned_count; i++) {
+        if (scope->assigned[i] == name) return 1;
+    }
+    return 0;
+}
+
+static void scope_declare(FunctionScope* scope, const char* name) {
+    if (scope == NULL || scope_declares(scope, name)) return;
+    if (scope->local_count >= scope->local_capacity) {
+        scope->local_capacity = scope->local_capacity ? scope->local_capacity * 2 : 8;
+        scope->locals = realloc(scope->locals, scope->local_capacity * sizeof(const char*));
+    }
+    scope->locals[scope->local_count++] = name;
+}
+
+// Records that a local has a value from here on.
+static void scope_assign(FunctionScope* scope, const char* name) {
+    if (scope == NULL || !scope_declares(scope, name) || scope_is_assigned(scope, name)) return;
+    if (scope->assigned_count >= scope->assigned_capacity) {
+        scope->assigned_capacity = scope->assigned_capacity ? scope->assigned_capacity * 2 : 8;
+        scope->assigned = realloc(scope->assigned, scope->assigned_capacity * sizeof(const char*));
+    }
+    scope->assigned[scope->assigned_count++] = name;
+}
+
+// Assignments are only ever appended, so where a branch or loop body
+// started is enough to forget what it assigned.
+static int scope_mark(FunctionScope* scope) {
+    return scope != NULL ? scope->assigned_count : 0;
+}
+
+static void scope_forget(FunctionScope* scope, int mark) {
+    if (scope != NULL) scope->assigned_count = mark;
+}
+
+static int scope_add_capture(FunctionScope* scope, const char* name, int from_local, int index) {
+    if (scope->capture_count >= scope->capture_capacity) {
+        scope->capture_capacity = scope->capture_capacity ? scope->capture_capacity * 2 : 4;
+        scope->captures = realloc(scope->captures, scope->capture_capacity * sizeof(AST_Capture));
+    }
+    AST_Capture* capture = &scope->captures[scope->capture_count];
+    capture->name = name;
+    capture->from_local = from_local;
+    capture->index = index;
+    return scope->capture_count++;
+}
+
+// Returns the capture slot of `name` in `scope`, threading it through every
+// function between the declaring one and `scope`; -1 if `name` is global.
+static int scope_capture(FunctionScope* scope, const char* name) {
+    for (int i = 0; i < scope->capture_count; i++) {
+        if (scope->captures[i].name == name) return i;
+    }
+
+    FunctionScope* enclosing = scope->enclosing;
+    if (enclosing == NULL) {
+        return -1;
+    }
+    if (scope_declares(enclosing, name)) {
+        enclosing->locals_escape = 1;
+        return scope_add_capture(scope, name, 1, -1);
+    }
+    int outer_index = scope_capture(enclosing, name);
+    if (outer_index < 0) {
+        return -1;
+    }
+    return scope_add_capture(scope, name, 0, outer_index);
+}
+
+static void resolve_identifier(AST_Expression_Identifier* ident, FunctionScope* scope) {
+    if (scope == NULL) {
+        ident->scope = SCOPE_GLOBAL;
+        return;
+    }
+    if (scope_declares(scope, ident->value)) {
+        ident->scope = SCOPE_LOCAL;
+        ident->outer = SCOPE_UNRESOLVED;
+        ident->outer_index = -1;
+        if (!scope_is_assigned(scope, ident->value)) {
+            // Possibly read before the function assigns the local: it may
+            // read the variable the local is about to shadow.
+            ident->outer_index = scope_capture(scope, ident->value);
+            ident->outer = ident->outer_index >= 0 ? SCOPE_UPVALUE : SCOPE_GLOBAL;
+        }
+        return;
+    }
+    int index = scope_capture(scope, ident->value);
+    if (index >= 0) {
+        ident->scope = SCOPE_UPVALUE;
+        ident->index = index;
+    } else {
+        ident->scope = SCOPE_GLOBAL;
+    }
+}
+
+// --- Declaration Hoisting ---
+static int block_binds(AST_Statement_Block* block, const char* name);
+
+int statement_binds(AST_Statement* stmt, const char* name) {
+    if (stmt == NULL) return 0;
+    switch (stmt->type) {
+        case SET_STATEMENT:
+        case ASSIGN_STATEMENT:
+            return ((AST_Statement_Set*)stmt)->name->value == name;
+        case FN_DEFINITION:
+            return ((AST_Statement_FnDef*)stmt)->name->value == name;
+        case CLASS_DEFINITION:
+            return ((AST_Statement_ClassDef*)stmt)->name->value == name;
+        case BLOCK_STATEMENT:
+            return block_binds((AST_Statement_Block*)stmt, name);
+        case IF_STATEMENT:
+            return block_binds(((AST_Statement_If*)stmt)->consequence, name) ||
+                   statement_binds(((AST_Statement_If*)stmt)->alternative, name);
+        case WHILE_STATEMENT:
+            return block_binds(((AST_Statement_While*)stmt)->body, name);
+        case FOR_STATEMENT:
+            return ((AST_Statement_For*)stmt)->iterator->value == name ||
+                   block_binds(((AST_Statement_For*)stmt)->body, name);
+        case MATCH_STATEMENT: {
+            AST_Statement_Match* match = (AST_Statement_Match*)stmt;
+            for (int i = 0; i < match->case_count; i++) {
+                if (match->cases[i] != NULL && block_binds(match->cases[i]->consequence, name)) return 1;
+            }
+            return 0;
+        }
+        case TRY_STATEMENT: {
+            AST_Statement_Try* try_stmt = (AST_Statement_Try*)stmt;
+            return (try_stmt->name != NULL && try_stmt->name->value == name) ||
+                   block_binds(try_stmt->body, name) || block_binds(try_stmt->handler, name);
+        }
+        default:
+            return 0;
+    }
+}
+
+static int block_binds(AST_Statement_Block* block, const char* name) {
+    for (int i = 0; block != NULL && i < block->statement_count; i++) {
+        if (statement_binds(block->statements[i], name)) return 1;
+    }
+    return 0;
+}
+
+// Collects every name a function body declares, without entering nested functions.
+static void collect_declarations(AST_Statement_Block* block, FunctionScope* scope) {
+    if (block == NULL) return;
+    for (int i = 0; i < block->statement_count; i++) {
+        AST_Statement* stmt = block->statements[i];
+        if (stmt == NULL) continue;
+        switch (stmt->type) {
+            case SET_STATEMENT:
+                scope_declare(scope, ((AST_Statement_Set*)stmt)->name->value);
+                break;
+            case FN_DEFINITION:
+                scope_declare(scope, ((AST_Statement_FnDef*)stmt)->name->value);
+                break;
+            case CLASS_DEFINITION:
+                scope_declare(scope, ((AST_Statement_ClassDef*)stmt)->name->value);
+                break;
+            case IF_STATEMENT: {
+                AST_Statement_If* if_stmt = (AST_Statement_If*)stmt;
+                collect_declarations(if_stmt->consequence, scope);
+                if (if_stmt->alternative != NULL) {
+                    if (if_stmt->alternative->type == BLOCK_STATEMENT) {
+                        collect_declarations((AST_Statement_Block*)if_stmt->alternative, scope);
+                    } else {
+                        AST_Statement_Block wrapper = { .statements = &if_stmt->alternative, .statement_count = 1 };
+                        collect_declarations(&wrapper, scope);
+                    }
+                }
+                break;
+            }
+            case WHILE_STATEMENT:
+                collect_declarations(((AST_Statement_While*)stmt)->body, scope);
+                break;
+            case FOR_STATEMENT: {
+                AST_Statement_For* for_stmt = (AST_Statement_For*)stmt;
+                scope_declare(scope, for_stmt->iterator->value);
+                collect_declarations(for_stmt->body, scope);
+                break;
+            }
+            case MATCH_STATEMENT: {
+                AST_Statement_Match* match = (AST_Statement_Match*)stmt;
+                for (int j = 0; j < match->case_count; j++) {
+                    if (match->cases[j] != NULL) collect_declarations(match->cases[j]->consequence, scope);
+                }
+                break;
+            }
+            case TRY_STATEMENT: {
+                AST_Statement_Try* try_stmt = (AST_Statement_Try*)stmt;
+                collect_declarations(try_stmt->body, scope);
+                if (try_stmt->name != NULL) scope_declare(scope, try_stmt->name->value);
+                collect_declarations(try_stmt->handler, scope);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
+
+// --- Functions ---
+
+static void resolve_function(AST_Expression_Identifier** parameters, int parameter_count,
+                             AST_Statement_Block* body, FunctionScope* enclosing,
+                             AST_Capture** captures, int* capture_count, AST_Frame* frame) {
+    FunctionScope scope = {0};
+    scope.enclosing = enclosing;
+
+    for (int i = 0; i < parameter_count; i++) {
+        scope_declare(&scope, parameters[i]->value);
+        scope_assign(&scope, parameters[i]->value);
+        parameters[i]->scope = SCOPE_LOCAL;
+    }
+    scope.parameter_count = scope.local_count;
+    collect_declarations(body, &scope);
+
+    resolve_node((AST_Node*)body, &scope);
+
+    frame->local_count = scope.local_count;
+    frame->locals_escape = scope.locals_escape;
+    free(scope.locals);
+    free(scope.assigned);
+    *captures = scope.captures;
+    *capture_count = scope.capture_count;
+}
+
+static void resolve_block(AST_Statement_Block* block, FunctionScope* scope) {
+    if (block == NULL) return;
+    for (int i = 0; i < block->statement_count; i++) {
+        resolve_node((AST_Node*)block->statements[i], scope);
+    }
+}
+
+static void resolve_node(AST_Node* node, FunctionScope* scope) {
+    if (node == NULL) return;
+
+    switch (node->type) {
+        case SET_STATEMENT: {
+            AST_Statement_Set* stmt = (AST_Statement_Set*)node;
+            resolve_node((AST_Node*)stmt->value, scope);
+            scope_assign(scope, stmt->name->value);
+            resolve_identifier(stmt->name, scope);
+            break;
+        }
+        case ASSIGN_STATEMENT: {
+            // Rebinds whatever `name` already refers to; never declares
+            AST_Statement_Set* stmt = (AST_Statement_Set*)node;
+            resolve_node((AST_Node*)stmt->value, scope);
+            scope_assign(scope, stmt->name->value);
+            resolve_identifier(stmt->name, scope);
+            if (scope != NULL && stmt->name->scope == SCOPE_GLOBAL &&
+                !function_assigns_global(resolving, stmt->name->value)) {
+                resolving->assigned_globals = realloc(resolving->assigned_globals,
+                                                      (resolving->assigned_global_count + 1) * sizeof(const char*));
+                resolving->assigned_globals[resolving->assigned_global_count++] = stmt->name->value;
+            }
+            break;
+        }
+        case MEMBER_SET_STATEMENT: {
+            AST_Statement_MemberSet* stmt = (AST_Statement_MemberSet*)node;
+            resolve_node((AST_Node*)stmt->target, scope);
+            resolve_node((AST_Node*)stmt->value, scope);
+            break;
+        }
+        case RETURN_STATEMENT:
+            resolve_node((AST_Node*)((AST_Statement_Return*)node)->return_value, scope);
+            break;
+        case EXPRESSION_STATEMENT:
+            resolve_node((AST_Node*)((AST_Statement_Expression*)node)->expression, scope);
+            break;
+        case BLOCK_STATEMENT:
+            resolve_block((AST_Statement_Block*)node, scope);
+            break;
+        case FN_DEFINITION: {
+            AST_Statement_FnDef* fn = (AST_Statement_FnDef*)node;
+            scope_assign(scope, fn->name->value);
+            resolve_identifier(fn->name, scope);
+            resolve_function(fn->parameters, fn->parameter_count, fn->body, scope,
+                             &fn->captures, &fn->capture_count, &fn->frame);
+            break;
+        }
+        case CLASS_DEFINITION: {
+            // Class bodies are not a scope of their own: methods close over
+            // the function the class is defined in.
+            AST_Statement_ClassDef* class_def = (AST_Statement_ClassDef*)node;
+            if (class_def->superclass != NULL) resolve_identifier(class_def->superclass, scope);
+            scope_assign(scope, class_def->name->value);
+            resolve_identifier(class_def->name, scope);
+            AST_Statement_Block* body = class_def->body;
+            for (int i = 0; body != NULL && i < body->statement_count; i++) {
+                AST_Statement* stmt = body->statements[i];
+                if (stmt != NULL && (stmt->type == SET_STATEMENT || stmt->type == ASSIGN_STATEMENT)) {
+                    resolve_node((AST_Node*)((AST_Statement_Set*)stmt)->value, scope); // A class attribute
+                } else {
+                    resolve_node((AST_Node*)stmt, scope);
+                }
+            }
+            break;
+        }
+        case IF_STATEMENT: {
+            AST_Statement_If* stmt = (AST_Statement_If*)node;
+            resolve_node((AST_Node*)stmt->condition, scope);
+            int mark = scope_mark(scope);
+            resolve_block(stmt->consequence, scope);
+            if (scope == NULL || stmt->alternative == NULL) {
+                scope_forget(scope, mark);
+                break;
+            }
+            // Afterwards, a local is assigned if both branches assigned it
+            int consequence_count = scope->assigned_count - mark;
+            const char** consequence = malloc((consequence_count + 1) * sizeof(const char*));
+            memcpy(consequence, scope->assigned + mark, consequence_count * sizeof(const char*));
+            scope_forget(scope, mark);
+            resolve_node((AST_Node*)stmt->alternative, scope);
+            int kept = mark;
+            for (int i = mark; i < scope->assigned_count; i++) {
+                for (int j = 0; j < consequence_count; j++) {
+                    if (consequence[j] == scope->assigned[i]) {
+                        scope->assigned[kept++] = scope->assigned[i];
+                        break;
+                    }
+                }
+            }
+            scope_forget(scope, kept);
+            free(consequence);
+            break;
+        }
+        case WHILE_STATEMENT: {
+            // The body may not run at all
+            AST_Statement_While* stmt = (AST_Statement_While*)node;
+            resolve_node((AST_Node*)stmt->condition, scope);
+            int mark = scope_mark(scope);
+            resolve_block(stmt->body, scope);
+            scope_forget(scope, mark);
+            break;
+        }
+        case FOR_STATEMENT: {
+            AST_Statement_For* stmt = (AST_Statement_For*)node;
+            resolve_node((AST_Node*)stmt->iterable, scope);
+            int mark = scope_mark(scope);
+            scope_assign(scope, stmt->iterator->value);
+            resolve_identifier(stmt->iterator, scope);
+            resolve_block(stmt->body, scope);
+            scope_forget(scope, mark);
+            break;
+        }
+        case MATCH_STATEMENT: {
+            AST_Statement_Match* stmt = (AST_Statement_Match*)node;
+            resolve_node((AST_Node*)stmt->value, scope);
+            int mark = scope_mark(scope);
+            for (int i = 0; i < stmt->case_count; i++) {
+                resolve_node((AST_Node*)stmt->cases[i], scope);
+                scope_forget(scope, mark); // No case has to match
+            }
+            break;
+        }
+        case MATCH_CASE_STATEMENT: {
+            AST_Statement_MatchCase* stmt = (AST_Statement_MatchCase*)node;
+            resolve_node((AST_Node*)stmt->pattern, scope);
+            resolve_block(stmt->consequence, scope);
+            break;
+        }
+        case TRY_STATEMENT: {
+            // The body may stop anywhere, and the handler may not run
+            AST_Statement_Try* stmt = (AST_Statement_Try*)node;
+            int mark = scope_mark(scope);
+            resolve_block(stmt->body, scope);
+            scope_forget(scope, mark);
+            if (stmt->name != NULL) {
+                scope_assign(scope, stmt->name->value);
+                resolve_identifier(stmt->name, scope);
+            }
+            resolve_block(stmt->handler, scope);
+            scope_forget(scope, mark);
+            break;
+        }
+        case IDENTIFIER:
+            resolve_identifier((AST_Expression_Identifier*)node, scope);
+            break;
+        case ARRAY_LITERAL: {
+            AST_Expression_ArrayLiteral* array = (AST_Expression_ArrayLiteral*)node;
+            for (int i = 0; i < array->element_count; i++) {
+                resolve_node((AST_Node*)array->elements[i], scope);
+            }
+            break;
+        }
+        case MAP_LITERAL: {
+            AST_Expression_MapLiteral* map = (AST_Expression_MapLiteral*)node;
+            for (int i = 0; i < map->entry_count; i++) {
+                resolve_node((AST_Node*)map->entries[i]->key, scope);
+                resolve_node((AST_Node*)map->entries[i]->value, scope);
+            }
+            break;
+        }
+        case INFIX_EXPRESSION: {
+            AST_Expression_Infix* infix = (AST_Expression_Infix*)node;
+            resolve_node((AST_Node*)infix->left, scope);
+            resolve_node((AST_Node*)infix->right, scope);
+            break;
+        }
+        case PREFIX_EXPRESSION:
+            resolve_node((AST_Node*)((AST_Expression_Prefix*)node)->right, scope);
+            break;
+        case CALL_EXPRESSION: {
+            AST_Expression_Call* call = (AST_Expression_Call*)node;
+            resolve_node((AST_Node*)call->function, scope);
+            for (int i = 0; i < call->argument_count; i++) {
+                resolve_node((AST_Node*)call->arguments[i], scope);
+            }
+            break;
+        }
+        case MEMBER_ACCESS_EXPRESSION:
+            resolve_node((AST_Node*)((AST_Expression_MemberAccess*)node)->object, scope);
+            break;
+        case FN_LITERAL: {
+            AST_Expression_FnLiteral* fn = (AST_Expression_FnLiteral*)node;
+            resolve_function(fn->parameters, fn->parameter_count, fn->body, scope,
+                             &fn->captures, &fn->capture_count, &fn->frame);
+            break;
+        }
+        default:
+            break; // Literals and empty expressions reference no names
+    }
+}
+
+void resolve_program(AST_Program* program) {
+    resolving = program;
+    program->assigned_global_count = 0; // Resolving again finds them again
+    for (int i = 0; i < program->statement_count; i++) {
+        resolve_node((AST_Node*)program->statements[i], NULL);
+    }
+    resolving = NULL;
+}
+
+int function_assigns_global(AST_Program* program, const char* name) {
+    for (int i = 0; i < program->assigned_global_count; i++) {
+        if (program->assigned_globals[i] == name) return 1;
+    }
+    return 0;
+}
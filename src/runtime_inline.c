@@ -0,0 +1,240 @@
+#include "runtime_inline.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <llvm-c/BitReader.h>
+#include <llvm-c/Core.h>
+#include <llvm-c/Linker.h>
+#include <llvm-c/Target.h>
+
+// Runtime definitions are renamed so they never clash with the declarations
+// the compiler emitted for the same helpers.
+#define RUNTIME_SUFFIX ".rt"
+
+extern const char omni_runtime_bitcode_start[];
+extern const char omni_runtime_bitcode_end[];
+
+const char* runtime_bitcode(size_t* size) {
+    *size = (size_t)(omni_runtime_bitcode_end - omni_runtime_bitcode_start);
+    return omni_runtime_bitcode_start;
+}
+
+static LLVMModuleRef load_runtime(LLVMContextRef context) {
+    static int reported = 0;
+    size_t size;
+    const char* data = runtime_bitcode(&size);
+    if (size == 0) return NULL;
+
+    LLVMMemoryBufferRef buffer = LLVMCreateMemoryBufferWithMemoryRange(data, size, "omni_runtime.bc", 0);
+    LLVMModuleRef runtime = NULL;
+    if (LLVMParseBitcodeInContext2(context, buffer, &runtime)) {
+        if (!reported) fprintf(stderr, "Runtime: Embedded bitcode is unreadable, helpers won't be inlined.\n");
+        reported = 1;
+        runtime = NULL;
+    }
+    LLVMDisposeMemoryBuffer(buffer);
+    return runtime;
+}
+
+static int has_runtime_suffix(LLVMValueRef fn) {
+    size_t length;
+    const char* name = LLVMGetValueName2(fn, &length);
+    size_t suffix_length = strlen(RUNTIME_SUFFIX);
+    return length > suffix_length && strcmp(name + length - suffix_length, RUNTIME_SUFFIX) == 0;
+}
+
+// Renames the runtime's exported functions and lets them take on the JIT's
+// target CPU, which the inliner requires to be compatible with the caller's.
+// They stay external until linked: the linker drops unreferenced internals.
+static void prepare_runtime(LLVMModuleRef runtime) {
+    static const char* target_attributes[] = { "target-cpu", "target-features", "tune-cpu" };
+
+    for (LLVMValueRef fn = LLVMGetFirstFunction(runtime); fn != NULL; fn = LLVMGetNextFunction(fn)) {
+        if (LLVMIsDeclaration(fn)) continue;
+        for (size_t i = 0; i < sizeof(target_attributes) / sizeof(target_attributes[0]); i++) {
+            LLVMRemoveStringAttributeAtIndex(fn, LLVMAttributeFunctionIndex, target_attributes[i],
+                                             strlen(target_attributes[i]));
+        }
+        if (LLVMGetLinkage(fn) == LLVMExternalLinkage) {
+            size_t length;
+            const char* name = LLVMGetValueName2(fn, &length);
+            char* renamed = malloc(length + sizeof(RUNTIME_SUFFIX));
+            memcpy(renamed, name, length);
+            memcpy(renamed + length, RUNTIME_SUFFIX, sizeof(RUNTIME_SUFFIX));
+            LLVMSetValueName2(fn, renamed, strlen(renamed));
+            free(renamed);
+        }
+    }
+}
+
+// --- Adapters ---
+// The compiler passes `%OmniValue` as a first-class struct; clang lowers it
+// following the C ABI (on x86-64: an i32 and an i64 argument, returned as
+// `{ i32, i64 }`). Values are converted through memory, which SROA turns
+// back into plain register moves once the adapter is inlined.
+
+// Reinterprets `value` as `type` (no larger than it) by storing and reloading it.
+static LLVMValueRef build_reinterpret(LLVMBuilderRef builder, LLVMValueRef value, LLVMTypeRef type) {
+    LLVMValueRef slot = LLVMBuildAlloca(builder, LLVMTypeOf(value), "");
+    LLVMBuildStore(builder, value, slot);
+    LLVMValueRef cast = LLVMBuildBitCast(builder, slot, LLVMPointerType(type, 0), "");
+    return LLVMBuildLoad2(builder, type, cast, "");
+}
+
+static LLVMValueRef build_scalar(LLVMBuilderRef builder, LLVMValueRef value, LLVMTypeRef type) {
+    LLVMTypeRef from = LLVMTypeOf(value);
+    if (from == type) return value;
+    LLVMTypeKind from_kind = LLVMGetTypeKind(from), to_kind = LLVMGetTypeKind(type);
+    if (from_kind == LLVMIntegerTypeKind && to_kind == LLVMIntegerTypeKind) {
+        return LLVMBuildIntCast2(builder, value, type, LLVMGetIntTypeWidth(from) > 1, "");
+    }
+    if (from_kind == LLVMPointerTypeKind && to_kind == LLVMPointerTypeKind) {
+        return LLVMBuildBitCast(builder, value, type, "");
+    }
+    return NULL;
+}
+
+// Passes the struct `value` as the runtime's parameters starting at `*next`:
+// either split over as many registers as cover it, or by pointer.
+static int build_struct_arguments(LLVMBuilderRef builder, LLVMTargetDataRef data_layout, LLVMValueRef value,
+                                  LLVMTypeRef* params, unsigned param_count, unsigned* next, LLVMValueRef* args) {
+    unsigned first = *next;
+    if (first >= param_count) return 1;
+
+    if (LLVMGetTypeKind(params[first]) == LLVMPointerTypeKind) {
+        LLVMValueRef slot = LLVMBuildAlloca(builder, LLVMTypeOf(value), "");
+        LLVMBuildStore(builder, value, slot);
+        args[(*next)++] = LLVMBuildBitCast(builder, slot, params[first], "");
+        return 0;
+    }
+
+    unsigned long long size = LLVMABISizeOfType(data_layout, LLVMTypeOf(value));
+    for (unsigned count = 1; first + count <= param_count; count++) {
+        LLVMTypeRef coerced = LLVMStructTypeInContext(LLVMGetTypeContext(params[first]), &params[first], count, 0);
+        unsigned long long coerced_size = LLVMABISizeOfType(data_layout, coerced);
+        if (coerced_size < size) continue;
+        if (coerced_size > size) return 1;
+
+        LLVMValueRef parts = build_reinterpret(builder, value, coerced);
+        for (unsigned i = 0; i < count; i++) {
+            args[(*next)++] = LLVMBuildExtractValue(builder, parts, i, "");
+        }
+        return 0;
+    }
+    return 1;
+}
+
+static int build_adapter_return(LLVMBuilderRef builder, LLVMTargetDataRef data_layout, LLVMValueRef result,
+                                LLVMTypeRef return_type) {
+    LLVMTypeRef runtime_return = LLVMTypeOf(result);
+    if (LLVMGetTypeKind(return_type) == LLVMVoidTypeKind) {
+        LLVMBuildRetVoid(builder);
+        return 0;
+    }
+    if (LLVMGetTypeKind(runtime_return) == LLVMVoidTypeKind) return 1;
+
+    if (LLVMGetTypeKind(return_type) == LLVMStructTypeKind) {
+        if (LLVMABISizeOfType(data_layout, runtime_return) != LLVMABISizeOfType(data_layout, return_type)) return 1;
+        LLVMBuildRet(builder, build_reinterpret(builder, result, return_type));
+        return 0;
+    }
+    LLVMValueRef value = build_scalar(builder, result, return_type);
+    if (value == NULL) return 1;
+    LLVMBuildRet(builder, value);
+    return 0;
+}
+
+// Gives the compiler's declaration of a helper a body calling the runtime's
+// definition. Returns 1 (leaving the declaration alone) if the signatures
+// can't be matched up.
+static int build_adapter(LLVMModuleRef module, LLVMValueRef declaration, LLVMValueRef definition) {
+    LLVMTypeRef type = LLVMGlobalGetValueType(declaration);
+    LLVMTypeRef runtime_type = LLVMGlobalGetValueType(definition);
+    if (LLVMIsFunctionVarArg(runtime_type)) return 1;
+
+    unsigned param_count = LLVMCountParamTypes(runtime_type);
+    LLVMTypeRef* params = malloc((param_count + 1) * sizeof(LLVMTypeRef));
+    LLVMValueRef* args = malloc((param_count + 1) * sizeof(LLVMValueRef));
+    LLVMGetParamTypes(runtime_type, params);
+
+    LLVMContextRef context = LLVMGetModuleContext(module);
+    LLVMTargetDataRef data_layout = LLVMGetModuleDataLayout(module);
+    LLVMBasicBlockRef entry = LLVMAppendBasicBlockInContext(context, declaration, "entry");
+    LLVMBuilderRef builder = LLVMCreateBuilderInContext(context);
+    LLVMPositionBuilderAtEnd(builder, entry);
+
+    int failed = 0;
+    unsigned next = 0;
+    for (unsigned i = 0; i < LLVMCountParams(declaration) && !failed; i++) {
+        LLVMValueRef param = LLVMGetParam(declaration, i);
+        if (LLVMGetTypeKind(LLVMTypeOf(param)) == LLVMStructTypeKind) {
+            failed = build_struct_arguments(builder, data_layout, param, params, param_count, &next, args);
+        } else if (next < param_count && (args[next] = build_scalar(builder, param, params[next])) != NULL) {
+            next++;
+        } else {
+            failed = 1;
+        }
+    }
+    failed |= next != param_count;
+
+    if (!failed) {
+        LLVMValueRef result = LLVMBuildCall2(builder, runtime_type, definition, args, param_count, "");
+        failed = build_adapter_return(builder, data_layout, result, LLVMGetReturnType(type));
+    }
+
+    LLVMDisposeBuilder(builder);
+    free(params);
+    free(args);
+    if (failed) {
+        LLVMDeleteBasicBlock(entry); // Back to a declaration
+        return 1;
+    }
+    LLVMSetLinkage(declaration, LLVMInternalLinkage);
+    return 0;
+}
+
+int link_runtime_bitcode(LLVMModuleRef module) {
+    LLVMModuleRef runtime = load_runtime(LLVMGetModuleContext(module));
+    if (runtime == NULL) return 0;
+
+    prepare_runtime(runtime);
+    if (LLVMGetTarget(module)[0] != '\0') {
+        LLVMSetTarget(runtime, LLVMGetTarget(module));
+        LLVMSetDataLayout(runtime, LLVMGetDataLayoutStr(module));
+    }
+
+    // Helpers this module calls, collected before linking adds the runtime's own declarations
+    int count = 0, capacity = 16;
+    LLVMValueRef* declarations = malloc(capacity * sizeof(LLVMValueRef));
+    for (LLVMValueRef fn = LLVMGetFirstFunction(module); fn != NULL; fn = LLVMGetNextFunction(fn)) {
+        if (!LLVMIsDeclaration(fn)) continue;
+        if (count == capacity) declarations = realloc(declarations, (capacity *= 2) * sizeof(LLVMValueRef));
+        declarations[count++] = fn;
+    }
+
+    if (LLVMLinkModules2(module, runtime)) { // Consumes the runtime module
+        fprintf(stderr, "Runtime: Failed to link the runtime bitcode.\n");
+        free(declarations);
+        return 1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        size_t length;
+        const char* name = LLVMGetValueName2(declarations[i], &length);
+        char* runtime_name = malloc(length + sizeof(RUNTIME_SUFFIX));
+        memcpy(runtime_name, name, length);
+        memcpy(runtime_name + length, RUNTIME_SUFFIX, sizeof(RUNTIME_SUFFIX));
+
+        LLVMValueRef definition = LLVMGetNamedFunction(module, runtime_name);
+        if (definition != NULL) build_adapter(module, declarations[i], definition);
+        free(runtime_name);
+    }
+    free(declarations);
+
+    // Only the adapters call the runtime; whatever they don't use is dropped by the optimizer
+    for (LLVMValueRef fn = LLVMGetFirstFunction(module); fn != NULL; fn = LLVMGetNextFunction(fn)) {
+        if (!LLVMIsDeclaration(fn) && has_runtime_suffix(fn)) LLVMSetLinkage(fn, LLVMInternalLinkage);
+    }
+    return 0;
+}
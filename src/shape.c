@@ -0,0 +1,73 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "shape.h"
+
+static Shape* new_shape(Shape* parent, const char* property) {
+    Shape* shape = malloc(sizeof(Shape));
+    if (shape == NULL) {
+        fprintf(stderr, "Fatal: Memory allocation failed for shape\n");
+        exit(1);
+    }
+    shape->parent = parent;
+    shape->property = property;
+    shape->slot_count = parent ? parent->slot_count + 1 : 0;
+    shape->transitions = NULL;
+    shape->transition_count = 0;
+    shape->transition_capacity = 0;
+    return shape;
+}
+
+Shape* shape_new_root() {
+    return new_shape(NULL, NULL);
+}
+
+Shape* shape_add_property(Shape* shape, const char* property) {
+    for (int i = 0; i < shape->transition_count; i++) {
+        if (shape->transitions[i]->property == property) {
+            return shape->transitions[i];
+        }
+    }
+
+    if (shape->transition_count >= shape->transition_capacity) {
+        shape->transition_capacity = shape->transition_capacity ? shape->transition_capacity * 2 : 2;
+        shape->transitions = realloc(shape->transitions, shape->transition_capacity * sizeof(Shape*));
+        if (shape->transitions == NULL) {
+            fprintf(stderr, "Fatal: Memory allocation failed for shape transitions\n");
+            exit(1);
+        }
+    }
+
+    Shape* child = new_shape(shape, property);
+    shape->transitions[shape->transition_count++] = child;
+    return child;
+}
+
+int shape_lookup(const Shape* shape, const char* property) {
+    // The slot of a property is fixed by the depth at which it was added.
+    while (shape != NULL && shape->property != NULL) {
+        if (shape->property == property) {
+            return shape->slot_count - 1;
+        }
+        shape = shape->parent;
+    }
+    return -1;
+}
+
+void inline_cache_init(InlineCache* cache) {
+    cache->count = 0;
+    cache->megamorphic = 0;
+}
+
+void inline_cache_record(InlineCache* cache, Shape* shape, Shape* transition, int slot) {
+    if (cache->megamorphic) return;
+    if (cache->count >= INLINE_CACHE_ENTRIES) {
+        cache->megamorphic = 1;
+        cache->count = 0;
+        return;
+    }
+    InlineCacheEntry* entry = &cache->entries[cache->count++];
+    entry->shape = shape;
+    entry->transition = transition;
+    entry->slot = slot;
+}
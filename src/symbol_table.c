@@ -1,25 +1,36 @@
 #include "symbol_table.h"
+#include "intern.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-// A simple hash function (djb2)
-static unsigned long hash_string(const char *str) {
-    unsigned long hash = 5381;
-    int c;
-    while ((c = *str++)) {
-        hash = ((hash << 5) + hash) + c; /* hash * 33 + c */
+#define MIN_CAPACITY 8
+
+// The smallest power of two that holds `count` symbols under 3/4 load.
+static unsigned int capacity_for(unsigned int count) {
+    unsigned int capacity = MIN_CAPACITY;
+    while (capacity / 4 * 3 <= count) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+// The slot holding `name`, or the empty slot where it belongs.
+static Symbol* probe(Symbol* slots, unsigned int capacity, const char* name) {
+    unsigned int index = intern_hash(name) & (capacity - 1);
+    while (slots[index].name != NULL && slots[index].name != name) {
+        index = (index + 1) & (capacity - 1);
     }
-    return hash;
+    return &slots[index];
 }
 
 SymbolTable* symbol_table_create(unsigned int capacity) {
-    SymbolTable* table = malloc(sizeof(SymbolTable));
+    SymbolTable* table = calloc(1, sizeof(SymbolTable));
     if (!table) return NULL;
 
-    table->capacity = capacity;
-    table->buckets = calloc(capacity, sizeof(Symbol*));
-    if (!table->buckets) {
+    table->capacity = capacity_for(capacity);
+    table->slots = calloc(table->capacity, sizeof(Symbol));
+    if (!table->slots) {
         free(table);
         return NULL;
     }
@@ -28,49 +39,93 @@ SymbolTable* symbol_table_create(unsigned int capacity) {
 
 void symbol_table_destroy(SymbolTable* table) {
     if (!table) return;
+    free(table->slots);
+    free(table->undo);
+    free(table->scopes);
+    free(table);
+}
 
+static void grow(SymbolTable* table) {
+    unsigned int capacity = table->capacity * 2;
+    Symbol* slots = calloc(capacity, sizeof(Symbol));
+    if (!slots) {
+        fprintf(stderr, "Fatal: Memory allocation failed for symbol table\n");
+        exit(1);
+    }
     for (unsigned int i = 0; i < table->capacity; i++) {
-        Symbol* current = table->buckets[i];
-        while (current) {
-            Symbol* next = current->next;
-            free(current->name);
-            free(current);
-            current = next;
+        if (table->slots[i].name != NULL) {
+            *probe(slots, capacity, table->slots[i].name) = table->slots[i];
         }
     }
-    free(table->buckets);
-    free(table);
+    free(table->slots);
+    table->slots = slots;
+    table->capacity = capacity;
+}
+
+// Empties `slot`, moving later symbols of its probe run back into the gap
+// so every symbol stays reachable from its home slot without tombstones.
+static void remove_slot(SymbolTable* table, Symbol* slot) {
+    unsigned int mask = table->capacity - 1;
+    unsigned int hole = (unsigned int)(slot - table->slots);
+    unsigned int index = hole;
+    for (;;) {
+        index = (index + 1) & mask;
+        Symbol* next = &table->slots[index];
+        if (next->name == NULL) break;
+        unsigned int home = intern_hash(next->name) & mask;
+        if (((index - home) & mask) >= ((index - hole) & mask)) {
+            table->slots[hole] = *next; // Its home is at or before the hole
+            hole = index;
+        }
+    }
+    table->slots[hole].name = NULL;
+    table->slots[hole].value = NULL;
+    table->count--;
 }
 
 void symbol_table_set(SymbolTable* table, const char* name, LLVMValueRef value) {
-    unsigned int index = hash_string(name) % table->capacity;
+    if ((table->count + 1) * 4 > table->capacity * 3) {
+        grow(table);
+    }
 
-    // Check if the symbol already exists and update it
-    Symbol* current = table->buckets[index];
-    while (current) {
-        if (strcmp(current->name, name) == 0) {
-            current->value = value;
-            return;
+    Symbol* slot = probe(table->slots, table->capacity, name);
+    if (slot->name == NULL) {
+        slot->name = name;
+        table->count++;
+    }
+    if (table->scope_count > 0) {
+        if (table->undo_count == table->undo_capacity) {
+            table->undo_capacity = table->undo_capacity ? table->undo_capacity * 2 : 16;
+            table->undo = realloc(table->undo, table->undo_capacity * sizeof(SymbolUndo));
         }
-        current = current->next;
+        table->undo[table->undo_count].name = name;
+        table->undo[table->undo_count++].previous = slot->value;
     }
-
-    // If it doesn't exist, create a new symbol
-    Symbol* new_symbol = malloc(sizeof(Symbol));
-    new_symbol->name = strdup(name);
-    new_symbol->value = value;
-    new_symbol->next = table->buckets[index];
-    table->buckets[index] = new_symbol;
+    slot->value = value;
 }
 
 LLVMValueRef symbol_table_get(SymbolTable* table, const char* name) {
-    unsigned int index = hash_string(name) % table->capacity;
-    Symbol* current = table->buckets[index];
-    while (current) {
-        if (strcmp(current->name, name) == 0) {
-            return current->value;
+    return probe(table->slots, table->capacity, name)->value; // NULL for an empty slot
+}
+
+void symbol_table_push_scope(SymbolTable* table) {
+    if (table->scope_count == table->scope_capacity) {
+        table->scope_capacity = table->scope_capacity ? table->scope_capacity * 2 : 8;
+        table->scopes = realloc(table->scopes, table->scope_capacity * sizeof(unsigned int));
+    }
+    table->scopes[table->scope_count++] = table->undo_count;
+}
+
+void symbol_table_pop_scope(SymbolTable* table) {
+    unsigned int mark = table->scopes[--table->scope_count];
+    // Newest first, so a name set twice in the scope ends with its value from before
+    while (table->undo_count > mark) {
+        SymbolUndo* undo = &table->undo[--table->undo_count];
+        Symbol* slot = probe(table->slots, table->capacity, undo->name);
+        if (undo->previous != NULL) {
+            slot->value = undo->previous;
+        } else {
+            remove_slot(table, slot); // Unbound before the scope
         }
-        current = current->next;
     }
-    return NULL;
 }
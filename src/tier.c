@@ -0,0 +1,216 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "tier.h"
+#include "compiler.h"
+#include "compile_pool.h"
+#include "jit_engine.h"
+
+#include <llvm-c/Orc.h>
+
+static OmniJIT* tier_jit = NULL;
+static unsigned int compiled_count = 0; // Makes every compiled symbol unique
+
+struct TierTicket {
+    int done;    // Set last by the compiler thread (release), polled by the interpreter (acquire)
+    void* entry; // NULL if the code couldn't be compiled
+    char symbol[256];
+    char entry_symbol[264];
+    OmniType* guard_types;
+
+    // A function body, or with `loop` set an OSR loop
+    AST_Expression_Identifier** parameters;
+    int parameter_count;
+    AST_Statement_Block* body;
+    AST_Statement_While* loop;
+    const char** names;
+    int count;
+};
+
+void tier_init(int opt_level, int time_passes) {
+    jit_init();
+    tier_jit = jit_create(opt_level, time_passes);
+    if (tier_jit == NULL) {
+        fprintf(stderr, "Tier: JIT unavailable, running interpreted only.\n");
+        return;
+    }
+    compile_pool_start(0);
+}
+
+void tier_shutdown() {
+    compile_pool_stop(); // Running compiles still use the JIT
+    jit_dispose(tier_jit);
+    tier_jit = NULL;
+    jit_shutdown();
+}
+
+int tier_enabled() {
+    return tier_jit != NULL;
+}
+
+// The types to speculate on, as observed in `values`; NULL for generic code.
+static OmniType* observed_types(const OmniValue* values, int count) {
+    if (values == NULL) return NULL;
+    OmniType* types = malloc((count + 1) * sizeof(OmniType));
+    for (int i = 0; i < count; i++) {
+        types[i] = values[i].type;
+    }
+    return types;
+}
+
+// --- Background Compilation ---
+
+// Runs on a compiler thread. The AST is only read, and every compile gets a
+// context of its own, so compiles run in parallel with each other and with
+// the interpreter.
+static void compile_ticket(void* data, int cancelled) {
+    TierTicket* ticket = data;
+    void* entry = NULL;
+
+    if (!cancelled) {
+        LLVMOrcThreadSafeContextRef context = LLVMOrcCreateNewThreadSafeContext();
+        LLVMContextRef llvm_context = LLVMOrcThreadSafeContextGetContext(context);
+        CompiledProgram* program = ticket->loop != NULL
+            ? compile_loop_to_llvm_ir(ticket->symbol, ticket->loop, ticket->names, ticket->guard_types,
+                                      ticket->count, llvm_context)
+            : compile_function_to_llvm_ir(ticket->symbol, ticket->parameters, ticket->parameter_count,
+                                          ticket->body, ticket->guard_types, llvm_context);
+        if (program != NULL) {
+            int failed = jit_add_module_in_context(tier_jit, program->modules[0], context);
+            program->modules[0] = NULL; // Owned by the JIT
+            compiled_program_dispose(program);
+            if (!failed) entry = jit_lookup(tier_jit, ticket->entry_symbol); // Optimizes and generates code
+        }
+        LLVMOrcDisposeThreadSafeContext(context); // The JIT's modules keep it alive
+    }
+
+    free(ticket->guard_types);
+    ticket->guard_types = NULL;
+    ticket->entry = entry;
+    __atomic_store_n(&ticket->done, 1, __ATOMIC_RELEASE);
+}
+
+static TierTicket* new_ticket(const char* prefix, const char* name) {
+    TierTicket* ticket = calloc(1, sizeof(TierTicket));
+    snprintf(ticket->symbol, sizeof(ticket->symbol), "%s.%s%s%u", prefix, name ? name : "", name ? "." : "",
+             compiled_count++);
+    return ticket;
+}
+
+int tier_ticket_poll(TierTicket* ticket, void** entry) {
+    if (!__atomic_load_n(&ticket->done, __ATOMIC_ACQUIRE)) return 0;
+    *entry = ticket->entry;
+    free(ticket);
+    return 1;
+}
+
+TierTicket* tier_compile(const char* name, AST_Expression_Identifier** parameters, int parameter_count,
+                         AST_Statement_Block* body, const OmniValue* args) {
+    if (tier_jit == NULL) return NULL;
+
+    TierTicket* ticket = new_ticket("omni.tier", name ? name : "anonymous");
+    snprintf(ticket->entry_symbol, sizeof(ticket->entry_symbol), "%s.entry", ticket->symbol);
+    ticket->guard_types = observed_types(args, parameter_count);
+    ticket->parameters = parameters;
+    ticket->parameter_count = parameter_count;
+    ticket->body = body;
+    compile_pool_submit(compile_ticket, ticket);
+    return ticket;
+}
+
+// --- On-Stack Replacement ---
+
+static void osr_add_variable(OsrLoop* osr, const char* name) {
+    for (int i = 0; i < osr->count; i++) {
+        if (osr->names[i] == name) return; // Interned
+    }
+    osr->names = realloc(osr->names, (osr->count + 1) * sizeof(const char*));
+    osr->names[osr->count++] = name;
+}
+
+// Every variable the loop reads or assigns becomes a frame slot. Call targets
+// are left out: calls go through omni_tier_call by name.
+static void osr_collect_variables(OsrLoop* osr, AST_Node* node) {
+    if (node == NULL) return;
+
+    switch (node->type) {
+        case EXPRESSION_STATEMENT:
+            osr_collect_variables(osr, (AST_Node*)((AST_Statement_Expression*)node)->expression);
+            break;
+        case SET_STATEMENT:
+        case ASSIGN_STATEMENT: {
+            AST_Statement_Set* stmt = (AST_Statement_Set*)node;
+            osr_add_variable(osr, stmt->name->value);
+            osr_collect_variables(osr, (AST_Node*)stmt->value);
+            break;
+        }
+        case BLOCK_STATEMENT: {
+            AST_Statement_Block* block = (AST_Statement_Block*)node;
+            for (int i = 0; i < block->statement_count; i++) {
+                osr_collect_variables(osr, (AST_Node*)block->statements[i]);
+            }
+            break;
+        }
+        case IF_STATEMENT: {
+            AST_Statement_If* stmt = (AST_Statement_If*)node;
+            osr_collect_variables(osr, (AST_Node*)stmt->condition);
+            osr_collect_variables(osr, (AST_Node*)stmt->consequence);
+            osr_collect_variables(osr, (AST_Node*)stmt->alternative);
+            break;
+        }
+        case WHILE_STATEMENT: {
+            AST_Statement_While* stmt = (AST_Statement_While*)node;
+            osr_collect_variables(osr, (AST_Node*)stmt->condition);
+            osr_collect_variables(osr, (AST_Node*)stmt->body);
+            break;
+        }
+        case TRY_STATEMENT: {
+            AST_Statement_Try* stmt = (AST_Statement_Try*)node;
+            osr_collect_variables(osr, (AST_Node*)stmt->body);
+            osr_collect_variables(osr, (AST_Node*)stmt->name);
+            osr_collect_variables(osr, (AST_Node*)stmt->handler);
+            break;
+        }
+        case IDENTIFIER:
+            osr_add_variable(osr, ((AST_Expression_Identifier*)node)->value);
+            break;
+        case INFIX_EXPRESSION:
+            osr_collect_variables(osr, (AST_Node*)((AST_Expression_Infix*)node)->left);
+            osr_collect_variables(osr, (AST_Node*)((AST_Expression_Infix*)node)->right);
+            break;
+        case PREFIX_EXPRESSION:
+            osr_collect_variables(osr, (AST_Node*)((AST_Expression_Prefix*)node)->right);
+            break;
+        case CALL_EXPRESSION: {
+            AST_Expression_Call* call = (AST_Expression_Call*)node;
+            if (call->function->type != IDENTIFIER) {
+                osr_collect_variables(osr, (AST_Node*)call->function);
+            }
+            for (int i = 0; i < call->argument_count; i++) {
+                osr_collect_variables(osr, (AST_Node*)call->arguments[i]);
+            }
+            break;
+        }
+        default:
+            break; // Anything else is rejected by the compiler
+    }
+}
+
+OsrLoop* tier_osr_prepare(AST_Statement_While* loop) {
+    OsrLoop* osr = calloc(1, sizeof(OsrLoop));
+    osr_collect_variables(osr, (AST_Node*)loop);
+    return osr;
+}
+
+TierTicket* tier_osr_compile(OsrLoop* osr, AST_Statement_While* loop, const OmniValue* values) {
+    if (tier_jit == NULL) return NULL;
+
+    TierTicket* ticket = new_ticket("omni.osr", NULL);
+    snprintf(ticket->entry_symbol, sizeof(ticket->entry_symbol), "%s", ticket->symbol);
+    ticket->guard_types = observed_types(values, osr->count);
+    ticket->loop = loop;
+    ticket->names = osr->names;
+    ticket->count = osr->count;
+    compile_pool_submit(compile_ticket, ticket);
+    return ticket;
+}
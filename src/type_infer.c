@@ -0,0 +1,362 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "type_infer.h"
+#include "resolver.h"
+
+// The types of the variables at one program point. Variables that aren't
+// listed are dynamic.
+typedef struct {
+    const char** names; // Interned
+    AST_StaticType* types;
+    int count;
+    int capacity;
+} TypeEnv;
+
+typedef struct {
+    int in_function;    // Only locals are tracked inside functions
+    TypeReport* report; // NULL while a loop is iterated to its fixpoint
+    AST_Program* program;
+} InferContext;
+
+static void infer_statement(AST_Node* node, TypeEnv* env, InferContext* ctx);
+static AST_StaticType infer_expression(AST_Expression* expr, TypeEnv* env, InferContext* ctx);
+
+// --- Type Environments ---
+
+static AST_StaticType env_get(const TypeEnv* env, const char* name) {
+    for (int i = 0; i < env->count; i++) {
+        if (env->names[i] == name) return env->types[i];
+    }
+    return STATIC_DYNAMIC;
+}
+
+static void env_set(TypeEnv* env, const char* name, AST_StaticType type) {
+    for (int i = 0; i < env->count; i++) {
+        if (env->names[i] == name) {
+            env->types[i] = type;
+            return;
+        }
+    }
+    if (type == STATIC_DYNAMIC) return;
+    if (env->count >= env->capacity) {
+        env->capacity = env->capacity ? env->capacity * 2 : 8;
+        env->names = realloc(env->names, env->capacity * sizeof(const char*));
+        env->types = realloc(env->types, env->capacity * sizeof(AST_StaticType));
+    }
+    env->names[env->count] = name;
+    env->types[env->count++] = type;
+}
+
+static void env_copy(TypeEnv* dest, const TypeEnv* src) {
+    dest->count = 0;
+    for (int i = 0; i < src->count; i++) {
+        env_set(dest, src->names[i], src->types[i]);
+    }
+}
+
+static void env_free(TypeEnv* env) {
+    free(env->names);
+    free(env->types);
+}
+
+// Merges the state of another path into `env`: variables keep their type
+// only if both paths agree on it.
+static void env_join(TypeEnv* env, const TypeEnv* other) {
+    for (int i = 0; i < env->count; i++) {
+        if (env_get(other, env->names[i]) != env->types[i]) {
+            env->types[i] = STATIC_DYNAMIC;
+        }
+    }
+}
+
+static int env_equal(const TypeEnv* a, const TypeEnv* b) {
+    for (int i = 0; i < a->count; i++) {
+        if (env_get(b, a->names[i]) != a->types[i]) return 0;
+    }
+    for (int i = 0; i < b->count; i++) {
+        if (env_get(a, b->names[i]) != b->types[i]) return 0;
+    }
+    return 1;
+}
+
+// --- Expressions ---
+
+static int is_numeric(AST_StaticType type) {
+    return type == STATIC_INTEGER || type == STATIC_FLOAT;
+}
+
+static int is_comparison(const char* operator) {
+    return strcmp(operator, "==") == 0 || strcmp(operator, "!=") == 0 || strcmp(operator, "<") == 0 ||
+           strcmp(operator, ">") == 0 || strcmp(operator, "<=") == 0 || strcmp(operator, ">=") == 0;
+}
+
+static int is_arithmetic(const char* operator) {
+    return strcmp(operator, "+") == 0 || strcmp(operator, "-") == 0 ||
+           strcmp(operator, "*") == 0 || strcmp(operator, "/") == 0;
+}
+
+// Mirrors eval_infix_expression: anything it doesn't handle stays dynamic.
+static AST_StaticType infer_infix(const char* operator, AST_StaticType left, AST_StaticType right) {
+    if (is_numeric(left) && is_numeric(right)) {
+        if (is_comparison(operator)) return STATIC_BOOLEAN;
+        if (is_arithmetic(operator)) {
+            return left == STATIC_INTEGER && right == STATIC_INTEGER ? STATIC_INTEGER : STATIC_FLOAT;
+        }
+    } else if (left == STATIC_STRING && right == STATIC_STRING) {
+        if (strcmp(operator, "+") == 0) return STATIC_STRING;
+        if (strcmp(operator, "==") == 0 || strcmp(operator, "!=") == 0) return STATIC_BOOLEAN;
+    }
+    return STATIC_DYNAMIC;
+}
+
+static AST_StaticType infer_identifier(AST_Expression_Identifier* ident, TypeEnv* env, InferContext* ctx) {
+    if (ctx->in_function && ident->scope != SCOPE_LOCAL) {
+        return STATIC_DYNAMIC; // Globals may change between calls, upvalues at any time
+    }
+    return env_get(env, ident->value);
+}
+
+static void infer_function(AST_Statement_Block* body, InferContext* ctx) {
+    InferContext function_ctx = { 1, ctx->report, ctx->program };
+    TypeEnv env = {0}; // Parameters are dynamic
+    infer_statement((AST_Node*)body, &env, &function_ctx);
+    env_free(&env);
+}
+
+static AST_StaticType infer_expression(AST_Expression* expr, TypeEnv* env, InferContext* ctx) {
+    if (expr == NULL) return STATIC_DYNAMIC;
+
+    AST_StaticType type = STATIC_DYNAMIC;
+    switch (expr->type) {
+        case INTEGER_LITERAL: type = STATIC_INTEGER; break;
+        case FLOAT_LITERAL: type = STATIC_FLOAT; break;
+        case BOOLEAN_LITERAL: type = STATIC_BOOLEAN; break;
+        case NIL_LITERAL: type = STATIC_NIL; break;
+        case STRING_LITERAL: type = STATIC_STRING; break;
+        case IDENTIFIER:
+            type = infer_identifier((AST_Expression_Identifier*)expr, env, ctx);
+            break;
+        case INFIX_EXPRESSION: {
+            AST_Expression_Infix* infix = (AST_Expression_Infix*)expr;
+            AST_StaticType left = infer_expression(infix->left, env, ctx);
+            AST_StaticType right = infer_expression(infix->right, env, ctx);
+            type = infer_infix(infix->operator, left, right);
+            break;
+        }
+        case PREFIX_EXPRESSION: {
+            AST_Expression_Prefix* prefix = (AST_Expression_Prefix*)expr;
+            AST_StaticType right = infer_expression(prefix->right, env, ctx);
+            if (strcmp(prefix->operator, "!") == 0) {
+                type = STATIC_BOOLEAN;
+            } else if (strcmp(prefix->operator, "-") == 0 && is_numeric(right)) {
+                type = right;
+            }
+            break;
+        }
+        case CALL_EXPRESSION: {
+            AST_Expression_Call* call = (AST_Expression_Call*)expr;
+            infer_expression(call->function, env, ctx);
+            for (int i = 0; i < call->argument_count; i++) {
+                infer_expression(call->arguments[i], env, ctx);
+            }
+            break;
+        }
+        case MEMBER_ACCESS_EXPRESSION:
+            infer_expression(((AST_Expression_MemberAccess*)expr)->object, env, ctx);
+            break;
+        case ARRAY_LITERAL: {
+            AST_Expression_ArrayLiteral* array = (AST_Expression_ArrayLiteral*)expr;
+            for (int i = 0; i < array->element_count; i++) {
+                infer_expression(array->elements[i], env, ctx);
+            }
+            break;
+        }
+        case MAP_LITERAL: {
+            AST_Expression_MapLiteral* map = (AST_Expression_MapLiteral*)expr;
+            for (int i = 0; i < map->entry_count; i++) {
+                infer_expression(map->entries[i]->key, env, ctx);
+                infer_expression(map->entries[i]->value, env, ctx);
+            }
+            break;
+        }
+        case FN_LITERAL:
+            infer_function(((AST_Expression_FnLiteral*)expr)->body, ctx);
+            break;
+        default:
+            break;
+    }
+
+    expr->static_type = type;
+    if (ctx->report != NULL) {
+        ctx->report->expression_count++;
+        if (type != STATIC_DYNAMIC) ctx->report->typed_count++;
+        ctx->report->type_counts[type]++;
+    }
+    return type;
+}
+
+// --- Statements ---
+
+// Runs a loop body from the state at the loop header until the header
+// state stops changing, then once more to record the final annotations.
+// `env` is left at the fixpoint, which is also the state after the loop.
+static void infer_loop(AST_Expression* condition, AST_Statement_Block* body, TypeEnv* env, InferContext* ctx) {
+    TypeEnv iteration = {0};
+    TypeReport* report = ctx->report;
+    ctx->report = NULL;
+    for (;;) {
+        env_copy(&iteration, env);
+        infer_expression(condition, &iteration, ctx);
+        infer_statement((AST_Node*)body, &iteration, ctx);
+        env_join(&iteration, env);
+        if (env_equal(&iteration, env)) break;
+        env_copy(env, &iteration);
+    }
+    ctx->report = report;
+
+    env_copy(&iteration, env);
+    infer_expression(condition, &iteration, ctx);
+    infer_statement((AST_Node*)body, &iteration, ctx);
+    env_free(&iteration);
+}
+
+static void infer_statement(AST_Node* node, TypeEnv* env, InferContext* ctx) {
+    if (node == NULL) return;
+
+    switch (node->type) {
+        case SET_STATEMENT:
+        case ASSIGN_STATEMENT: {
+            AST_Statement_Set* stmt = (AST_Statement_Set*)node;
+            AST_StaticType type = infer_expression(stmt->value, env, ctx);
+            if (ctx->in_function ? stmt->name->scope != SCOPE_LOCAL
+                                 : function_assigns_global(ctx->program, stmt->name->value)) {
+                type = STATIC_DYNAMIC; // Any call may assign it
+            }
+            env_set(env, stmt->name->value, type);
+            break;
+        }
+        case MEMBER_SET_STATEMENT: {
+            AST_Statement_MemberSet* stmt = (AST_Statement_MemberSet*)node;
+            infer_expression((AST_Expression*)stmt->target, env, ctx);
+            infer_expression(stmt->value, env, ctx);
+            break;
+        }
+        case RETURN_STATEMENT:
+            infer_expression(((AST_Statement_Return*)node)->return_value, env, ctx);
+            break;
+        case EXPRESSION_STATEMENT:
+            infer_expression(((AST_Statement_Expression*)node)->expression, env, ctx);
+            break;
+        case BLOCK_STATEMENT: {
+            AST_Statement_Block* block = (AST_Statement_Block*)node;
+            for (int i = 0; i < block->statement_count; i++) {
+                infer_statement((AST_Node*)block->statements[i], env, ctx);
+            }
+            break;
+        }
+        case FN_DEFINITION: {
+            AST_Statement_FnDef* fn = (AST_Statement_FnDef*)node;
+            env_set(env, fn->name->value, STATIC_DYNAMIC);
+            infer_function(fn->body, ctx);
+            break;
+        }
+        case CLASS_DEFINITION: {
+            // `set` in a class body defines an attribute, not a variable
+            AST_Statement_ClassDef* class_def = (AST_Statement_ClassDef*)node;
+            env_set(env, class_def->name->value, STATIC_DYNAMIC);
+            AST_Statement_Block* body = class_def->body;
+            for (int i = 0; body != NULL && i < body->statement_count; i++) {
+                AST_Statement* stmt = body->statements[i];
+                if (stmt != NULL && (stmt->type == SET_STATEMENT || stmt->type == ASSIGN_STATEMENT)) {
+                    infer_expression(((AST_Statement_Set*)stmt)->value, env, ctx);
+                } else {
+                    infer_statement((AST_Node*)stmt, env, ctx);
+                }
+            }
+            break;
+        }
+        case IF_STATEMENT: {
+            AST_Statement_If* stmt = (AST_Statement_If*)node;
+            infer_expression(stmt->condition, env, ctx);
+            TypeEnv alternative = {0};
+            env_copy(&alternative, env);
+            infer_statement((AST_Node*)stmt->consequence, env, ctx);
+            infer_statement((AST_Node*)stmt->alternative, &alternative, ctx);
+            env_join(env, &alternative);
+            env_free(&alternative);
+            break;
+        }
+        case WHILE_STATEMENT: {
+            AST_Statement_While* stmt = (AST_Statement_While*)node;
+            infer_loop(stmt->condition, stmt->body, env, ctx);
+            break;
+        }
+        case FOR_STATEMENT: {
+            AST_Statement_For* stmt = (AST_Statement_For*)node;
+            infer_expression(stmt->iterable, env, ctx);
+            env_set(env, stmt->iterator->value, STATIC_DYNAMIC);
+            infer_loop(NULL, stmt->body, env, ctx);
+            break;
+        }
+        case MATCH_STATEMENT: {
+            AST_Statement_Match* stmt = (AST_Statement_Match*)node;
+            infer_expression(stmt->value, env, ctx);
+            TypeEnv merged = {0};
+            env_copy(&merged, env); // No case matched
+            TypeEnv branch = {0};
+            for (int i = 0; i < stmt->case_count; i++) {
+                if (stmt->cases[i] == NULL) continue;
+                env_copy(&branch, env);
+                infer_expression(stmt->cases[i]->pattern, &branch, ctx);
+                infer_statement((AST_Node*)stmt->cases[i]->consequence, &branch, ctx);
+                env_join(&merged, &branch);
+            }
+            env_copy(env, &merged);
+            env_free(&branch);
+            env_free(&merged);
+            break;
+        }
+        case TRY_STATEMENT: {
+            // An error can leave the body after any of its assignments, so
+            // the handler knows nothing about the variables it assigns
+            AST_Statement_Try* stmt = (AST_Statement_Try*)node;
+            TypeEnv handler = {0};
+            env_copy(&handler, env);
+            for (int i = 0; i < handler.count; i++) {
+                if (statement_binds((AST_Statement*)stmt->body, handler.names[i])) {
+                    handler.types[i] = STATIC_DYNAMIC;
+                }
+            }
+            infer_statement((AST_Node*)stmt->body, env, ctx);
+            if (stmt->name != NULL) env_set(&handler, stmt->name->value, STATIC_STRING);
+            infer_statement((AST_Node*)stmt->handler, &handler, ctx);
+            env_join(env, &handler);
+            env_free(&handler);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void infer_types(AST_Program* program, TypeReport* report) {
+    if (report != NULL) memset(report, 0, sizeof(TypeReport));
+    InferContext ctx = { 0, report, program };
+    TypeEnv env = {0};
+    for (int i = 0; i < program->statement_count; i++) {
+        infer_statement((AST_Node*)program->statements[i], &env, &ctx);
+    }
+    env_free(&env);
+}
+
+void print_type_report(const TypeReport* report) {
+    static const char* type_names[STATIC_TYPE_COUNT] = { "dynamic", "integer", "float", "boolean", "nil", "string" };
+    double percent = report->expression_count ? 100.0 * report->typed_count / report->expression_count : 0.0;
+    printf("Types: %d of %d expressions typed statically (%.1f%%)\n",
+           report->typed_count, report->expression_count, percent);
+    for (int i = 0; i < STATIC_TYPE_COUNT; i++) {
+        if (report->type_counts[i] > 0) printf("  %-8s %d\n", type_names[i], report->type_counts[i]);
+    }
+}